@@ -0,0 +1,24 @@
+#pragma once
+#include "../../ComLightLib/comLightCommon.h"
+
+namespace Cgml
+{
+	// A sequence of compute shader commands recorded by iContext.beginRecording / endRecording methods
+	struct DECLSPEC_NOVTABLE iCommandList : public ComLight::IUnknown
+	{
+		DEFINE_INTERFACE_ID( "1e3d5734-a934-43f2-9964-2b2aeadff674" );
+
+		// Count of the recorded bindShader and dispatch calls
+		virtual HRESULT COMLIGHTCALL getSize( int& countShaders, int& countDispatches ) const = 0;
+
+		// Replace constant buffer data of the bindShader call #index
+		// The size of the new data must be equal to the size of the recorded data
+		virtual HRESULT COMLIGHTCALL patchConstants( int index, const uint8_t* constantBufferData, int cbSize ) = 0;
+
+		// Replace count of thread groups of the dispatch call #index
+		virtual HRESULT COMLIGHTCALL patchDispatch( int index, int groupsX, int groupsY, int groupsZ ) = 0;
+
+		// Shader ID of the bindShader call #index, and index of the first dispatch call recorded after it, or -1 when there are none
+		virtual HRESULT COMLIGHTCALL getShader( int index, uint16_t& id, int& dispatch ) const = 0;
+	};
+}
\ No newline at end of file
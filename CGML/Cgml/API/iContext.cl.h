@@ -1,5 +1,6 @@
 #pragma once
 #include "iTensor.cl.h"
+#include "iCommandList.cl.h"
 #include "profiler.h"
 #include "../../ComLightLib/streams.h"
 #include "eDownloadFlag.h"
@@ -35,5 +36,39 @@ namespace Cgml
 		virtual HRESULT COMLIGHTCALL createComputeShaders( int count, const std::pair<int, int>* blobs, const uint8_t* data, int dataSize ) = 0;
 
 		virtual HRESULT COMLIGHTCALL writeTensorData( iTensor* tensor, ComLight::iWriteStream* stream ) = 0;
+
+		// Start recording bindShader, bindTensors, unbindInputs, dispatch and profiler block calls into a command list, instead of executing them
+		virtual HRESULT COMLIGHTCALL beginRecording() = 0;
+
+		// Stop recording, and return the recorded commands
+		virtual HRESULT COMLIGHTCALL endRecording( iCommandList** pp ) = 0;
+
+		// Execute the recorded commands
+		virtual HRESULT COMLIGHTCALL replay( iCommandList* commands ) = 0;
+
+		// Compute percentiles of the profiler measures; when reset is non-zero, all measures are reset after the snapshot
+		virtual HRESULT COMLIGHTCALL profilerGetPercentiles( const float* percentiles, int count, pfnProfilerPercentiles pfn, void* pv, uint8_t reset ) = 0;
+
+		// Drop the captured timeline, and start capturing the last `capacity` profiler events. Zero capacity stops the capture.
+		virtual HRESULT COMLIGHTCALL profilerCaptureTimeline( uint32_t capacity ) = 0;
+
+		// Produce the captured timeline of the profiler events
+		virtual HRESULT COMLIGHTCALL profilerGetTimeline( pfnProfilerEvents pfn, void* pv ) = 0;
+
+		// Copy elements [ begin .. end ) of the dense source tensor into the same elements of the destination tensor using the GPU
+		virtual HRESULT COMLIGHTCALL copyRange( iTensor* destination, iTensor* source, uint32_t begin, uint32_t end ) = 0;
+
+		// Insert a fence into the GPU command queue, and return the ID of that fence
+		virtual HRESULT COMLIGHTCALL fenceSignal( uint64_t& fence ) = 0;
+
+		// Check whether the GPU has completed all commands submitted before the fence; when wait is non-zero, block the calling thread until it does
+		// Polls and recycles event queries on the immediate context, not thread safe like the rest of this interface
+		virtual HRESULT COMLIGHTCALL fenceCheck( uint64_t fence, uint8_t wait, uint8_t& complete ) = 0;
+
+		// Download elements [ 0 .. length ) of the dense tensor, compress them with LZ4 in parallel chunks, and write to the stream
+		virtual HRESULT COMLIGHTCALL saveCompressed( iTensor* tensor, uint32_t length, ComLight::iWriteStream* stream ) = 0;
+
+		// Read the data written by saveCompressed, decompress in parallel, and upload into elements [ 0 .. length ) of the dense tensor
+		virtual HRESULT COMLIGHTCALL loadCompressed( iTensor* tensor, uint32_t length, ComLight::iReadStream* stream ) = 0;
 	};
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "sDeviceInfo.h"
 #include "iContext.cl.h"
 #include "iSentencePiece.cl.h"
+#include "sGptqTensor.h"
 
 namespace Cgml
 {
@@ -27,6 +28,10 @@ namespace Cgml
 		virtual HRESULT getDeviceInfo( sDeviceInfo& rdi ) = 0;
 
 		virtual HRESULT loadSentencePieceModel( SentencePiece::iProcessor** pp, ComLight::iReadStream* stream, uint32_t length ) = 0;
+
+		virtual HRESULT uploadQuantizedTensor( iTensor** pp, const sTensorDesc& desc, eGgmlType type, const void* rsi, uint32_t length ) = 0;
+
+		virtual HRESULT reshapeGptq( uint32_t* rdi, uint32_t length, const sGptqTensor& source, eGptqCodec codec ) = 0;
 	};
 
 	HRESULT COMLIGHTCALL listGPUs( pfnListAdapters pfn, void* pv );
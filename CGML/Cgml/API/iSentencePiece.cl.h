@@ -12,6 +12,20 @@ namespace SentencePiece
 		int idPad;
 	};
 
+	// Stateful decoder which accepts one token at a time, and returns the newly completed UTF-8 text
+	struct DECLSPEC_NOVTABLE iStreamingDecoder : public ComLight::IUnknown
+	{
+		DEFINE_INTERFACE_ID( "5002cf75-f364-449f-ad04-b469c468de87" );
+
+		// Decode one more token. The output is valid until the next call, and only contains complete UTF-8 characters:
+		// byte-fallback pieces are held until they form a complete character.
+		virtual HRESULT COMLIGHTCALL push( int token, const char** text, int& length ) = 0;
+		// Finish the sequence, replace the incomplete UTF-8 sequence at the end, if any, with U+FFFD characters
+		virtual HRESULT COMLIGHTCALL flush( const char** text, int& length ) = 0;
+		// Reset the state, the next token is decoded as the start of a new sequence
+		virtual HRESULT COMLIGHTCALL reset() = 0;
+	};
+
 	// A sane API of the Google’s SentencePiece C++ library
 	struct DECLSPEC_NOVTABLE iProcessor : public ComLight::IUnknown
 	{
@@ -20,6 +34,22 @@ namespace SentencePiece
 		virtual HRESULT COMLIGHTCALL encode( const char* input, const int** tokens, int& length ) = 0;
 		virtual HRESULT COMLIGHTCALL decode( const int* tokens, int count, const char** str ) = 0;
 		virtual HRESULT COMLIGHTCALL getInfo( sProcessorInfo& rdi ) const = 0;
+
+		// Encode count strings on the thread pool. offsets receives count + 1 integers, tokens of the string #i are in [ offsets[ i ] .. offsets[ i + 1 ] ) slice of the output.
+		// When the capacity is too small for offsets[ count ] tokens, the method only writes these offsets, and leaves the tokens buffer unchanged.
+		// Unlike encode and decode methods, the batch ones don't use memory owned by the object, and can be called concurrently from multiple threads.
+		virtual HRESULT COMLIGHTCALL encodeBatch( const char* const* inputs, int count, int* tokens, int capacity, int* offsets ) const = 0;
+
+		// Decode count sequences of tokens on the thread pool, sequence #i is in [ offsets[ i ] .. offsets[ i + 1 ] ) slice of the tokens.
+		// The output is a flat buffer of UTF-8 bytes without null terminators; textOffsets receives count + 1 integers, with the same capacity semantics as encodeBatch.
+		virtual HRESULT COMLIGHTCALL decodeBatch( const int* tokens, const int* offsets, int count, char* text, int capacity, int* textOffsets ) const = 0;
+
+		// Create a decoder to stream the output of the model, the processor doesn't need to outlive the decoder
+		virtual HRESULT COMLIGHTCALL createStreamingDecoder( iStreamingDecoder** pp ) = 0;
+
+		// Enable or disable the SIMD fast path of identity normalizers, it's enabled by default.
+		// The tokens are the same either way, disable it to test the fast path against the generic normalizer.
+		virtual HRESULT COMLIGHTCALL setNormalizerFastPath( uint8_t enabled ) = 0;
 	};
 
 	HRESULT loadSentencePieceModel( iProcessor** result, ComLight::iReadStream* stream, uint32_t length );
@@ -38,4 +38,22 @@ namespace Cgml
 	};
 
 	using pfnProfilerData = HRESULT( __stdcall* )( const ProfilerResult* data, uint32_t length, void* pv );
+
+	// The percentiles are expressed in 100-nanosecond ticks, the array has length * count of requested percentiles elements.
+	// The first row of the array contains the requested percentiles of data[ 0 ], the next row is for data[ 1 ], etc.
+	using pfnProfilerPercentiles = HRESULT( __stdcall* )( const ProfilerResult* data, const uint64_t* percentiles, uint32_t length, void* pv );
+
+	// A single event of the timeline captured by the profiler
+	struct ProfilerEvent
+	{
+		// Start and end time in 100-nanosecond ticks, relative to the first captured event
+		uint64_t start, end;
+		eProfilerMeasure what;
+		// Nesting level, 0 for top-level blocks
+		uint8_t depth;
+		uint16_t id;
+	};
+
+	// The events are ordered by their completion time
+	using pfnProfilerEvents = HRESULT( __stdcall* )( const ProfilerEvent* data, uint32_t length, void* pv );
 }
\ No newline at end of file
@@ -9,6 +9,8 @@ namespace Cgml
 		uint8_t flags;
 
 		static const uint8_t FLAG_POWERSAVER = 1;
+		// Measure wall clock time on the CPU instead of GPU timestamp queries
+		static const uint8_t FLAG_CPU_PROFILER = 2;
 	};
 
 	using pfnListAdapters = void( __stdcall* )( const wchar_t* name, void* pv );
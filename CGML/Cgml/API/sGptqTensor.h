@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+
+namespace Cgml
+{
+	// Output format for GPTQ matrices reshaped into panels
+	enum struct eGptqCodec : uint8_t
+	{
+		// FP32 scales, one column of them per 128 elements
+		BCML3 = 3,
+		// FP16 scales, two of them packed in a column per 256 elements
+		BCML4 = 4,
+	};
+
+	// GPTQ-quantized matrix in system memory, 4 bits per weight, 128 weights per quantization group
+	struct sGptqTensor
+	{
+		// rowLengthIntegers lines of rows integers, each uint32_t contains 8 consecutive 4-bit weights of a row
+		const uint32_t* qweight;
+		// ( rowLengthIntegers + 15 ) / 16 lines of rows scales, FP32 for BCML3 or FP16 for BCML4
+		const void* scales;
+		// ( rowLengthIntegers + 15 ) / 16 lines of ( rows + 7 ) / 8 integers, each uint32_t contains zero points of 8 consecutive rows
+		const uint32_t* qzeros;
+		// Count of rows in the output matrix
+		uint32_t rows;
+		// Length of rows in the output matrix, divided by 8
+		uint32_t rowLengthIntegers;
+	};
+}
\ No newline at end of file
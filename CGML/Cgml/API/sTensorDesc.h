@@ -65,5 +65,20 @@ namespace Cgml
 		Fp16MakeIeee = 1,
 		// Convert FP32 numbers into IEEE FP16
 		Fp32DowncastIeee = 2,
+		// Convert FP32 numbers into BF16, rounding to nearest even
+		Fp32DowncastBf16 = 3,
+		// Convert FP16 or BF16 numbers into FP32
+		Fp16Upcast = 4,
+	};
+
+	// Block-quantized formats of llama.cpp tensors, the values match ggml_type enum in ggml.h
+	enum struct eGgmlType: uint8_t
+	{
+		// 32 elements => FP16 scale + 16 bytes with 4-bit weights
+		Q4_0 = 2,
+		// 32 elements => FP16 scale + FP16 offset + 16 bytes with 4-bit weights
+		Q4_1 = 3,
+		// 32 elements => FP16 scale + 32 bytes with 8-bit weights
+		Q8_0 = 8,
 	};
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "stdafx.h"
+#include "CommandList.h"
+#include <algorithm>
+using namespace Cgml;
+
+static_assert( sizeof( CComPtr<iTensor> ) == sizeof( iTensor* ), "Context::replay passes the tensors vector as iTensor** array" );
+
+HRESULT COMLIGHTCALL CommandList::getSize( int& countShaders, int& countDispatches ) const noexcept
+{
+	countShaders = (int)constantSlices.size();
+	countDispatches = (int)dispatchCommands.size();
+	return S_OK;
+}
+
+HRESULT COMLIGHTCALL CommandList::patchConstants( int index, const uint8_t* constantBufferData, int cbSize ) noexcept
+{
+	if( index < 0 || index >= (int)constantSlices.size() )
+		return E_BOUNDS;
+	const auto slice = constantSlices[ index ];
+	if( cbSize != (int)slice.second )
+	{
+		logError( u8"Constant buffer size mismatch, recorded %i bytes, patching %i", (int)slice.second, cbSize );
+		return E_INVALIDARG;
+	}
+	if( cbSize == 0 )
+		return S_FALSE;
+	if( nullptr == constantBufferData )
+		return E_POINTER;
+
+	memcpy( &constants[ slice.first ], constantBufferData, (size_t)cbSize );
+	return S_OK;
+}
+
+namespace
+{
+	HRESULT validateDispatch( int groupsX, int groupsY, int groupsZ )
+	{
+		constexpr int max = D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION;
+		if( groupsX <= 0 || groupsY <= 0 || groupsZ <= 0 ||
+			groupsX > max || groupsY > max || groupsZ > max )
+			return E_INVALIDARG;
+		return S_OK;
+	}
+}
+
+HRESULT COMLIGHTCALL CommandList::patchDispatch( int index, int groupsX, int groupsY, int groupsZ ) noexcept
+{
+	if( index < 0 || index >= (int)dispatchCommands.size() )
+		return E_BOUNDS;
+	CHECK( validateDispatch( groupsX, groupsY, groupsZ ) );
+
+	Command& cmd = commands[ dispatchCommands[ index ] ];
+	cmd.args = { (uint32_t)groupsX, (uint32_t)groupsY, (uint32_t)groupsZ };
+	return S_OK;
+}
+
+HRESULT COMLIGHTCALL CommandList::getShader( int index, uint16_t& id, int& dispatch ) const noexcept
+{
+	if( index < 0 || index >= (int)shaderCommands.size() )
+		return E_BOUNDS;
+	const uint32_t cmd = shaderCommands[ index ];
+	id = commands[ cmd ].id;
+
+	// Both vectors are sorted, find the first dispatch after the command
+	auto it = std::upper_bound( dispatchCommands.begin(), dispatchCommands.end(), cmd );
+	dispatch = ( it != dispatchCommands.end() ) ? (int)( it - dispatchCommands.begin() ) : -1;
+	return S_OK;
+}
+
+HRESULT CommandList::bindShader( uint16_t id, const uint8_t* constantBufferData, int cbSize )
+{
+	try
+	{
+		const size_t off = constants.size();
+		if( cbSize > 0 )
+			constants.insert( constants.end(), constantBufferData, constantBufferData + cbSize );
+		const uint32_t index = (uint32_t)constantSlices.size();
+		constantSlices.emplace_back( (uint32_t)off, (uint32_t)cbSize );
+		shaderCommands.push_back( (uint32_t)commands.size() );
+		commands.push_back( Command{ eCommand::BindShader, id, { index, 0, 0 } } );
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT CommandList::dispatch( int groupsX, int groupsY, int groupsZ )
+{
+	CHECK( validateDispatch( groupsX, groupsY, groupsZ ) );
+	try
+	{
+		dispatchCommands.push_back( (uint32_t)commands.size() );
+		commands.push_back( Command{ eCommand::Dispatch, 0, { (uint32_t)groupsX, (uint32_t)groupsY, (uint32_t)groupsZ } } );
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT CommandList::bindTensors( iTensor** arr, int countWrite, int countRead )
+{
+	try
+	{
+		const size_t off = tensors.size();
+		const size_t count = (size_t)countWrite + (size_t)countRead;
+		for( size_t i = 0; i < count; i++ )
+			tensors.emplace_back( arr[ i ] );
+		commands.push_back( Command{ eCommand::BindTensors, 0, { (uint32_t)off, (uint32_t)countWrite, (uint32_t)countRead } } );
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT CommandList::unbindInputs()
+{
+	try
+	{
+		commands.push_back( Command{ eCommand::UnbindInputs, 0, {} } );
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT CommandList::profilerBlockStart( uint16_t id )
+{
+	try
+	{
+		commands.push_back( Command{ eCommand::ProfilerBlockStart, id, {} } );
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT CommandList::profilerBlockEnd()
+{
+	try
+	{
+		commands.push_back( Command{ eCommand::ProfilerBlockEnd, 0, {} } );
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include "../API/iCommandList.cl.h"
+#include "../API/iTensor.cl.h"
+#include "../../ComLightLib/comLightServer.h"
+
+namespace Cgml
+{
+	class Context;
+
+	// Commands recorded by the context, replayed by Context::replay method
+	class CommandList : public ComLight::ObjectRoot<iCommandList>
+	{
+		friend class Context;
+
+		enum struct eCommand : uint8_t
+		{
+			BindShader,
+			Dispatch,
+			BindTensors,
+			UnbindInputs,
+			ProfilerBlockStart,
+			ProfilerBlockEnd,
+		};
+
+		struct Command
+		{
+			eCommand op;
+			// Shader ID for BindShader, block ID for ProfilerBlockStart
+			uint16_t id;
+			// BindShader: index in the constantSlices vector
+			// Dispatch: count of thread groups
+			// BindTensors: offset in the tensors vector, count of outputs, count of inputs
+			std::array<uint32_t, 3> args;
+		};
+
+		std::vector<Command> commands;
+		std::vector<uint8_t> constants;
+		// [ offset, size ] of the constant buffers in the constants vector, one entry per BindShader command
+		std::vector<std::pair<uint32_t, uint32_t>> constantSlices;
+		// The list retains references to the bound tensors
+		std::vector<CComPtr<iTensor>> tensors;
+		// Indices in the commands vector of the Dispatch commands, for patchDispatch method
+		std::vector<uint32_t> dispatchCommands;
+		// Indices in the commands vector of the BindShader commands, for getShader method
+		std::vector<uint32_t> shaderCommands;
+
+		HRESULT COMLIGHTCALL getSize( int& countShaders, int& countDispatches ) const noexcept override final;
+		HRESULT COMLIGHTCALL patchConstants( int index, const uint8_t* constantBufferData, int cbSize ) noexcept override final;
+		HRESULT COMLIGHTCALL patchDispatch( int index, int groupsX, int groupsY, int groupsZ ) noexcept override final;
+		HRESULT COMLIGHTCALL getShader( int index, uint16_t& id, int& dispatch ) const noexcept override final;
+
+	public:
+		HRESULT bindShader( uint16_t id, const uint8_t* constantBufferData, int cbSize );
+		HRESULT dispatch( int groupsX, int groupsY, int groupsZ );
+		HRESULT bindTensors( iTensor** arr, int countWrite, int countRead );
+		HRESULT unbindInputs();
+		HRESULT profilerBlockStart( uint16_t id );
+		HRESULT profilerBlockEnd();
+	};
+}
\ No newline at end of file
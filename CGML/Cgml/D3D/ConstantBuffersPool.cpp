@@ -3,11 +3,86 @@
 #include "../../ComLightLib/hresult.h"
 #include <ammintrin.h>
 
+namespace
+{
+	// 1MB of constants, that's a few complete decode steps of a 7B model
+	constexpr uint32_t ringBytes = 1u << 20;
+	// CSSetConstantBuffers1 wants offsets and sizes in multiples of 16 constants, 16 bytes each
+	constexpr uint32_t ringAlignment = 256;
+	// Shaders can only access that many bytes of the bound constant buffer
+	constexpr uint32_t maxBufferBytes = D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16;
+
+	inline uint32_t alignRing( uint32_t cb )
+	{
+		return ( cb + ringAlignment - 1 ) & ~( ringAlignment - 1 );
+	}
+}
+
 ConstantBuffersPool::ConstantBuffersPool( size_t maxVectors )
 {
 	pool.resize( maxVectors + 1 );
 }
 
+HRESULT ConstantBuffersPool::initialize( ID3D11Device* dev, ID3D11DeviceContext* ctx )
+{
+	initialized = true;
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+	HRESULT hr = dev->CheckFeatureSupport( D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof( options ) );
+	if( FAILED( hr ) || !options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer )
+		return S_FALSE;
+
+	hr = ctx->QueryInterface( &context1 );
+	if( FAILED( hr ) )
+		return S_FALSE;
+
+	CD3D11_BUFFER_DESC desc{ ringBytes, D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE };
+	hr = dev->CreateBuffer( &desc, nullptr, &ring );
+	if( FAILED( hr ) )
+	{
+		logWarningHr( hr, u8"Unable to create the ring buffer for constants, using a pool of constant buffers instead" );
+		context1 = nullptr;
+		return S_FALSE;
+	}
+
+	// The first Map call needs to discard the buffer
+	ringOffset = ringBytes;
+	return S_OK;
+}
+
+HRESULT ConstantBuffersPool::mapRing( ID3D11DeviceContext* ctx, uint32_t cb, uint8_t*& mapped, uint32_t& offset )
+{
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if( ringOffset + cb > ringBytes )
+	{
+		// Wrapped around: the runtime renames the buffer, the GPU keeps reading the old version
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		ringOffset = 0;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE ms;
+	CHECK( ctx->Map( ring, 0, mapType, 0, &ms ) );
+	offset = ringOffset;
+	mapped = (uint8_t*)ms.pData + ringOffset;
+	ringOffset += cb;
+	return S_OK;
+}
+
+void ConstantBuffersPool::bindUploaded( uint32_t offset, uint32_t cbSize )
+{
+	if( 0 == cbSize )
+	{
+		ID3D11Buffer* const nullBuffer = nullptr;
+		context1->CSSetConstantBuffers( 0, 1, &nullBuffer );
+		return;
+	}
+
+	ID3D11Buffer* const buffer = ring;
+	const UINT firstConstant = offset / 16;
+	const UINT numConstants = alignRing( cbSize ) / 16;
+	context1->CSSetConstantBuffers1( 0, 1, &buffer, &firstConstant, &numConstants );
+}
+
 static HRESULT __declspec( noinline ) createConstantBuffer( ID3D11Device* dev, CComPtr<ID3D11Buffer>& rdi, const uint8_t* constantBufferData, const uint32_t cbSize )
 {
 	const uint32_t bufferSize = _andn_u32( 15, cbSize + 15 );
@@ -23,7 +98,7 @@ static HRESULT __declspec( noinline ) createConstantBuffer( ID3D11Device* dev, C
 	return S_OK;
 }
 
-HRESULT ConstantBuffersPool::updateAndBind( ID3D11Device* dev, ID3D11DeviceContext* ctx, const uint8_t* constantBufferData, int cbSize )
+HRESULT ConstantBuffersPool::updateAndBindPool( ID3D11Device* dev, ID3D11DeviceContext* ctx, const uint8_t* constantBufferData, int cbSize )
 {
 	const int cbSizeVectors = ( cbSize + 15 ) / 16;
 	if( cbSizeVectors < 0 || cbSizeVectors >= pool.size() )
@@ -46,4 +121,64 @@ HRESULT ConstantBuffersPool::updateAndBind( ID3D11Device* dev, ID3D11DeviceConte
 
 	ctx->CSSetConstantBuffers( 0, 1, &buffer );
 	return S_OK;
+}
+
+HRESULT ConstantBuffersPool::updateAndBind( ID3D11Device* dev, ID3D11DeviceContext* ctx, const uint8_t* constantBufferData, int cbSize )
+{
+	if( !initialized )
+		CHECK( initialize( dev, ctx ) );
+	if( !ring )
+		return updateAndBindPool( dev, ctx, constantBufferData, cbSize );
+
+	if( cbSize < 0 || (uint32_t)cbSize > maxBufferBytes )
+		return E_BOUNDS;
+
+	uint32_t offset = 0;
+	if( cbSize > 0 )
+	{
+		uint8_t* rdi;
+		CHECK( mapRing( ctx, alignRing( (uint32_t)cbSize ), rdi, offset ) );
+		__movsb( rdi, constantBufferData, (size_t)cbSize );
+		ctx->Unmap( ring, 0 );
+	}
+	bindUploaded( offset, (uint32_t)cbSize );
+	return S_OK;
+}
+
+HRESULT ConstantBuffersPool::uploadBatch( ID3D11Device* dev, ID3D11DeviceContext* ctx, const uint8_t* data, const std::pair<uint32_t, uint32_t>* slices, size_t count, uint32_t* offsets )
+{
+	if( !initialized )
+		CHECK( initialize( dev, ctx ) );
+	if( !ring )
+		return S_FALSE;
+
+	size_t total = 0;
+	for( size_t i = 0; i < count; i++ )
+	{
+		const uint32_t cb = slices[ i ].second;
+		if( cb > maxBufferBytes )
+			return S_FALSE;
+		total += alignRing( cb );
+	}
+	if( total > ringBytes )
+		return S_FALSE;
+	if( 0 == total )
+	{
+		std::fill_n( offsets, count, 0u );
+		return S_OK;
+	}
+
+	uint8_t* rdi;
+	uint32_t base;
+	CHECK( mapRing( ctx, (uint32_t)total, rdi, base ) );
+	uint32_t off = 0;
+	for( size_t i = 0; i < count; i++ )
+	{
+		const uint32_t cb = slices[ i ].second;
+		__movsb( rdi + off, data + slices[ i ].first, cb );
+		offsets[ i ] = base + off;
+		off += alignRing( cb );
+	}
+	ctx->Unmap( ring, 0 );
+	return S_OK;
 }
\ No newline at end of file
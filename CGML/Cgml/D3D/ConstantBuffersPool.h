@@ -1,14 +1,38 @@
 #pragma once
+#include <d3d11_1.h>
 
-// Implements a small pool of dynamic constant buffers of varying sizes.
-// The buffers are created on-demand.
+// Implements constant buffers for the compute shaders.
+// When the runtime supports D3D 11.1 constant buffer offsets, all constants are written into a single large ring buffer,
+// the shaders see 256-byte aligned slices of it, bound with CSSetConstantBuffers1. Updates use D3D11_MAP_WRITE_NO_OVERWRITE until the ring wraps around.
+// Otherwise, falls back to a small pool of dynamic constant buffers of varying sizes, created on-demand.
 class ConstantBuffersPool
 {
 	std::vector<CComPtr<ID3D11Buffer>> pool;
 
+	CComPtr<ID3D11DeviceContext1> context1;
+	CComPtr<ID3D11Buffer> ring;
+	// Offset in the ring buffer where the next constants go, in bytes
+	uint32_t ringOffset = 0;
+	bool initialized = false;
+
+	HRESULT initialize( ID3D11Device* dev, ID3D11DeviceContext* ctx );
+
+	// Reserve the space in the ring buffer, map it, and return the offset of the reserved slice
+	HRESULT mapRing( ID3D11DeviceContext* ctx, uint32_t cb, uint8_t*& mapped, uint32_t& offset );
+
+	HRESULT updateAndBindPool( ID3D11Device* dev, ID3D11DeviceContext* ctx, const uint8_t* constantBufferData, int cbSize );
+
 public:
 	ConstantBuffersPool( size_t maxVectors = 8 );
 	~ConstantBuffersPool() = default;
 
 	HRESULT updateAndBind( ID3D11Device* dev, ID3D11DeviceContext* ctx, const uint8_t* constantBufferData, int cbSize );
+
+	// Copy many constant buffers into the ring with a single Map call; slices are [ offset, size ] pairs relative to the data pointer.
+	// On success, writes ring offsets of the slices to the output array, use bindUploaded method to bind them.
+	// Returns S_FALSE when the ring buffer is not supported, or the batch is too large; the caller should use updateAndBind instead.
+	HRESULT uploadBatch( ID3D11Device* dev, ID3D11DeviceContext* ctx, const uint8_t* data, const std::pair<uint32_t, uint32_t>* slices, size_t count, uint32_t* offsets );
+
+	// Bind a slice of the ring buffer, written by the last uploadBatch call
+	void bindUploaded( uint32_t offset, uint32_t cbSize );
 };
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "stdafx.h"
+#include "Context.h"
+#include "Tensor.h"
+#include "tensorUtils.h"
+#include "../Utils/parallelFor.h"
+#include <Utils/LZ4/lz4.h>
+using namespace Cgml;
+
+namespace
+{
+	// Uncompressed size of the chunks, the chunks are compressed and decompressed in parallel
+	constexpr uint32_t chunkBytes = 1u << 20;
+
+	// Header of the compressed payload, followed by uint32_t compressed sizes of the chunks, and then the compressed chunks
+	struct sCompressedHeader
+	{
+		uint32_t bytes;
+		uint32_t chunkBytes;
+		uint32_t countChunks;
+	};
+
+	inline uint32_t countChunks( uint32_t bytes, uint32_t chunk )
+	{
+		return ( bytes + chunk - 1 ) / chunk;
+	}
+
+	inline uint32_t chunkLength( uint32_t bytes, uint32_t chunk, size_t i )
+	{
+		const size_t begin = i * chunk;
+		return (uint32_t)std::min( (size_t)chunk, bytes - begin );
+	}
+
+	HRESULT getBuffer( Tensor* tensor, uint32_t length, CComPtr<ID3D11Buffer>& buffer, uint32_t& bytes, const char* what )
+	{
+		const sTensorDesc& desc = tensor->getDesc();
+		if( desc.layout != eTensorLayout::Dense )
+		{
+			logError( u8"iContext.%s only supports dense tensors", what );
+			return E_INVALIDARG;
+		}
+		if( length > desc.shape.countElements() )
+		{
+			logError( u8"iContext.%s: length %u exceeds the size of the tensor", what, length );
+			return E_BOUNDS;
+		}
+
+		const size_t cb = (size_t)length * bytesPerElement( desc.dataType );
+		if( cb > INT_MAX )
+			return DISP_E_OVERFLOW;
+		bytes = (uint32_t)cb;
+
+		ID3D11ShaderResourceView* const srv = tensor->readView();
+		if( nullptr == srv )
+			return OLE_E_BLANK;
+		CComPtr<ID3D11Resource> resource;
+		srv->GetResource( &resource );
+		return resource.QueryInterface( &buffer );
+	}
+
+	inline D3D11_BOX prefixBox( uint32_t bytes )
+	{
+		D3D11_BOX box;
+		box.left = 0;
+		box.right = bytes;
+		box.top = 0;
+		box.bottom = 1;
+		box.front = 0;
+		box.back = 1;
+		return box;
+	}
+}
+
+HRESULT COMLIGHTCALL Context::saveCompressed( iTensor* tensor, uint32_t length, ComLight::iWriteStream* stream ) noexcept
+{
+	if( nullptr == tensor || nullptr == stream )
+		return E_POINTER;
+	CHECK( checkNotRecording( "saveCompressed" ) );
+
+	CComPtr<ID3D11Buffer> buffer;
+	sCompressedHeader header;
+	CHECK( getBuffer( static_cast<Tensor*>( tensor ), length, buffer, header.bytes, "saveCompressed" ) );
+	header.chunkBytes = chunkBytes;
+	header.countChunks = countChunks( header.bytes, chunkBytes );
+	if( 0 == header.bytes )
+		return stream->write( &header, sizeof( header ) );
+
+	const uint32_t bound = (uint32_t)LZ4_compressBound( (int)chunkBytes );
+	std::vector<uint32_t> sizes;
+	std::vector<uint8_t> compressed;
+	try
+	{
+		sizes.resize( header.countChunks );
+		compressed.resize( (size_t)bound * header.countChunks );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	CD3D11_BUFFER_DESC stagingDesc{ header.bytes, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ };
+	CComPtr<ID3D11Buffer> staging;
+	CHECK( device->CreateBuffer( &stagingDesc, nullptr, &staging ) );
+	const D3D11_BOX box = prefixBox( header.bytes );
+	context->CopySubresourceRegion( staging, 0, 0, 0, 0, buffer, 0, &box );
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	CHECK( context->Map( staging, 0, D3D11_MAP_READ, 0, &mapped ) );
+	const uint8_t* const rsi = (const uint8_t*)mapped.pData;
+
+	auto compress = [&]( size_t i ) -> HRESULT
+	{
+		const uint32_t len = chunkLength( header.bytes, chunkBytes, i );
+		const int cb = LZ4_compress_default( (const char*)rsi + i * chunkBytes, (char*)compressed.data() + i * bound, (int)len, (int)bound );
+		if( cb <= 0 )
+		{
+			logError( u8"LZ4_compress_default failed with status %i", cb );
+			return PLA_E_CABAPI_FAILURE;
+		}
+		sizes[ i ] = (uint32_t)cb;
+		return S_OK;
+	};
+	const HRESULT hr = parallelFor( header.countChunks, compress );
+	context->Unmap( staging, 0 );
+	CHECK( hr );
+
+	CHECK( stream->write( &header, sizeof( header ) ) );
+	CHECK( stream->write( sizes ) );
+	for( size_t i = 0; i < header.countChunks; i++ )
+		CHECK( stream->write( compressed.data() + i * bound, (int)sizes[ i ] ) );
+	return S_OK;
+}
+
+HRESULT COMLIGHTCALL Context::loadCompressed( iTensor* tensor, uint32_t length, ComLight::iReadStream* stream ) noexcept
+{
+	if( nullptr == tensor || nullptr == stream )
+		return E_POINTER;
+	CHECK( checkNotRecording( "loadCompressed" ) );
+
+	Tensor* tensorBase = static_cast<Tensor*>( tensor );
+	if( tensorBase->getDesc().usage == eBufferUse::Immutable )
+	{
+		logError( u8"iContext.loadCompressed asked to write into an immutable tensor" );
+		return E_INVALIDARG;
+	}
+
+	CComPtr<ID3D11Buffer> buffer;
+	uint32_t bytes;
+	CHECK( getBuffer( tensorBase, length, buffer, bytes, "loadCompressed" ) );
+
+	sCompressedHeader header;
+	CHECK( stream->read( &header, sizeof( header ) ) );
+	if( header.bytes != bytes || 0 == header.chunkBytes || header.chunkBytes > LZ4_MAX_INPUT_SIZE ||
+		header.countChunks != countChunks( header.bytes, header.chunkBytes ) )
+	{
+		logError( u8"iContext.loadCompressed: the compressed data doesn't match the tensor" );
+		return E_INVALIDARG;
+	}
+	if( 0 == bytes )
+		return S_OK;
+
+	std::vector<uint32_t> sizes;
+	std::vector<size_t> offsets;
+	std::vector<uint8_t> compressed;
+	try
+	{
+		sizes.resize( header.countChunks );
+		CHECK( stream->read( sizes ) );
+
+		const uint32_t bound = (uint32_t)LZ4_compressBound( (int)header.chunkBytes );
+		offsets.resize( header.countChunks );
+		size_t total = 0;
+		for( size_t i = 0; i < header.countChunks; i++ )
+		{
+			if( sizes[ i ] > bound )
+			{
+				logError( u8"iContext.loadCompressed: the compressed data is corrupted" );
+				return E_INVALIDARG;
+			}
+			offsets[ i ] = total;
+			total += sizes[ i ];
+		}
+
+		compressed.resize( total );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+	CHECK( stream->read( compressed ) );
+
+	// Decompress straight into the mapped staging buffer, then copy into the tensor on the GPU
+	CD3D11_BUFFER_DESC stagingDesc{ bytes, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_WRITE };
+	CComPtr<ID3D11Buffer> staging;
+	CHECK( device->CreateBuffer( &stagingDesc, nullptr, &staging ) );
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	CHECK( context->Map( staging, 0, D3D11_MAP_WRITE, 0, &mapped ) );
+	uint8_t* const rdi = (uint8_t*)mapped.pData;
+
+	auto decompress = [&]( size_t i ) -> HRESULT
+	{
+		const uint32_t len = chunkLength( header.bytes, header.chunkBytes, i );
+		const int cb = LZ4_decompress_safe( (const char*)compressed.data() + offsets[ i ], (char*)rdi + i * header.chunkBytes, (int)sizes[ i ], (int)len );
+		if( cb != (int)len )
+		{
+			logError( u8"LZ4_decompress_safe failed with status %i", cb );
+			return PLA_E_CABAPI_FAILURE;
+		}
+		return S_OK;
+	};
+	const HRESULT hr = parallelFor( header.countChunks, decompress );
+	context->Unmap( staging, 0 );
+	CHECK( hr );
+
+	const D3D11_BOX box = prefixBox( bytes );
+	context->CopySubresourceRegion( buffer, 0, 0, 0, 0, staging, 0, &box );
+	return S_OK;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "stdafx.h"
+#include "Context.h"
+using namespace Cgml;
+
+HRESULT COMLIGHTCALL Context::fenceSignal( uint64_t& fence ) noexcept
+{
+	CHECK( checkNotRecording( "fenceSignal" ) );
+
+	CComPtr<ID3D11Query> query;
+	if( !fencesPool.empty() )
+	{
+		query.Attach( fencesPool.back().Detach() );
+		fencesPool.pop_back();
+	}
+	else
+	{
+		CD3D11_QUERY_DESC desc{ D3D11_QUERY_EVENT };
+		CHECK( device->CreateQuery( &desc, &query ) );
+	}
+
+	context->End( query );
+	// Make sure the GPU starts working on the commands queued so far, otherwise the fence may never complete without a wait
+	context->Flush();
+
+	const uint64_t id = ++fenceLastSignalled;
+	try
+	{
+		fencesPending.emplace_back( id, std::move( query ) );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+	fence = id;
+	return S_OK;
+}
+
+// GetData on the immediate context, and the fence queues, are only safe on the thread which submits the commands of this context
+HRESULT Context::fencePoll()
+{
+	while( !fencesPending.empty() )
+	{
+		auto& front = fencesPending.front();
+		BOOL done = FALSE;
+		const HRESULT hr = context->GetData( front.second, &done, sizeof( done ), D3D11_ASYNC_GETDATA_DONOTFLUSH );
+		CHECK( hr );
+		if( S_OK != hr || !done )
+			return S_FALSE;
+
+		// Queries complete in the order they were issued
+		fenceLastCompleted = front.first;
+		fencesPool.emplace_back( std::move( front.second ) );
+		fencesPending.pop_front();
+	}
+	return S_OK;
+}
+
+HRESULT COMLIGHTCALL Context::fenceCheck( uint64_t fence, uint8_t wait, uint8_t& complete ) noexcept
+{
+	if( fence > fenceLastSignalled )
+	{
+		logError( u8"iContext.fenceCheck: fence %zu was never signalled", (size_t)fence );
+		return E_INVALIDARG;
+	}
+
+	while( true )
+	{
+		if( fence <= fenceLastCompleted )
+		{
+			complete = 1;
+			return S_OK;
+		}
+		CHECK( fencePoll() );
+		if( fence <= fenceLastCompleted )
+			continue;
+		if( 0 == wait )
+		{
+			complete = 0;
+			return S_OK;
+		}
+		fenceDelay.delay();
+	}
+}
\ No newline at end of file
@@ -2,7 +2,11 @@
 #include "../API/iContext.cl.h"
 #include "../../ComLightLib/comLightServer.h"
 #include "ConstantBuffersPool.h"
+#include "CommandList.h"
 #include "../Utils/Profiler/GpuProfiler.h"
+#include "../Utils/Profiler/CpuProfiler.h"
+#include "../Utils/Profiler/DelayExecution.h"
+#include <deque>
 #include "../ImageProcessor/iImageProcessor.h"
 
 namespace Cgml
@@ -16,9 +20,27 @@ namespace Cgml
 		ConstantBuffersPool constantBuffers;
 		uint8_t boundUavs = 0;
 		uint8_t boundSrvs = 0;
-		GpuProfiler profiler;
+		GpuProfiler gpuProfiler;
+		CpuProfiler cpuProfiler;
+		// Points to one of the above, depending on sDeviceParams::FLAG_CPU_PROFILER flag
+		iProfiler* const profiler;
+		// Non-empty between beginRecording and endRecording calls
+		ComLight::CComPtr<ComLight::Object<CommandList>> recording;
+		// Ring buffer offsets of the constants, for the command list being replayed
+		std::vector<uint32_t> replayOffsets;
 		// std::unique_ptr<iImageProcessor> imageProcessor;
 
+		// Event queries in flight, ordered by the fence ID
+		std::deque<std::pair<uint64_t, CComPtr<ID3D11Query>>> fencesPending;
+		// Completed event queries, recycled by the next fenceSignal calls
+		std::vector<CComPtr<ID3D11Query>> fencesPool;
+		uint64_t fenceLastSignalled = 0;
+		uint64_t fenceLastCompleted = 0;
+		DelayExecution fenceDelay;
+
+		// Poll the pending event queries in order, retire the completed ones
+		HRESULT fencePoll();
+
 		// Copy the entire contents of the source tensor to the destination tensor using the GPU
 		HRESULT COMLIGHTCALL copy( iTensor* destination, iTensor* source ) noexcept override final;
 
@@ -28,6 +50,13 @@ namespace Cgml
 		// Download tensor data from VRAM to system memory
 		HRESULT COMLIGHTCALL download( iTensor* tensor, pfnReadTensor pfn, void* pv, eDownloadFlag flag ) noexcept override final;
 
+		HRESULT bindShaderImpl( uint16_t id, const uint8_t* constantBufferData, int cbSize );
+		HRESULT bindTensorsImpl( iTensor** arr, size_t countWrite, size_t countRead );
+		HRESULT unbindInputsImpl();
+
+		// Fail with an error message when called while recording a command list
+		HRESULT checkNotRecording( const char* what ) const;
+
 		HRESULT COMLIGHTCALL bindShader( uint16_t id, const uint8_t* constantBufferData, int cbSize ) noexcept override final;
 		HRESULT COMLIGHTCALL dispatch( int groupsX, int groupsY, int groupsZ ) noexcept override final;
 
@@ -39,33 +68,66 @@ namespace Cgml
 
 		HRESULT COMLIGHTCALL profilerBlockStart( uint16_t id ) noexcept override final
 		{
-			return profiler.blockStart( id );
+			if( recording )
+				return recording->profilerBlockStart( id );
+			return profiler->blockStart( id );
 		}
 
 		HRESULT COMLIGHTCALL profilerBlockEnd() noexcept override final
 		{
-			return profiler.blockEnd();
+			if( recording )
+				return recording->profilerBlockEnd();
+			return profiler->blockEnd();
 		}
 
 		HRESULT COMLIGHTCALL profilerGetData( pfnProfilerData pfn, void* pv ) noexcept override final
 		{
-			return profiler.getData( pfn, pv );
+			return profiler->getData( pfn, pv );
 		}
 
 		HRESULT COMLIGHTCALL writeTensorData( iTensor* tensor, ComLight::iWriteStream* stream ) noexcept override final;
 
 		HRESULT COMLIGHTCALL loadImage( iTensor* result, const sImageProcessorParams& ipp, ComLight::iReadStream* stream, uint32_t* previewPixels ) noexcept override final;
 
+		HRESULT COMLIGHTCALL beginRecording() noexcept override final;
+		HRESULT COMLIGHTCALL endRecording( iCommandList** pp ) noexcept override final;
+		HRESULT COMLIGHTCALL replay( iCommandList* commands ) noexcept override final;
+
+		HRESULT COMLIGHTCALL profilerGetPercentiles( const float* percentiles, int count, pfnProfilerPercentiles pfn, void* pv, uint8_t reset ) noexcept override final
+		{
+			return profiler->getPercentiles( percentiles, count, pfn, pv, 0 != reset );
+		}
+
+		HRESULT COMLIGHTCALL profilerCaptureTimeline( uint32_t capacity ) noexcept override final
+		{
+			return profiler->captureTimeline( capacity );
+		}
+
+		HRESULT COMLIGHTCALL profilerGetTimeline( pfnProfilerEvents pfn, void* pv ) noexcept override final
+		{
+			return profiler->getTimeline( pfn, pv );
+		}
+
+		HRESULT COMLIGHTCALL copyRange( iTensor* destination, iTensor* source, uint32_t begin, uint32_t end ) noexcept override final;
+		HRESULT COMLIGHTCALL fenceSignal( uint64_t& fence ) noexcept override final;
+		HRESULT COMLIGHTCALL fenceCheck( uint64_t fence, uint8_t wait, uint8_t& complete ) noexcept override final;
+		HRESULT COMLIGHTCALL saveCompressed( iTensor* tensor, uint32_t length, ComLight::iWriteStream* stream ) noexcept override final;
+		HRESULT COMLIGHTCALL loadCompressed( iTensor* tensor, uint32_t length, ComLight::iReadStream* stream ) noexcept override final;
+
 	public:
-		Context( ID3D11Device* dev, ID3D11DeviceContext* ctx, size_t queueLength, bool powerSaver ) :
+		Context( ID3D11Device* dev, ID3D11DeviceContext* ctx, size_t queueLength, bool powerSaver, bool wallClockProfiler ) :
 			device( dev ),
 			context( ctx ),
-			profiler( dev, ctx, queueLength, powerSaver )
+			gpuProfiler( dev, ctx, queueLength, powerSaver ),
+			profiler( wallClockProfiler ? static_cast<iProfiler*>( &cpuProfiler ) : &gpuProfiler ),
+			fenceDelay( powerSaver )
 		{ }
 
 		HRESULT FinalConstruct()
 		{
-			return profiler.create();
+			if( profiler != &gpuProfiler )
+				return S_OK;
+			return gpuProfiler.create();
 		}
 	};
 }
\ No newline at end of file
@@ -45,6 +45,7 @@ HRESULT COMLIGHTCALL Context::createComputeShaders( int count, const std::pair<i
 
 HRESULT COMLIGHTCALL Context::loadImage( iTensor* result, const sImageProcessorParams& ipp, ComLight::iReadStream* stream, uint32_t* previewPixels ) noexcept
 {
+	CHECK( checkNotRecording( "loadImage" ) );
 	std::unique_ptr<iImageProcessor> imageProcessor;
 	CHECK( iImageProcessor::create( imageProcessor, device, context, constantBuffers ) );
 	return imageProcessor->loadImage( result, ipp, stream, previewPixels );
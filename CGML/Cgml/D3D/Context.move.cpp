@@ -8,6 +8,7 @@ HRESULT COMLIGHTCALL Context::writeDynamic( iTensor* tensor, const TensorShape&
 {
 	if( nullptr == tensor || nullptr == pfn )
 		return E_POINTER;
+	CHECK( checkNotRecording( "writeDynamic" ) );
 
 	Tensor* tensorBase = static_cast<Tensor*>( tensor );
 	const eBufferUse usage = tensorBase->getDesc().usage;
@@ -33,6 +34,7 @@ HRESULT COMLIGHTCALL Context::download( iTensor* tensor, pfnReadTensor pfn, void
 		return E_POINTER;
 	if( nullptr == pfn && flag != eDownloadFlag::CopyToStaging )
 		return E_POINTER;
+	CHECK( checkNotRecording( "download" ) );
 
 	const Tensor* tensorBase = static_cast<Tensor*>( tensor );
 	return tensorBase->download( context, pfn, pv, flag );
@@ -93,6 +95,7 @@ HRESULT COMLIGHTCALL Context::copy( iTensor* destination, iTensor* source ) noex
 {
 	if( nullptr == destination || nullptr == source )
 		return E_POINTER;
+	CHECK( checkNotRecording( "copy" ) );
 	Tensor* destBase = static_cast<Tensor*>( destination );
 	if( destBase->getDesc().usage == eBufferUse::Immutable )
 	{
@@ -114,4 +117,58 @@ HRESULT COMLIGHTCALL Context::copy( iTensor* destination, iTensor* source ) noex
 
 	context->CopyResource( dest, src );
 	return S_OK;
+}
+
+HRESULT COMLIGHTCALL Context::copyRange( iTensor* destination, iTensor* source, uint32_t begin, uint32_t end ) noexcept
+{
+	if( nullptr == destination || nullptr == source )
+		return E_POINTER;
+	CHECK( checkNotRecording( "copyRange" ) );
+	Tensor* destBase = static_cast<Tensor*>( destination );
+	Tensor* sourceBase = static_cast<Tensor*>( source );
+	const sTensorDesc& destDesc = destBase->getDesc();
+	const sTensorDesc& sourceDesc = sourceBase->getDesc();
+	if( destDesc.usage == eBufferUse::Immutable )
+	{
+		logError( u8"iContext.copyRange asked to write into an immutable tensor" );
+		return E_INVALIDARG;
+	}
+	if( destDesc.layout != eTensorLayout::Dense || sourceDesc.layout != eTensorLayout::Dense )
+	{
+		logError( u8"iContext.copyRange only supports dense tensors" );
+		return E_INVALIDARG;
+	}
+	if( destDesc.dataType != sourceDesc.dataType )
+	{
+		logError( u8"iContext.copyRange requires identical data types" );
+		return E_INVALIDARG;
+	}
+	if( begin > end || end > destDesc.shape.countElements() || end > sourceDesc.shape.countElements() )
+	{
+		logError( u8"iContext.copyRange: range [ %u .. %u ) is out of bounds", begin, end );
+		return E_BOUNDS;
+	}
+	if( begin == end )
+		return S_FALSE;
+
+	ID3D11ShaderResourceView* srvDest = destBase->readView();
+	ID3D11ShaderResourceView* srvSource = sourceBase->readView();
+	if( nullptr == srvDest || nullptr == srvSource )
+		return OLE_E_BLANK;
+
+	CComPtr<ID3D11Resource> dest, src;
+	srvDest->GetResource( &dest );
+	srvSource->GetResource( &src );
+
+	// The buffers are raw or typed, the box is in bytes either way
+	const uint32_t cbElement = (uint32_t)bytesPerElement( sourceDesc.dataType );
+	D3D11_BOX box;
+	box.left = begin * cbElement;
+	box.right = end * cbElement;
+	box.top = 0;
+	box.bottom = 1;
+	box.front = 0;
+	box.back = 1;
+	context->CopySubresourceRegion( dest, 0, box.left, 0, 0, src, 0, &box );
+	return S_OK;
 }
\ No newline at end of file
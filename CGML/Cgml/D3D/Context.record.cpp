@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "Context.h"
+using namespace Cgml;
+
+HRESULT Context::checkNotRecording( const char* what ) const
+{
+	if( !recording )
+		return S_OK;
+	logError( u8"iContext.%s is not supported while recording a command list", what );
+	return E_NOT_VALID_STATE;
+}
+
+HRESULT COMLIGHTCALL Context::beginRecording() noexcept
+{
+	if( recording )
+	{
+		logError( u8"The context is already recording a command list" );
+		return E_NOT_VALID_STATE;
+	}
+	return ComLight::Object<CommandList>::create( recording );
+}
+
+HRESULT COMLIGHTCALL Context::endRecording( iCommandList** pp ) noexcept
+{
+	if( nullptr == pp )
+		return E_POINTER;
+	if( !recording )
+	{
+		logError( u8"The context is not recording a command list" );
+		return E_NOT_VALID_STATE;
+	}
+	recording.detach( pp );
+	return S_OK;
+}
+
+HRESULT COMLIGHTCALL Context::replay( iCommandList* commands ) noexcept
+{
+	if( nullptr == commands )
+		return E_POINTER;
+	CHECK( checkNotRecording( "replay" ) );
+
+	const CommandList& list = *static_cast<const CommandList*>( commands );
+
+	// Write constants of all shaders with a single Map call
+	const size_t countShaders = list.constantSlices.size();
+	try
+	{
+		replayOffsets.resize( countShaders );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+	HRESULT hr = constantBuffers.uploadBatch( device, context, list.constants.data(), list.constantSlices.data(), countShaders, replayOffsets.data() );
+	CHECK( hr );
+	const bool uploaded = ( S_OK == hr );
+
+	using eCommand = CommandList::eCommand;
+	for( const CommandList::Command& cmd : list.commands )
+	{
+		switch( cmd.op )
+		{
+		case eCommand::BindShader:
+		{
+			// The shaders might have been replaced after the list was recorded
+			if( cmd.id >= shaders.size() )
+				return E_BOUNDS;
+			const uint32_t idx = cmd.args[ 0 ];
+			const auto slice = list.constantSlices[ idx ];
+			if( uploaded )
+			{
+				context->CSSetShader( shaders[ cmd.id ], nullptr, 0 );
+				CHECK( profiler->computeShader( cmd.id ) );
+				constantBuffers.bindUploaded( replayOffsets[ idx ], slice.second );
+			}
+			else
+				CHECK( bindShaderImpl( cmd.id, list.constants.data() + slice.first, (int)slice.second ) );
+			break;
+		}
+		case eCommand::Dispatch:
+			context->Dispatch( cmd.args[ 0 ], cmd.args[ 1 ], cmd.args[ 2 ] );
+			break;
+		case eCommand::BindTensors:
+			CHECK( bindTensorsImpl( (iTensor**)&list.tensors[ cmd.args[ 0 ] ], cmd.args[ 1 ], cmd.args[ 2 ] ) );
+			break;
+		case eCommand::UnbindInputs:
+			CHECK( unbindInputsImpl() );
+			break;
+		case eCommand::ProfilerBlockStart:
+			CHECK( profiler->blockStart( cmd.id ) );
+			break;
+		case eCommand::ProfilerBlockEnd:
+			CHECK( profiler->blockEnd() );
+			break;
+		default:
+			return E_UNEXPECTED;
+		}
+	}
+	return S_OK;
+}
\ No newline at end of file
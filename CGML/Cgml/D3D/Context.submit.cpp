@@ -13,8 +13,15 @@ HRESULT COMLIGHTCALL Context::bindShader( uint16_t id, const uint8_t* constantBu
 	else if( cbSize > 0 && constantBufferData == nullptr )
 		return E_POINTER;
 
+	if( recording )
+		return recording->bindShader( id, constantBufferData, cbSize );
+	return bindShaderImpl( id, constantBufferData, cbSize );
+}
+
+HRESULT Context::bindShaderImpl( uint16_t id, const uint8_t* constantBufferData, int cbSize )
+{
 	context->CSSetShader( shaders.at( id ), nullptr, 0 );
-	CHECK( profiler.computeShader( id ) );
+	CHECK( profiler->computeShader( id ) );
 	CHECK( constantBuffers.updateAndBind( device, context, constantBufferData, cbSize ) );
 	return S_OK;
 }
@@ -26,6 +33,8 @@ HRESULT COMLIGHTCALL Context::dispatch( int groupsX, int groupsY, int groupsZ )
 		groupsX > max || groupsY > max || groupsZ > max )
 		return E_INVALIDARG;
 
+	if( recording )
+		return recording->dispatch( groupsX, groupsY, groupsZ );
 	context->Dispatch( (UINT)groupsX, (UINT)groupsY, (UINT)groupsZ );
 
 	return S_OK;
@@ -65,8 +74,13 @@ HRESULT COMLIGHTCALL Context::bindTensors( iTensor** arr, int countWriteInt, int
 		return E_INVALIDARG;
 	}
 
-	const size_t countWrite = (uint32_t)countWriteInt;
-	const size_t countRead = (uint32_t)countReadInt;
+	if( recording )
+		return recording->bindTensors( arr, countWriteInt, countReadInt );
+	return bindTensorsImpl( arr, (uint32_t)countWriteInt, (uint32_t)countReadInt );
+}
+
+HRESULT Context::bindTensorsImpl( iTensor** arr, size_t countWrite, size_t countRead )
+{
 	const size_t countUav = std::max( (size_t)boundUavs, countWrite );
 	const size_t countSrv = std::max( (size_t)boundSrvs, countRead );
 
@@ -93,6 +107,13 @@ HRESULT COMLIGHTCALL Context::bindTensors( iTensor** arr, int countWriteInt, int
 }
 
 HRESULT COMLIGHTCALL Context::unbindInputs() noexcept
+{
+	if( recording )
+		return recording->unbindInputs();
+	return unbindInputsImpl();
+}
+
+HRESULT Context::unbindInputsImpl()
 {
 	if( boundSrvs != 0 )
 	{
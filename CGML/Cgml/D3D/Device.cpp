@@ -6,6 +6,9 @@
 #include "tensorUtils.h"
 #include "createBuffer.h"
 #include <Utils/tensorLoadTransforms.h>
+#include "../Utils/Compression/bcml1.h"
+#include "../Utils/Compression/ggmlBlocks.h"
+#include "../Utils/Compression/gptq.h"
 using namespace Cgml;
 
 HRESULT Device::createTensor( iTensor** pp, const sTensorDesc& desc, iTensor* reuse ) noexcept
@@ -120,17 +123,35 @@ HRESULT Device::loadImmutableTensor( iTensor** pp, const sTensorDesc& desc, ComL
 	}
 
 	LargeBuffer buffer;
-	CHECK( buffer.allocate( length ) );
-	CHECK( stream->read( buffer.pointer(), length ) );
-
 	if( tform == eLoadTransform::None )
+	{
+		CHECK( buffer.allocate( length ) );
+		CHECK( stream->read( buffer.pointer(), length ) );
 		return uploadImmutable( pp, desc, buffer.pointer(), bufferBytes, ti.format, (UINT)elements );
+	}
+
+	sTensorDesc d2 = desc;
+	if( bufferBytes == length )
+	{
+		// Convert chunks of the tensor on the thread pool while reading the stream
+		CHECK( Cgml::readTransformed( tform, d2.dataType, ti.format, stream, buffer, bufferBytes, elements ) );
+	}
 	else
 	{
-		sTensorDesc d2 = desc;
-		CHECK( Cgml::loadTransform( tform, d2.dataType, ti.format, buffer.pointer(), bufferBytes, elements ) );
-		return uploadImmutable( pp, d2, buffer.pointer(), bufferBytes, ti.format, (UINT)elements );
+		// The payload is longer than the tensor, read all of it, then transform the tensor
+		LargeBuffer payload;
+		CHECK( payload.allocate( length ) );
+		CHECK( stream->read( payload.pointer(), length ) );
+		MemoryReader reader( payload.pointer(), bufferBytes );
+		CHECK( Cgml::readTransformed( tform, d2.dataType, ti.format, &reader, buffer, bufferBytes, elements ) );
 	}
+
+	if( 0 != ( bufferBytes >> 31 ) )
+	{
+		logError( u8"The transformed tensor is too large, exceeds 2GB VRAM" );
+		return DISP_E_OVERFLOW;
+	}
+	return uploadImmutable( pp, d2, buffer.pointer(), bufferBytes, ti.format, (UINT)elements );
 }
 
 HRESULT Device::uploadImmutableTensor( iTensor** pp, const sTensorDesc& desc, const void* rsi, uint32_t length ) noexcept
@@ -321,4 +342,75 @@ HRESULT Device::loadTensor( iTensor* tensor, ComLight::iReadStream* stream, uint
 	CHECK( buffer.allocate( length ) );
 	CHECK( stream->read( buffer.pointer(), length ) );
 	return tensorBase->loadData( device, buffer.pointer(), length );
+}
+
+HRESULT Device::uploadQuantizedTensor( iTensor** pp, const sTensorDesc& desc, eGgmlType type, const void* rsi, uint32_t length ) noexcept
+{
+	if( nullptr == pp || nullptr == rsi )
+		return E_POINTER;
+
+	if( desc.usage != eBufferUse::Immutable )
+	{
+		logError( u8"iDevice.uploadQuantizedTensor can only create tensors with eBufferUse.Immutable" );
+		return E_INVALIDARG;
+	}
+
+	const size_t elements = horizontalProduct( desc.shape.sizeVec() );
+	const size_t elementsPadding = (size_t)desc.shape.stride[ 3 ] * desc.shape.size[ 3 ];
+	if( elements != elementsPadding || 0 != desc.shape.size[ 0 ] % 32 )
+	{
+		logError( u8"The quantized tensor is expected to be dense, with complete blocks of 32 elements in every row" );
+		return E_INVALIDARG;
+	}
+
+	size_t sourceBytes;
+	CHECK( GgmlBlocks::sourceBytes( type, elements, sourceBytes ) );
+	if( sourceBytes != length )
+	{
+		logError( u8"Unexpected payload length" );
+		return E_INVALIDARG;
+	}
+
+	if( desc.layout == eTensorLayout::BCML1 && type != eGgmlType::Q8_0 )
+	{
+		// 4-bit blocks only need to be reshaped into panels, the weights are copied without changes
+		sTensorDesc compressedDesc;
+		CHECK( Bcml1::makeDesc( compressedDesc, desc ) );
+
+		std::vector<uint32_t> data;
+		CHECK( GgmlBlocks::repackBcml1( type, compressedDesc, rsi, data ) );
+
+		ComLight::CComPtr<ComLight::Object<Tensor>> result;
+		CHECK( ComLight::Object<Tensor>::create( result, compressedDesc, nullptr ) );
+		CHECK( result->createImmutableRaw( device, data ) );
+		result.detach( pp );
+		return S_OK;
+	}
+
+	// Decompress into FP16
+	const size_t bufferBytes = elements * 2;
+	if( 0 != ( bufferBytes >> 31 ) )
+	{
+		logError( u8"The tensor is too large, exceeds 2GB VRAM" );
+		return DISP_E_OVERFLOW;
+	}
+
+	LargeBuffer buffer;
+	CHECK( buffer.allocate( bufferBytes ) );
+	CHECK( GgmlBlocks::dequantize( type, rsi, elements, (uint16_t*)buffer.pointer() ) );
+
+	sTensorDesc d2 = desc;
+	d2.dataType = eDataType::FP16;
+	if( desc.layout == eTensorLayout::Dense )
+		return uploadImmutable( pp, d2, buffer.pointer(), bufferBytes, DXGI_FORMAT_R16_FLOAT, (UINT)elements );
+
+	// 8-bit weights don't fit into BCML1 blocks, quantize them again on the background threads
+	MemoryReader reader( buffer.pointer(), bufferBytes );
+	return loadCompressed( pp, d2, &reader, (uint32_t)bufferBytes );
+}
+
+HRESULT Device::reshapeGptq( uint32_t* rdi, uint32_t length, const sGptqTensor& source, eGptqCodec codec ) noexcept
+{
+	// This method doesn't use the GPU, the output is in system memory
+	return Gptq::reshape( rdi, length, source, codec );
 }
\ No newline at end of file
@@ -23,6 +23,10 @@ namespace Cgml
 
 		HRESULT loadTensor( iTensor* tensor, ComLight::iReadStream* stream, uint32_t length ) noexcept override final;
 
+		HRESULT uploadQuantizedTensor( iTensor** pp, const sTensorDesc& desc, eGgmlType type, const void* rsi, uint32_t length ) noexcept override final;
+
+		HRESULT reshapeGptq( uint32_t* rdi, uint32_t length, const sGptqTensor& source, eGptqCodec codec ) noexcept override final;
+
 		CComPtr<ID3D11Device> device;
 		std::wstring deviceName;
 		std::unique_ptr<iCompressor> weightCompressor;
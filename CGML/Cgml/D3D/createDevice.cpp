@@ -65,9 +65,10 @@ HRESULT COMLIGHTCALL Cgml::createDeviceAndContext( const sDeviceParams& devicePa
 		queueLength = 64;
 	}
 	const bool powerSaver = 0 != ( deviceParams.flags & sDeviceParams::FLAG_POWERSAVER );
+	const bool cpuProfiler = 0 != ( deviceParams.flags & sDeviceParams::FLAG_CPU_PROFILER );
 
 	ComLight::CComPtr<ComLight::Object<Context>> ctx;
-	CHECK( ComLight::Object<Context>::create( ctx, computeDevice.device, computeDevice.context, (uint32_t)queueLength, powerSaver ) );
+	CHECK( ComLight::Object<Context>::create( ctx, computeDevice.device, computeDevice.context, (uint32_t)queueLength, powerSaver, cpuProfiler ) );
 
 	dev.detach( device );
 	ctx.detach( context );
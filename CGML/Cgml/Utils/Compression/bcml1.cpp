@@ -447,6 +447,7 @@ namespace
 		uint8_t res = checkAvx2Support() ? (uint8_t)eCpuExtensionFlags::AVX2 : 0;
 		res |= checkF16cSuppport() ? (uint8_t)eCpuExtensionFlags::F16C : 0;
 		res |= checkBmi2Suppport() ? (uint8_t)eCpuExtensionFlags::BMI2 : 0;
+		res |= checkAvx512Support() ? (uint8_t)eCpuExtensionFlags::AVX512 : 0;
 		return res;
 	}
 
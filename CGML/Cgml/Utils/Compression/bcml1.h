@@ -16,6 +16,8 @@ namespace Bcml1
 		AVX2 = 1,
 		F16C = 2,
 		BMI2 = 4,
+		// AVX512F + AVX512BW + AVX512VL
+		AVX512 = 8,
 	};
 	inline eCpuExtensionFlags operator|( eCpuExtensionFlags a, eCpuExtensionFlags b )
 	{
@@ -0,0 +1,264 @@
+#include "stdafx.h"
+#include "ggmlBlocks.h"
+#include "bcml1.h"
+
+namespace
+{
+	// Memory layout of these blocks is defined in ggml-quants.h source file of llama.cpp
+	struct BlockQ4_0
+	{
+		uint16_t d;
+		uint8_t qs[ 16 ];
+	};
+	static_assert( sizeof( BlockQ4_0 ) == 18 );
+
+	struct BlockQ4_1
+	{
+		uint16_t d, m;
+		uint8_t qs[ 16 ];
+	};
+	static_assert( sizeof( BlockQ4_1 ) == 20 );
+
+	struct BlockQ8_0
+	{
+		uint16_t d;
+		int8_t qs[ 32 ];
+	};
+	static_assert( sizeof( BlockQ8_0 ) == 34 );
+
+	// ggml stores elements [ 0 .. 15 ] of the block in the low nibbles of these 16 bytes, elements [ 16 .. 31 ] in the high nibbles
+	// BCML1 wants them sequentially, i.e. byte #i contains elements 2*i in the low nibble, and 2*i+1 in the high one
+	__forceinline __m128i reorderNibbles( const uint8_t* qs )
+	{
+		const __m128i v = _mm_loadu_si128( ( const __m128i* )qs );
+		const __m128i mask = _mm_set1_epi8( 0x0F );
+		__m128i low = _mm_and_si128( v, mask );
+		__m128i high = _mm_and_si128( _mm_srli_epi16( v, 4 ), mask );
+
+		// For each pair of bytes [ a, b ] compute a + b * 16, the result fits in a byte
+		const __m128i mul = _mm_set1_epi16( 0x1001 );
+		low = _mm_maddubs_epi16( low, mul );
+		high = _mm_maddubs_epi16( high, mul );
+		return _mm_packus_epi16( low, high );
+	}
+
+	// Unpack 16 bytes with 4-bit integers into 4 FP32 vectors, in ggml order of the elements
+	__forceinline void unpackNibbles( __m256& v0, __m256& v1, __m256& v2, __m256& v3, const uint8_t* qs )
+	{
+		const __m128i v = _mm_loadu_si128( ( const __m128i* )qs );
+		const __m128i mask = _mm_set1_epi8( 0x0F );
+		const __m128i low = _mm_and_si128( v, mask );
+		const __m128i high = _mm_and_si128( _mm_srli_epi16( v, 4 ), mask );
+
+		v0 = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( low ) );
+		v1 = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_unpackhi_epi64( low, low ) ) );
+		v2 = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( high ) );
+		v3 = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_unpackhi_epi64( high, high ) ) );
+	}
+
+	__forceinline void storeFp16( uint16_t* rdi, __m256 v )
+	{
+		_mm_storeu_si128( ( __m128i* )rdi, _mm256_cvtps_ph( v, _MM_FROUND_TO_NEAREST_INT ) );
+	}
+
+	// Store 32 elements computed as mad( v, scale, offset )
+	__forceinline void storeBlock( uint16_t* rdi, __m256 v0, __m256 v1, __m256 v2, __m256 v3, __m256 scale, __m256 offset )
+	{
+		storeFp16( rdi, _mm256_add_ps( _mm256_mul_ps( v0, scale ), offset ) );
+		storeFp16( rdi + 8, _mm256_add_ps( _mm256_mul_ps( v1, scale ), offset ) );
+		storeFp16( rdi + 16, _mm256_add_ps( _mm256_mul_ps( v2, scale ), offset ) );
+		storeFp16( rdi + 24, _mm256_add_ps( _mm256_mul_ps( v3, scale ), offset ) );
+	}
+
+	struct Q4_0
+	{
+		using Block = BlockQ4_0;
+
+		// BCML1 header is [ scale, offset ] FP16 numbers, ggml decodes these elements as d * ( q - 8 ) = d * q - 8 * d
+		static __forceinline uint32_t header( const Block& b )
+		{
+			const float d = _cvtsh_ss( b.d );
+			const uint32_t offset = _cvtss_sh( d * -8.0f, _MM_FROUND_TO_NEAREST_INT );
+			return (uint32_t)b.d | ( offset << 16 );
+		}
+
+		static __forceinline void dequantize( uint16_t* rdi, const Block& b )
+		{
+			__m256 v0, v1, v2, v3;
+			unpackNibbles( v0, v1, v2, v3, b.qs );
+			const __m256 scale = _mm256_set1_ps( _cvtsh_ss( b.d ) );
+			const __m256 offset = _mm256_mul_ps( scale, _mm256_set1_ps( -8.0f ) );
+			storeBlock( rdi, v0, v1, v2, v3, scale, offset );
+		}
+	};
+
+	struct Q4_1
+	{
+		using Block = BlockQ4_1;
+
+		// ggml decodes these elements as d * q + m, the header is already in the format we need
+		static __forceinline uint32_t header( const Block& b )
+		{
+			return *(const uint32_t*)( &b.d );
+		}
+
+		static __forceinline void dequantize( uint16_t* rdi, const Block& b )
+		{
+			__m256 v0, v1, v2, v3;
+			unpackNibbles( v0, v1, v2, v3, b.qs );
+			const __m256 scale = _mm256_set1_ps( _cvtsh_ss( b.d ) );
+			const __m256 offset = _mm256_set1_ps( _cvtsh_ss( b.m ) );
+			storeBlock( rdi, v0, v1, v2, v3, scale, offset );
+		}
+	};
+
+	struct Q8_0
+	{
+		using Block = BlockQ8_0;
+
+		static __forceinline void dequantize( uint16_t* rdi, const Block& b )
+		{
+			const __m256 scale = _mm256_set1_ps( _cvtsh_ss( b.d ) );
+			for( size_t i = 0; i < 32; i += 8 )
+			{
+				__m128i iv = _mm_loadl_epi64( ( const __m128i* )( &b.qs[ i ] ) );
+				__m256 f = _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( iv ) );
+				storeFp16( rdi + i, _mm256_mul_ps( f, scale ) );
+			}
+		}
+	};
+
+	using Bcml1::PANEL_HEIGHT;
+
+	// Write 5 integers of the BCML1 block into the column of the panel
+	__forceinline void storeColumn( uint32_t* rdi, uint32_t header, __m128i weights )
+	{
+		rdi[ 0 ] = header;
+		rdi[ PANEL_HEIGHT ] = (uint32_t)_mm_cvtsi128_si32( weights );
+		rdi[ PANEL_HEIGHT * 2 ] = (uint32_t)_mm_extract_epi32( weights, 1 );
+		rdi[ PANEL_HEIGHT * 3 ] = (uint32_t)_mm_extract_epi32( weights, 2 );
+		rdi[ PANEL_HEIGHT * 4 ] = (uint32_t)_mm_extract_epi32( weights, 3 );
+	}
+
+	template<class Codec>
+	static __declspec( noinline ) HRESULT repackImpl( const Cgml::sTensorDesc& desc, const void* rsi, std::vector<uint32_t>& result )
+	{
+		size_t compressedBytes = desc.shape.stride[ 3 ];
+		compressedBytes *= desc.shape.size[ 3 ];
+		assert( 0 == compressedBytes % 4 );
+		try
+		{
+			// Incomplete panels are padded with zeros, resize() does that
+			result.clear();
+			result.resize( compressedBytes / 4 );
+		}
+		catch( const std::bad_alloc& )
+		{
+			return E_OUTOFMEMORY;
+		}
+
+		const size_t widthBlocks = desc.shape.size[ 0 ] / 32;
+		const size_t height = desc.shape.size[ 1 ];
+		const size_t slices = (size_t)desc.shape.size[ 2 ] * desc.shape.size[ 3 ];
+		const size_t sliceIntegers = desc.shape.stride[ 2 ] / 4;
+		const size_t panelIntegers = desc.shape.stride[ 1 ] / 4;
+
+		using Block = typename Codec::Block;
+		const Block* source = (const Block*)rsi;
+
+		for( size_t s = 0; s < slices; s++ )
+		{
+			uint32_t* const rdiSlice = result.data() + s * sliceIntegers;
+			for( size_t y = 0; y < height; y++ )
+			{
+				// Column of the panel for the first integer of the row
+				uint32_t* rdi = rdiSlice + ( y / PANEL_HEIGHT ) * panelIntegers + ( y % PANEL_HEIGHT );
+				for( size_t x = 0; x < widthBlocks; x++, source++, rdi += PANEL_HEIGHT * 5 )
+					storeColumn( rdi, Codec::header( *source ), reorderNibbles( source->qs ) );
+			}
+		}
+		return S_OK;
+	}
+
+	template<class Codec>
+	static __declspec( noinline ) void dequantizeImpl( const void* rsi, size_t blocks, uint16_t* rdi )
+	{
+		using Block = typename Codec::Block;
+		const Block* source = (const Block*)rsi;
+		const Block* const sourceEnd = source + blocks;
+		for( ; source < sourceEnd; source++, rdi += 32 )
+			Codec::dequantize( rdi, *source );
+	}
+
+	HRESULT checkCpu()
+	{
+		using Bcml1::eCpuExtensionFlags;
+		if( Bcml1::checkExtensionFlags( eCpuExtensionFlags::AVX2 | eCpuExtensionFlags::F16C ) )
+			return S_OK;
+		logError( u8"Decoding GGML blocks requires a CPU with AVX2 and F16C support" );
+		return HRESULT_FROM_WIN32( ERROR_HV_CPUID_FEATURE_VALIDATION );
+	}
+}
+
+HRESULT GgmlBlocks::sourceBytes( eGgmlType type, size_t elements, size_t& rdi )
+{
+	if( 0 != elements % 32 )
+	{
+		logError( u8"GGML quantized tensors must contain complete blocks of 32 elements" );
+		return E_INVALIDARG;
+	}
+	const size_t blocks = elements / 32;
+	switch( type )
+	{
+	case eGgmlType::Q4_0:
+		rdi = blocks * sizeof( BlockQ4_0 );
+		return S_OK;
+	case eGgmlType::Q4_1:
+		rdi = blocks * sizeof( BlockQ4_1 );
+		return S_OK;
+	case eGgmlType::Q8_0:
+		rdi = blocks * sizeof( BlockQ8_0 );
+		return S_OK;
+	}
+	logError( u8"Unsupported GGML block type %i", (int)type );
+	return E_NOTIMPL;
+}
+
+HRESULT GgmlBlocks::repackBcml1( eGgmlType type, const sTensorDesc& compressedDesc, const void* rsi, std::vector<uint32_t>& result )
+{
+	if( compressedDesc.layout != eTensorLayout::BCML1 || 0 != compressedDesc.shape.size[ 0 ] % 32 )
+		return E_INVALIDARG;
+	CHECK( checkCpu() );
+
+	switch( type )
+	{
+	case eGgmlType::Q4_0:
+		return repackImpl<Q4_0>( compressedDesc, rsi, result );
+	case eGgmlType::Q4_1:
+		return repackImpl<Q4_1>( compressedDesc, rsi, result );
+	}
+	logError( u8"GGML block type %i can't be repacked into BCML1 without quantizing again", (int)type );
+	return E_NOTIMPL;
+}
+
+HRESULT GgmlBlocks::dequantize( eGgmlType type, const void* rsi, size_t elements, uint16_t* rdi )
+{
+	if( 0 != elements % 32 )
+		return E_INVALIDARG;
+	CHECK( checkCpu() );
+
+	const size_t blocks = elements / 32;
+	switch( type )
+	{
+	case eGgmlType::Q4_0:
+		dequantizeImpl<Q4_0>( rsi, blocks, rdi );
+		return S_OK;
+	case eGgmlType::Q4_1:
+		dequantizeImpl<Q4_1>( rsi, blocks, rdi );
+		return S_OK;
+	case eGgmlType::Q8_0:
+		dequantizeImpl<Q8_0>( rsi, blocks, rdi );
+		return S_OK;
+	}
+	return E_NOTIMPL;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+#include "../../API/sTensorDesc.h"
+
+// Block-quantized tensors produced by llama.cpp, stored in GGUF files
+namespace GgmlBlocks
+{
+	using namespace Cgml;
+
+	// Count of bytes in the quantized payload of the tensor
+	HRESULT sourceBytes( eGgmlType type, size_t elements, size_t& rdi );
+
+	// Reshape quantized blocks into BCML1 panels, without decompressing the weights
+	// The compressed tensor descriptor must be produced by Bcml1::makeDesc function
+	HRESULT repackBcml1( eGgmlType type, const sTensorDesc& compressedDesc, const void* rsi, std::vector<uint32_t>& result );
+
+	// Decompress quantized blocks into FP16 numbers
+	HRESULT dequantize( eGgmlType type, const void* rsi, size_t elements, uint16_t* rdi );
+}
\ No newline at end of file
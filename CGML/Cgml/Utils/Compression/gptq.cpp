@@ -0,0 +1,280 @@
+#include "stdafx.h"
+#include "gptq.h"
+#include "bcml1.h"
+#include "../parallelFor.h"
+
+namespace
+{
+	using namespace Cgml;
+
+	constexpr size_t PANEL_HEIGHT = 64;
+
+	// GPTQ quantization blocks are 128 elements = 16 integers
+	constexpr size_t groupIntegers = 16;
+	// One column of zeros contains zero points for 8 blocks = 1024 elements
+	constexpr size_t zerosIntegers = groupIntegers * 8;
+
+	inline size_t divRoundUp( size_t a, size_t b )
+	{
+		return ( a + b - 1 ) / b;
+	}
+
+	// Count of uint32_t columns in a panel
+	size_t panelColumns( const sGptqTensor& source, eGptqCodec codec )
+	{
+		const size_t width = source.rowLengthIntegers;
+		const size_t zeros = divRoundUp( width, zerosIntegers );
+		const size_t scales = ( codec == eGptqCodec::BCML3 ) ? divRoundUp( width, groupIntegers ) : divRoundUp( width, groupIntegers * 2 );
+		return zeros + scales + width;
+	}
+
+	__forceinline __m256i load( const void* rsi )
+	{
+		return _mm256_loadu_si256( ( const __m256i* )rsi );
+	}
+	__forceinline void store( void* rdi, __m256i v )
+	{
+		_mm256_storeu_si256( ( __m256i* )rdi, v );
+	}
+
+	// Copy a column of uint32_t values into the panel
+	__forceinline void copyColumn( uint32_t* rdi, const uint32_t* rsi, size_t height )
+	{
+		if( height != PANEL_HEIGHT )
+		{
+			__movsd( (DWORD*)rdi, (const DWORD*)rsi, height );
+			return;
+		}
+		for( size_t i = 0; i < PANEL_HEIGHT; i += 16 )
+		{
+			const __m256i v0 = load( rsi + i );
+			const __m256i v1 = load( rsi + i + 8 );
+			store( rdi + i, v0 );
+			store( rdi + i + 8, v1 );
+		}
+	}
+
+	// Pack two columns of FP16 scales into a column of uint32_t values, the second one is optional
+	__forceinline void packScales( uint32_t* rdi, const uint16_t* rsi0, const uint16_t* rsi1, size_t height )
+	{
+		if( height != PANEL_HEIGHT )
+		{
+			for( size_t i = 0; i < height; i++ )
+			{
+				uint32_t v = rsi0[ i ];
+				if( nullptr != rsi1 )
+					v |= (uint32_t)rsi1[ i ] << 16;
+				rdi[ i ] = v;
+			}
+			return;
+		}
+
+		for( size_t i = 0; i < PANEL_HEIGHT; i += 16 )
+		{
+			const __m256i a = load( rsi0 + i );
+			const __m256i b = ( nullptr != rsi1 ) ? load( rsi1 + i ) : _mm256_setzero_si256();
+			// The unpack instructions are interleaving within 16-byte lanes, permute2x128 restores the order
+			const __m256i low = _mm256_unpacklo_epi16( a, b );
+			const __m256i high = _mm256_unpackhi_epi16( a, b );
+			store( rdi + i, _mm256_permute2x128_si256( low, high, 0x20 ) );
+			store( rdi + i + 8, _mm256_permute2x128_si256( low, high, 0x31 ) );
+		}
+	}
+
+	// A step of the 8x8 transpose of 4-bit elements: swap odd bit fields of a with even fields of b
+	template<int shift>
+	__forceinline void swapFields( __m256i& a, __m256i& b, __m256i mask )
+	{
+		const __m256i t = _mm256_and_si256( _mm256_xor_si256( _mm256_srli_epi32( a, shift ), b ), mask );
+		b = _mm256_xor_si256( b, t );
+		a = _mm256_xor_si256( a, _mm256_slli_epi32( t, shift ) );
+	}
+
+	// Transpose 8x8 matrix of uint32_t, and store the result
+	__forceinline void storeTransposed( uint32_t* rdi, const __m256i* r )
+	{
+		const __m256i t0 = _mm256_unpacklo_epi32( r[ 0 ], r[ 1 ] );
+		const __m256i t1 = _mm256_unpackhi_epi32( r[ 0 ], r[ 1 ] );
+		const __m256i t2 = _mm256_unpacklo_epi32( r[ 2 ], r[ 3 ] );
+		const __m256i t3 = _mm256_unpackhi_epi32( r[ 2 ], r[ 3 ] );
+		const __m256i t4 = _mm256_unpacklo_epi32( r[ 4 ], r[ 5 ] );
+		const __m256i t5 = _mm256_unpackhi_epi32( r[ 4 ], r[ 5 ] );
+		const __m256i t6 = _mm256_unpacklo_epi32( r[ 6 ], r[ 7 ] );
+		const __m256i t7 = _mm256_unpackhi_epi32( r[ 6 ], r[ 7 ] );
+
+		const __m256i u0 = _mm256_unpacklo_epi64( t0, t2 );
+		const __m256i u1 = _mm256_unpackhi_epi64( t0, t2 );
+		const __m256i u2 = _mm256_unpacklo_epi64( t1, t3 );
+		const __m256i u3 = _mm256_unpackhi_epi64( t1, t3 );
+		const __m256i u4 = _mm256_unpacklo_epi64( t4, t6 );
+		const __m256i u5 = _mm256_unpackhi_epi64( t4, t6 );
+		const __m256i u6 = _mm256_unpacklo_epi64( t5, t7 );
+		const __m256i u7 = _mm256_unpackhi_epi64( t5, t7 );
+
+		store( rdi, _mm256_permute2x128_si256( u0, u4, 0x20 ) );
+		store( rdi + 8, _mm256_permute2x128_si256( u1, u5, 0x20 ) );
+		store( rdi + 16, _mm256_permute2x128_si256( u2, u6, 0x20 ) );
+		store( rdi + 24, _mm256_permute2x128_si256( u3, u7, 0x20 ) );
+		store( rdi + 32, _mm256_permute2x128_si256( u0, u4, 0x31 ) );
+		store( rdi + 40, _mm256_permute2x128_si256( u1, u5, 0x31 ) );
+		store( rdi + 48, _mm256_permute2x128_si256( u2, u6, 0x31 ) );
+		store( rdi + 56, _mm256_permute2x128_si256( u3, u7, 0x31 ) );
+	}
+
+	class Reshaper
+	{
+		const sGptqTensor& source;
+		const eGptqCodec codec;
+		uint32_t* const output;
+		const size_t rows, width, groups, zerosStride, panelIntegers;
+
+		// Gather zero points of 8 consecutive groups starting at the specified one, for a column of the panel
+		// qzeros has a nibble per row, the output has a nibble per group, this is an 8x8 transpose of 4-bit elements
+		void gatherZeros( uint32_t* rdi, size_t group, size_t yBase, size_t height ) const
+		{
+			const size_t innerBlocks = std::min( (size_t)8, groups - group );
+			const uint32_t* rsi = source.qzeros + group * zerosStride + yBase / 8;
+
+			if( height != PANEL_HEIGHT )
+			{
+				for( size_t i = 0; i < height; i++ )
+				{
+					const size_t y = yBase + i;
+					uint32_t res = 0;
+					for( size_t j = 0; j < innerBlocks; j++ )
+					{
+						uint32_t e = source.qzeros[ ( group + j ) * zerosStride + y / 8 ];
+						e = ( e >> ( ( y % 8 ) * 4 ) ) & 0xF;
+						res |= e << ( j * 4 );
+					}
+					rdi[ i ] = res;
+				}
+				return;
+			}
+
+			// r[ j ] lane k contains zero points of rows [ yBase + k * 8 .. yBase + k * 8 + 7 ] for the group #j
+			__m256i r[ 8 ];
+			for( size_t j = 0; j < 8; j++, rsi += zerosStride )
+				r[ j ] = ( j < innerBlocks ) ? load( rsi ) : _mm256_setzero_si256();
+
+			// Transpose nibbles within each 32-bit lane
+			// After that, r[ j ] lane k contains zero points of all 8 groups for the row yBase + k * 8 + j
+			const __m256i m4 = _mm256_set1_epi32( 0x0F0F0F0F );
+			swapFields<4>( r[ 0 ], r[ 1 ], m4 );
+			swapFields<4>( r[ 2 ], r[ 3 ], m4 );
+			swapFields<4>( r[ 4 ], r[ 5 ], m4 );
+			swapFields<4>( r[ 6 ], r[ 7 ], m4 );
+			const __m256i m8 = _mm256_set1_epi32( 0x00FF00FF );
+			swapFields<8>( r[ 0 ], r[ 2 ], m8 );
+			swapFields<8>( r[ 1 ], r[ 3 ], m8 );
+			swapFields<8>( r[ 4 ], r[ 6 ], m8 );
+			swapFields<8>( r[ 5 ], r[ 7 ], m8 );
+			const __m256i m16 = _mm256_set1_epi32( 0x0000FFFF );
+			swapFields<16>( r[ 0 ], r[ 4 ], m16 );
+			swapFields<16>( r[ 1 ], r[ 5 ], m16 );
+			swapFields<16>( r[ 2 ], r[ 6 ], m16 );
+			swapFields<16>( r[ 3 ], r[ 7 ], m16 );
+
+			// Transpose the lanes to make the output sequential
+			storeTransposed( rdi, r );
+		}
+
+	public:
+
+		Reshaper( uint32_t* rdi, const sGptqTensor& src, eGptqCodec c ) :
+			source( src ), codec( c ), output( rdi ),
+			rows( src.rows ), width( src.rowLengthIntegers ),
+			groups( divRoundUp( src.rowLengthIntegers, groupIntegers ) ),
+			zerosStride( divRoundUp( src.rows, 8 ) ),
+			panelIntegers( panelColumns( src, c ) * PANEL_HEIGHT )
+		{ }
+
+		// Produce a single panel of the output
+		HRESULT operator()( size_t panel ) const
+		{
+			const size_t yBase = panel * PANEL_HEIGHT;
+			const size_t height = std::min( PANEL_HEIGHT, rows - yBase );
+			uint32_t* rdi = output + panel * panelIntegers;
+			if( height != PANEL_HEIGHT )
+				memset( rdi, 0, panelIntegers * 4 );
+
+			const uint32_t* const scalesF32 = (const uint32_t*)source.scales;
+			const uint16_t* const scalesF16 = (const uint16_t*)source.scales;
+
+			for( size_t c = 0; c < width; c++ )
+			{
+				if( 0 == c % zerosIntegers )
+				{
+					// First column of a 1024-long sequence, pack quantized zeros
+					gatherZeros( rdi, c / groupIntegers, yBase, height );
+					rdi += PANEL_HEIGHT;
+				}
+
+				if( codec == eGptqCodec::BCML3 )
+				{
+					if( 0 == c % groupIntegers )
+					{
+						// First column of 128-long sequence, copy FP32 scales
+						copyColumn( rdi, scalesF32 + ( c / groupIntegers ) * rows + yBase, height );
+						rdi += PANEL_HEIGHT;
+					}
+				}
+				else if( 0 == c % ( groupIntegers * 2 ) )
+				{
+					// First column of 256-long sequence, pack 2 (or sometimes, very rarely, 1) columns with FP16 scales
+					const uint16_t* s0 = scalesF16 + ( c / groupIntegers ) * rows + yBase;
+					const uint16_t* s1 = ( c + groupIntegers < width ) ? s0 + rows : nullptr;
+					packScales( rdi, s0, s1, height );
+					rdi += PANEL_HEIGHT;
+				}
+
+				// Copy quantized weights
+				copyColumn( rdi, source.qweight + c * rows + yBase, height );
+				rdi += PANEL_HEIGHT;
+			}
+			assert( rdi == output + ( panel + 1 ) * panelIntegers );
+			return S_OK;
+		}
+	};
+}
+
+HRESULT Gptq::outputLength( const sGptqTensor& source, eGptqCodec codec, size_t& rdi )
+{
+	if( codec != eGptqCodec::BCML3 && codec != eGptqCodec::BCML4 )
+	{
+		logError( u8"Unsupported GPTQ codec %i", (int)codec );
+		return E_INVALIDARG;
+	}
+	if( 0 == source.rows || 0 == source.rowLengthIntegers )
+	{
+		logError( u8"Empty GPTQ tensors are not supported" );
+		return E_INVALIDARG;
+	}
+
+	const size_t panels = divRoundUp( source.rows, PANEL_HEIGHT );
+	rdi = panels * panelColumns( source, codec ) * PANEL_HEIGHT;
+	return S_OK;
+}
+
+HRESULT Gptq::reshape( uint32_t* rdi, size_t length, const sGptqTensor& source, eGptqCodec codec )
+{
+	if( nullptr == rdi || nullptr == source.qweight || nullptr == source.scales || nullptr == source.qzeros )
+		return E_POINTER;
+
+	size_t expected;
+	CHECK( outputLength( source, codec, expected ) );
+	if( length != expected )
+	{
+		logError( u8"Unexpected output length %zu, the reshaped GPTQ tensor has %zu elements", length, expected );
+		return E_INVALIDARG;
+	}
+
+	if( !Bcml1::checkExtensionFlags( Bcml1::eCpuExtensionFlags::AVX2 ) )
+	{
+		logError( u8"Reshaping GPTQ tensors requires a CPU with AVX2 support" );
+		return HRESULT_FROM_WIN32( ERROR_HV_CPUID_FEATURE_VALIDATION );
+	}
+
+	Reshaper reshaper{ rdi, source, codec };
+	return parallelFor( divRoundUp( source.rows, PANEL_HEIGHT ), reshaper );
+}
\ No newline at end of file
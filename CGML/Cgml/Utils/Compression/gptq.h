@@ -0,0 +1,14 @@
+#pragma once
+#include "../../API/sGptqTensor.h"
+
+// Reshape GPTQ-quantized matrices into BCML3 or BCML4 panels, without recompressing the weights
+namespace Gptq
+{
+	using namespace Cgml;
+
+	// Count of uint32_t elements in the output of the reshape function
+	HRESULT outputLength( const sGptqTensor& source, eGptqCodec codec, size_t& rdi );
+
+	// Reshape the matrix, using the thread pool to process the panels in parallel
+	HRESULT reshape( uint32_t* rdi, size_t length, const sGptqTensor& source, eGptqCodec codec );
+}
\ No newline at end of file
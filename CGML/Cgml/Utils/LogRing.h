@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include "../API/loggerApi.h"
+
+// A single log message in the queue
+struct LogMessage
+{
+	// Global sequence number, to deliver messages from different threads in the original order
+	uint64_t sequence;
+	// When the message doesn't fit in the inline buffer, it's allocated with malloc() and freed by the consumer
+	char* heap;
+	// HRESULT code to describe after the message, only used when hasCode is true
+	int32_t code;
+	Cgml::eLogLevel level;
+	bool hasCode;
+
+	static constexpr size_t inlineLength = 488;
+	char text[ inlineLength ];
+
+	const char* message() const
+	{
+		return ( nullptr != heap ) ? heap : text;
+	}
+};
+
+// Lock-free ring buffer with log messages from a single producer thread, consumed by the logger thread
+// When the buffer is full, the producer drops the message and increments the counter, instead of waiting.
+class LogRing
+{
+	static constexpr uint32_t capacity = 64;
+
+	// Written by the producer
+	alignas( 64 ) std::atomic_uint32_t writePos = 0;
+	std::atomic_uint64_t dropped = 0;
+	// Written by the consumer
+	alignas( 64 ) std::atomic_uint32_t readPos = 0;
+
+	LogMessage slots[ capacity ];
+
+public:
+	// Set when the producer thread exits; once drained, the buffer is reused by the next thread which logs a message
+	std::atomic_bool abandoned = false;
+
+	// Producer: pointer to the next free slot, or nullptr when the buffer is full
+	LogMessage* beginWrite()
+	{
+		const uint32_t w = writePos.load( std::memory_order_relaxed );
+		if( w - readPos.load( std::memory_order_acquire ) >= capacity )
+		{
+			dropped.fetch_add( 1, std::memory_order_relaxed );
+			return nullptr;
+		}
+		return &slots[ w % capacity ];
+	}
+
+	// Producer: publish the slot returned by beginWrite, returns the position to pass to waitDelivered
+	uint32_t endWrite()
+	{
+		const uint32_t w = writePos.load( std::memory_order_relaxed ) + 1;
+		writePos.store( w, std::memory_order_release );
+		return w;
+	}
+
+	// Consumer: the oldest message in the buffer, or nullptr when empty
+	LogMessage* peek()
+	{
+		const uint32_t r = readPos.load( std::memory_order_relaxed );
+		if( r == writePos.load( std::memory_order_acquire ) )
+			return nullptr;
+		return &slots[ r % capacity ];
+	}
+
+	// Consumer: release the slot returned by peek
+	void pop()
+	{
+		readPos.store( readPos.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+		readPos.notify_all();
+	}
+
+	bool empty() const
+	{
+		return readPos.load( std::memory_order_acquire ) == writePos.load( std::memory_order_acquire );
+	}
+
+	// Position of the producer, for waitDelivered
+	uint32_t written() const
+	{
+		return writePos.load( std::memory_order_acquire );
+	}
+
+	// Wait until the consumer has delivered all messages before the specified position
+	void waitDelivered( uint32_t pos )
+	{
+		while( true )
+		{
+			const uint32_t r = readPos.load( std::memory_order_acquire );
+			if( (int32_t)( r - pos ) >= 0 )
+				return;
+			readPos.wait( r );
+		}
+	}
+
+	uint64_t droppedCount() const
+	{
+		return dropped.load( std::memory_order_relaxed );
+	}
+};
\ No newline at end of file
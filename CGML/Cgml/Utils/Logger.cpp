@@ -1,167 +1,506 @@
 #include "stdafx.h"
 #include "Logger.h"
+#include "LogRing.h"
 #include <cstdarg>
-#include <atlstr.h>
+#include <cstdio>
+#include <cwchar>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include "../../ComLightLib/comLightCommon.h"
 
+// The logger is asynchronous. Threads which produce messages format them into their own lock-free ring buffers,
+// a background thread appends HRESULT descriptions, converts encodings, and calls the sink.
+// Errors are the exception, they're delivered on the calling thread: the C# sink keeps the error text in a thread-static field,
+// which becomes the message of the exception thrown for the HRESULT code.
 namespace
 {
-	wchar_t* formatMessage( HRESULT hr )
+	using Cgml::eLogLevel;
+	using Cgml::eLoggerFlags;
+
+	// Append UTF-16 (Windows) or UTF-32 (elsewhere) string to UTF-8 one
+	void appendUtf8( std::string& dest, const wchar_t* rsi, size_t length )
+	{
+		const wchar_t* const rsiEnd = rsi + length;
+		while( rsi < rsiEnd )
+		{
+			uint32_t cp = (uint32_t)*rsi++;
+			if( cp >= 0xD800 && cp < 0xDC00 && rsi < rsiEnd && (uint32_t)*rsi >= 0xDC00 && (uint32_t)*rsi < 0xE000 )
+			{
+				// Surrogate pair
+				cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( (uint32_t)*rsi++ - 0xDC00 );
+			}
+
+			if( cp < 0x80 )
+				dest += (char)cp;
+			else if( cp < 0x800 )
+			{
+				dest += (char)( 0xC0 | ( cp >> 6 ) );
+				dest += (char)( 0x80 | ( cp & 0x3F ) );
+			}
+			else if( cp < 0x10000 )
+			{
+				dest += (char)( 0xE0 | ( cp >> 12 ) );
+				dest += (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+				dest += (char)( 0x80 | ( cp & 0x3F ) );
+			}
+			else
+			{
+				dest += (char)( 0xF0 | ( cp >> 18 ) );
+				dest += (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+				dest += (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+				dest += (char)( 0x80 | ( cp & 0x3F ) );
+			}
+		}
+	}
+
+	// Convert UTF-8 string to UTF-16 (Windows) or UTF-32 (elsewhere), replacing invalid sequences with U+FFFD
+	void makeWide( std::wstring& dest, const char* rsi )
+	{
+		dest.clear();
+		const uint8_t* s = (const uint8_t*)rsi;
+		while( 0 != *s )
+		{
+			uint32_t cp;
+			int tail;
+			const uint8_t c = *s++;
+			if( c < 0x80 )
+			{
+				cp = c;
+				tail = 0;
+			}
+			else if( ( c & 0xE0 ) == 0xC0 )
+			{
+				cp = c & 0x1F;
+				tail = 1;
+			}
+			else if( ( c & 0xF0 ) == 0xE0 )
+			{
+				cp = c & 0x0F;
+				tail = 2;
+			}
+			else if( ( c & 0xF8 ) == 0xF0 )
+			{
+				cp = c & 0x07;
+				tail = 3;
+			}
+			else
+			{
+				dest += (wchar_t)0xFFFD;
+				continue;
+			}
+
+			for( ; tail > 0; tail-- )
+			{
+				if( ( *s & 0xC0 ) != 0x80 )
+				{
+					cp = 0xFFFD;
+					break;
+				}
+				cp = ( cp << 6 ) | ( *s++ & 0x3F );
+			}
+
+			if constexpr( sizeof( wchar_t ) == 2 )
+			{
+				if( cp >= 0x10000 )
+				{
+					cp -= 0x10000;
+					dest += (wchar_t)( 0xD800 + ( cp >> 10 ) );
+					dest += (wchar_t)( 0xDC00 + ( cp & 0x3FF ) );
+					continue;
+				}
+			}
+			dest += (wchar_t)cp;
+		}
+	}
+
+	// Append human-readable description of the HRESULT code
+	void appendError( std::string& dest, int32_t hr )
 	{
-		wchar_t* err;
-		if( FormatMessage( FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM,
-			NULL,
+#ifdef _WIN32
+		wchar_t* err = nullptr;
+		if( FormatMessageW( FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM,
+			nullptr,
 			hr,
 			MAKELANGID( LANG_NEUTRAL, SUBLANG_DEFAULT ),
-			(LPTSTR)&err,
+			(LPWSTR)&err,
 			0,
 			nullptr ) )
-			return err;
-		return nullptr;
+		{
+			size_t len = wcslen( err );
+			while( len > 0 && iswspace( err[ len - 1 ] ) )
+				len--;
+			appendUtf8( dest, err, len );
+			LocalFree( (HLOCAL)err );
+			return;
+		}
+#endif
+		char buffer[ 64 ];
+		snprintf( buffer, sizeof( buffer ), "error code %i (0x%08X)", hr, (uint32_t)hr );
+		dest += buffer;
 	}
 
-	class Utf
+	// Owns the ring buffer of the current thread, marks it abandoned when the thread exits
+	struct ThreadRing
+	{
+		LogRing* ring = nullptr;
+		bool isConsumer = false;
+
+		~ThreadRing()
+		{
+			if( nullptr != ring )
+				ring->abandoned.store( true, std::memory_order_release );
+		}
+	};
+	thread_local ThreadRing ts_ring;
+
+	// Reused by the producers for the UTF-16 messages and the errors, which are rare
+	thread_local std::wstring ts_wide;
+	thread_local std::string ts_narrow;
+	thread_local std::string ts_buffer;
+	// Set while the current thread calls the sink, errors logged by the sink are queued instead of delivered recursively
+	thread_local bool ts_delivering = false;
+
+	class Logger
 	{
-		CStringA utf8;
-		CStringW utf16;
+		// Settings, written under the setupLock, the atomics are read without locks by the producers
+		std::atomic<eLogLevel> level = eLogLevel::Error;
+		std::atomic_bool enabled = false;
+		std::mutex setupLock;
+		Cgml::sLoggerSetup setup;
 
-		void appendError( HRESULT hr )
+		// Buffers of all producer threads; they're never deleted, buffers of the exited threads are reused by the new ones
+		std::mutex registryLock;
+		std::vector<std::unique_ptr<LogRing>> rings;
+
+		std::atomic_uint64_t nextSequence = 0;
+		// Incremented by the producers after every message, the consumer sleeps on this value
+		std::atomic_uint32_t posted = 0;
+		std::once_flag consumerStarted;
+
+		// Consumer state
+		uint64_t droppedReported = 0;
+		std::vector<LogRing*> snapshot;
+		std::string buffer;
+		std::wstring wide;
+
+		inline bool hasFlag( eLoggerFlags bit ) const
 		{
-			const wchar_t* err = formatMessage( hr );
-			if( nullptr != err )
+			return 0 != ( (uint8_t)setup.flags & (uint8_t)bit );
+		}
+
+		LogRing* threadRing()
+		{
+			ThreadRing& tr = ts_ring;
+			if( nullptr != tr.ring )
+				return tr.ring;
+
+			std::call_once( consumerStarted, [ this ]()
 			{
-				utf16 += err;
-				LocalFree( (HLOCAL)err );
-				utf16.TrimRight();
+				// The thread is never joined: it may outlive the static destructors when the DLL is unloaded,
+				// that's why the logger is allocated on the heap and leaked.
+				std::thread( &Logger::consumerThread, this ).detach();
+			} );
+
+			std::lock_guard<std::mutex> lock{ registryLock };
+			for( const auto& r : rings )
+			{
+				// Once abandoned and drained, nobody writes into the buffer anymore
+				if( r->abandoned.load( std::memory_order_acquire ) && r->empty() )
+				{
+					r->abandoned.store( false, std::memory_order_relaxed );
+					tr.ring = r.get();
+					return tr.ring;
+				}
 			}
-			else
-				utf16.AppendFormat( L"error code %i (0x%08X)", hr, hr );
+			rings.emplace_back( std::make_unique<LogRing>() );
+			tr.ring = rings.back().get();
+			return tr.ring;
 		}
 
-	public:
-		const char* print( const char* pszFormat, std::va_list va )
+		// Deliver a single message to the sink, and to the standard error; the caller owns the temporary strings
+		void deliver( eLogLevel lvl, const char* message, bool hasCode, int32_t code, std::string& formatted, std::wstring& utf16 )
 		{
-			utf8.FormatV( pszFormat, va );
-			return utf8;
+			if( hasCode && !hasFlag( eLoggerFlags::SkipFormatMessage ) )
+			{
+				formatted = message;
+				formatted += ": ";
+				appendError( formatted, code );
+				message = formatted.c_str();
+			}
+
+			auto pfn = setup.sink;
+			if( nullptr != pfn )
+				pfn( setup.context, lvl, message );
+
+			if( hasFlag( eLoggerFlags::UseStandardError ) )
+			{
+				makeWide( utf16, message );
+				fwprintf( stderr, L"%ls\n", utf16.c_str() );
+			}
 		}
-		const wchar_t* print( const wchar_t* pszFormat, std::va_list va )
+
+		// Deliver a queued message on the consumer thread
+		void deliver( eLogLevel lvl, const char* message, bool hasCode, int32_t code )
 		{
-			utf16.FormatV( pszFormat, va );
-			return utf16;
+			deliver( lvl, message, hasCode, code, buffer, wide );
 		}
-		const wchar_t* upcast( const char* message, int len )
+
+		// Deliver all queued messages, in the order of their sequence numbers
+		void drain()
 		{
-			int count = MultiByteToWideChar( CP_UTF8, 0, message, len, nullptr, 0 );
-			if( count == 0 )
-				return nullptr;
-			wchar_t* b = utf16.GetBufferSetLength( len + 1 );
-			count = MultiByteToWideChar( CP_UTF8, 0, message, len, b, len );
-			utf16.ReleaseBuffer( count );
-			return utf16;
+			{
+				// The producers only take that lock when a thread logs for the first time
+				std::lock_guard<std::mutex> registry{ registryLock };
+				snapshot.clear();
+				for( const auto& r : rings )
+					snapshot.push_back( r.get() );
+			}
+
+			std::lock_guard<std::mutex> settings{ setupLock };
+			while( true )
+			{
+				LogRing* next = nullptr;
+				LogMessage* msg = nullptr;
+				for( LogRing* r : snapshot )
+				{
+					LogMessage* m = r->peek();
+					if( nullptr != m && ( nullptr == msg || m->sequence < msg->sequence ) )
+					{
+						msg = m;
+						next = r;
+					}
+				}
+				if( nullptr == msg )
+					break;
+
+				deliver( msg->level, msg->message(), msg->hasCode, msg->code );
+				if( nullptr != msg->heap )
+				{
+					free( msg->heap );
+					msg->heap = nullptr;
+				}
+				next->pop();
+			}
+
+			uint64_t dropped = 0;
+			for( LogRing* r : snapshot )
+				dropped += r->droppedCount();
+			if( dropped != droppedReported )
+			{
+				char message[ 96 ];
+				snprintf( message, sizeof( message ), "%llu log messages were dropped because the queue was full", (unsigned long long)( dropped - droppedReported ) );
+				droppedReported = dropped;
+				if( (uint8_t)eLogLevel::Warning <= (uint8_t)setup.level )
+					deliver( eLogLevel::Warning, message, false, 0 );
+			}
 		}
-		int utf8Length() const
+
+		void consumerThread()
 		{
-			return utf8.GetLength();
+			ts_ring.isConsumer = true;
+			while( true )
+			{
+				const uint32_t seen = posted.load( std::memory_order_acquire );
+				drain();
+				posted.wait( seen );
+			}
 		}
-		const wchar_t* printError( HRESULT hr, const char* pszFormat, std::va_list va )
+
+		void publish( LogRing* ring )
 		{
-			print( pszFormat, va );
-			upcast( utf8, utf8.GetLength() );
-			utf16 += L": ";
-			appendError( hr );
-			return utf16;
+			ring->endWrite();
+			posted.fetch_add( 1, std::memory_order_release );
+			posted.notify_one();
 		}
-		const char* downcast()
+
+		// The consumer thread can't wait for itself, it queues the errors like other messages
+		static bool deliverOnCallingThread( eLogLevel lvl )
 		{
-			int count = WideCharToMultiByte( CP_UTF8, 0, utf16, utf16.GetLength(), nullptr, 0, nullptr, nullptr );
-			char* s = utf8.GetBufferSetLength( count + 1 );
-			count = WideCharToMultiByte( CP_UTF8, 0, utf16, utf16.GetLength(), s, count, nullptr, nullptr );
-			utf8.ReleaseBufferSetLength( count );
-			return utf8;
+			return lvl == eLogLevel::Error && !ts_ring.isConsumer && !ts_delivering;
 		}
-	};
-	thread_local Utf ts_utf;
-	using Cgml::eLoggerFlags;
 
-	class Logger : Cgml::sLoggerSetup
-	{
-		inline bool hasFlag( eLoggerFlags bit ) const
+		// Deliver the message on the calling thread, after the messages queued by that thread before
+		void deliverNow( eLogLevel lvl, const char* message, bool hasCode, int32_t code )
 		{
-			return 0 != ( (uint8_t)flags & (uint8_t)bit );
+			LogRing* const ring = ts_ring.ring;
+			if( nullptr != ring )
+				ring->waitDelivered( ring->written() );
+
+			std::lock_guard<std::mutex> lock{ setupLock };
+			ts_delivering = true;
+			deliver( lvl, message, hasCode, code, ts_buffer, ts_wide );
+			ts_delivering = false;
 		}
 
-		bool useStdError() const
+		LogMessage* beginMessage( LogRing* ring, eLogLevel lvl, bool hasCode, int32_t code )
 		{
-			return hasFlag( eLoggerFlags::UseStandardError );
+			LogMessage* msg = ring->beginWrite();
+			if( nullptr == msg )
+				return nullptr;
+			msg->sequence = nextSequence.fetch_add( 1, std::memory_order_relaxed );
+			msg->heap = nullptr;
+			msg->code = code;
+			msg->level = lvl;
+			msg->hasCode = hasCode;
+			return msg;
 		}
 
-		static void writeStdError( Cgml::eLogLevel lvl, const char* message, int len )
+		// Copy the string into the message, for messages formatted elsewhere
+		static void setText( LogMessage& msg, const std::string& text )
 		{
-			const wchar_t* w = ts_utf.upcast( message, len );
-			if( nullptr != w )
-				fwprintf( stderr, L"%s\n", w );
+			if( text.length() < LogMessage::inlineLength )
+			{
+				memcpy( msg.text, text.c_str(), text.length() + 1 );
+				return;
+			}
+			msg.heap = (char*)malloc( text.length() + 1 );
+			if( nullptr != msg.heap )
+				memcpy( msg.heap, text.c_str(), text.length() + 1 );
+			else
+			{
+				memcpy( msg.text, text.c_str(), LogMessage::inlineLength - 1 );
+				msg.text[ LogMessage::inlineLength - 1 ] = '\0';
+			}
 		}
 
 	public:
-		Logger()
+
+		void message( eLogLevel lvl, bool hasCode, int32_t code, const char8_t* pszFormat, std::va_list va )
 		{
-			memset( this, 0, sizeof( Logger ) );
+			message( lvl, hasCode, code, (const char*)pszFormat, va );
 		}
 
-		bool willLog( Cgml::eLogLevel lvl ) const
+		bool willLog( eLogLevel lvl ) const
 		{
-			if( (uint8_t)lvl > (uint8_t)level )
+			if( (uint8_t)lvl > (uint8_t)level.load( std::memory_order_relaxed ) )
 				return false;
-			if( useStdError() )
-				return true;
-			return nullptr != sink;
+			return enabled.load( std::memory_order_relaxed );
 		}
 
-		void message( Cgml::eLogLevel lvl, const char8_t* pszFormat, std::va_list va ) const
+		void message( eLogLevel lvl, bool hasCode, int32_t code, const char* pszFormat, std::va_list va )
 		{
-			const char* s = ts_utf.print( (const char*)pszFormat, va );
-			auto pfn = sink;
-			if( nullptr != pfn )
-				pfn( context, lvl, s );
-			if( useStdError() )
-				writeStdError( lvl, s, ts_utf.utf8Length() );
+			if( deliverOnCallingThread( lvl ) )
+			{
+				std::string& s = ts_narrow;
+				std::va_list copy;
+				va_copy( copy, va );
+				const int len = vsnprintf( nullptr, 0, pszFormat, copy );
+				va_end( copy );
+				if( len >= 0 )
+				{
+					s.resize( (size_t)len );
+					vsnprintf( s.data(), (size_t)len + 1, pszFormat, va );
+				}
+				else
+					s = "<invalid format string>";
+				deliverNow( lvl, s.c_str(), hasCode, code );
+				return;
+			}
+
+			LogRing* const ring = threadRing();
+			LogMessage* msg = beginMessage( ring, lvl, hasCode, code );
+			if( nullptr == msg )
+				return;
+
+			// Format straight into the ring buffer, without memory allocations for the typical short messages
+			std::va_list copy;
+			va_copy( copy, va );
+			const int len = vsnprintf( msg->text, LogMessage::inlineLength, pszFormat, va );
+			if( len >= (int)LogMessage::inlineLength )
+			{
+				char* heap = (char*)malloc( (size_t)len + 1 );
+				if( nullptr != heap )
+				{
+					vsnprintf( heap, (size_t)len + 1, pszFormat, copy );
+					msg->heap = heap;
+				}
+			}
+			else if( len < 0 )
+				strcpy( msg->text, "<invalid format string>" );
+			va_end( copy );
+
+			publish( ring );
 		}
-		void message( Cgml::eLogLevel lvl, const wchar_t* pszFormat, std::va_list va ) const
+
+		void message( eLogLevel lvl, bool hasCode, int32_t code, const wchar_t* pszFormat, std::va_list va )
 		{
-			Utf& u = ts_utf;
-			const wchar_t* w = u.print( pszFormat, va );
-			auto pfn = sink;
-			if( nullptr != pfn )
-				pfn( context, lvl, u.downcast() );
-			if( useStdError() )
-				fwprintf( stderr, L"%s\n", w );
+			std::wstring& w = ts_wide;
+			if( w.size() < 256 )
+				w.resize( 256 );
+			int len;
+			while( true )
+			{
+				std::va_list copy;
+				va_copy( copy, va );
+				len = vswprintf( w.data(), w.size(), pszFormat, copy );
+				va_end( copy );
+				// vswprintf returns a negative number when the buffer is too small
+				if( len >= 0 || w.size() >= 0x10000 )
+					break;
+				w.resize( w.size() * 2 );
+			}
+			if( len < 0 )
+				len = (int)wcsnlen( w.data(), w.size() );
+
+			std::string& s = ts_narrow;
+			s.clear();
+			appendUtf8( s, w.data(), (size_t)len );
+
+			if( deliverOnCallingThread( lvl ) )
+			{
+				deliverNow( lvl, s.c_str(), hasCode, code );
+				return;
+			}
+
+			LogRing* const ring = threadRing();
+			LogMessage* msg = beginMessage( ring, lvl, hasCode, code );
+			if( nullptr == msg )
+				return;
+			setText( *msg, s );
+			publish( ring );
 		}
-		void message( Cgml::eLogLevel lvl, HRESULT hr, const char* pszFormat, std::va_list va ) const
+
+		void operator=( const Cgml::sLoggerSetup& rsi )
 		{
-			if( hasFlag( eLoggerFlags::SkipFormatMessage ) )
-			{
-				message( lvl, (const char8_t*)pszFormat, va );
+			// Deliver the queued messages with the old sink, the caller might be about to release it
+			flush();
+			std::lock_guard<std::mutex> lock{ setupLock };
+			setup = rsi;
+			level.store( rsi.level, std::memory_order_relaxed );
+			const bool stdError = 0 != ( (uint8_t)rsi.flags & (uint8_t)eLoggerFlags::UseStandardError );
+			enabled.store( stdError || nullptr != rsi.sink, std::memory_order_release );
+		}
+
+		// Wait until all the queued messages are delivered
+		void flush()
+		{
+			if( ts_ring.isConsumer )
 				return;
+			std::vector<std::pair<LogRing*, uint32_t>> pending;
+			{
+				std::lock_guard<std::mutex> lock{ registryLock };
+				for( const auto& r : rings )
+					if( !r->empty() )
+						pending.emplace_back( r.get(), r->written() );
 			}
-			Utf& u = ts_utf;
-			const wchar_t* w = ts_utf.printError( hr, (const char*)pszFormat, va );
-			auto pfn = sink;
-			if( nullptr != pfn )
-				pfn( context, lvl, u.downcast() );
-			if( useStdError() )
-				fwprintf( stderr, L"%s\n", w );
+			for( auto p : pending )
+				p.first->waitDelivered( p.second );
 		}
 
-		void operator=( const sLoggerSetup& rsi )
+		uint64_t droppedMessages()
 		{
-			sink = rsi.sink;
-			context = rsi.context;
-			level = rsi.level;
-			flags = rsi.flags;
+			std::lock_guard<std::mutex> lock{ registryLock };
+			uint64_t dropped = 0;
+			for( const auto& r : rings )
+				dropped += r->droppedCount();
+			return dropped;
 		}
 	};
 
-	static Logger s_logger;
+	// Allocated on the heap and never destroyed, because the consumer thread is never joined
+	static Logger& s_logger = *new Logger();
 }
 
 bool willLogMessage( Cgml::eLogLevel lvl )
@@ -169,14 +508,17 @@ bool willLogMessage( Cgml::eLogLevel lvl )
 	return s_logger.willLog( lvl );
 }
 
-using Cgml::eLogLevel;
+uint64_t __stdcall loggerDroppedMessages()
+{
+	return s_logger.droppedMessages();
+}
 
 #define LOG_MESSAGE_IMPL( lvl )                \
 	if( !s_logger.willLog( lvl ) )             \
 		return;                                \
 	std::va_list args;                         \
 	va_start( args, pszFormat );               \
-	s_logger.message( lvl, pszFormat, args );  \
+	s_logger.message( lvl, false, 0, pszFormat, args );  \
 	va_end( args );
 
 void logError( const char8_t* pszFormat, ... )
@@ -218,7 +560,7 @@ void logDebug16( const wchar_t* pszFormat, ... )
 		return;                                \
 	std::va_list args;                         \
 	va_start( args, pszFormat );               \
-	s_logger.message( lvl, hr, (const char*)pszFormat, args );  \
+	s_logger.message( lvl, true, (int32_t)hr, (const char*)pszFormat, args );  \
 	va_end( args );
 
 void logErrorHr( long hr, const char8_t* pszFormat, ... )
@@ -18,6 +18,9 @@ void logDebug16( const wchar_t* pszFormat, ... );
 
 bool willLogMessage( Cgml::eLogLevel lvl );
 
+// Count of log messages dropped because the queue was full, exported from the DLL
+uint64_t __stdcall loggerDroppedMessages();
+
 #ifdef  __cplusplus
 }
 #endif
@@ -0,0 +1,247 @@
+#include "stdafx.h"
+#include "CpuProfiler.h"
+
+namespace
+{
+	std::atomic_uint64_t nextInstance = 1;
+
+	// The cached buffer of the calling thread, for the most recently used profiler
+	struct ThreadCache
+	{
+		uint64_t instance = 0;
+		void* buffer = nullptr;
+	};
+	thread_local ThreadCache threadCache;
+
+	// Convert elapsed time of the clock into 100-nanosecond ticks
+	template<class Clock>
+	inline uint64_t makeTicks( typename Clock::rep elapsed )
+	{
+		using Ticks = std::chrono::duration<int64_t, std::ratio<1, 10'000'000>>;
+		const int64_t ticks = std::chrono::duration_cast<Ticks>( typename Clock::duration( elapsed ) ).count();
+		return (uint64_t)std::max( ticks, (int64_t)0 );
+	}
+}
+
+CpuProfiler::CpuProfiler() :
+	instance( nextInstance++ )
+{ }
+
+CpuProfiler::ThreadBuffer& CpuProfiler::threadBuffer()
+{
+	ThreadCache& cache = threadCache;
+	if( cache.instance == instance )
+		return *(ThreadBuffer*)cache.buffer;
+
+	// Slow path, only taken when the thread switches between profilers
+	const std::thread::id tid = std::this_thread::get_id();
+	std::lock_guard<std::mutex> guard{ lock };
+	ThreadBuffer* tb = nullptr;
+	for( const auto& b : buffers )
+	{
+		if( b->thread == tid )
+		{
+			tb = b.get();
+			break;
+		}
+	}
+	if( nullptr == tb )
+	{
+		buffers.emplace_back( std::make_unique<ThreadBuffer>() );
+		tb = buffers.back().get();
+		tb->thread = tid;
+		tb->events.reserve( 1024 );
+	}
+	cache.instance = instance;
+	cache.buffer = tb;
+	return *tb;
+}
+
+inline void CpuProfiler::addEvent( ThreadBuffer& tb, eEvent evt, uint16_t id )
+{
+	Event& e = tb.events.emplace_back();
+	e.id = id;
+	e.event = evt;
+	// Query the clock last, so the time of the vector reallocation is not included in the measure which follows
+	e.time = Clock::now().time_since_epoch().count();
+}
+
+void CpuProfiler::aggregate( ThreadBuffer& tb )
+{
+	struct BlockState
+	{
+		uint16_t id;
+		uint16_t shader;
+		Clock::rep timeStart;
+		Clock::rep shaderStart;
+	};
+	std::vector<BlockState> stack;
+	stack.reserve( 8 );
+
+	std::lock_guard<std::mutex> guard{ lock };
+	const bool capture = timeline.enabled();
+
+	auto addTimeline = [ & ]( Clock::rep start, Clock::rep end, Cgml::eProfilerMeasure what, size_t depth, uint16_t id )
+	{
+		Cgml::ProfilerEvent pe;
+		pe.start = makeTicks<Clock>( start - timelineOrigin );
+		pe.end = makeTicks<Clock>( end - timelineOrigin );
+		pe.what = what;
+		pe.depth = (uint8_t)depth;
+		pe.id = id;
+		timeline.add( pe );
+	};
+
+	auto completeShader = [ & ]( Clock::rep time )
+	{
+		BlockState& bs = stack.back();
+		if( bs.shader == EmptyShader )
+			return;
+		collection.shader( bs.shader ).add( makeTicks<Clock>( time - bs.shaderStart ) );
+		if( capture )
+			addTimeline( bs.shaderStart, time, Cgml::eProfilerMeasure::Shader, stack.size(), bs.shader );
+		bs.shader = EmptyShader;
+	};
+
+	for( const Event& e : tb.events )
+	{
+		switch( e.event )
+		{
+		case eEvent::BlockStart:
+			if( !stack.empty() )
+				completeShader( e.time );
+			stack.push_back( BlockState{ e.id, EmptyShader, e.time, 0 } );
+			break;
+		case eEvent::Shader:
+			assert( !stack.empty() );
+			completeShader( e.time );
+			stack.back().shader = e.id;
+			stack.back().shaderStart = e.time;
+			break;
+		case eEvent::BlockEnd:
+		{
+			assert( !stack.empty() );
+			completeShader( e.time );
+			const BlockState& bs = stack.back();
+			collection.block( bs.id ).add( makeTicks<Clock>( e.time - bs.timeStart ) );
+			if( capture )
+				addTimeline( bs.timeStart, e.time, Cgml::eProfilerMeasure::Block, stack.size() - 1, bs.id );
+			stack.pop_back();
+			break;
+		}
+		}
+	}
+	assert( stack.empty() );
+	// clear() keeps the capacity, no memory allocations in the steady state
+	tb.events.clear();
+}
+
+HRESULT CpuProfiler::blockStart( uint16_t which ) noexcept
+{
+	try
+	{
+		ThreadBuffer& tb = threadBuffer();
+		addEvent( tb, eEvent::BlockStart, which );
+		tb.depth++;
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT CpuProfiler::blockEnd() noexcept
+{
+	try
+	{
+		ThreadBuffer& tb = threadBuffer();
+		if( 0 == tb.depth )
+		{
+			logError( u8"iContext.profilerBlockEnd called without a matching profilerBlockStart" );
+			return E_FAIL;
+		}
+		addEvent( tb, eEvent::BlockEnd, EmptyShader );
+		tb.depth--;
+
+		if( 0 == tb.depth )
+			aggregate( tb );
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT CpuProfiler::computeShader( uint16_t cs ) noexcept
+{
+	try
+	{
+		ThreadBuffer& tb = threadBuffer();
+		if( 0 == tb.depth )
+		{
+			logError( u8"You can only dispatch compute shaders while inside a profiler block" );
+			return E_FAIL;
+		}
+		addEvent( tb, eEvent::Shader, cs );
+		return S_OK;
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+bool CpuProfiler::anyBlocksOpen() const
+{
+	for( const auto& b : buffers )
+		if( 0 != b->depth )
+			return true;
+	return false;
+}
+
+HRESULT CpuProfiler::getData( Cgml::pfnProfilerData pfn, void* pv ) noexcept
+{
+	std::lock_guard<std::mutex> guard{ lock };
+	if( anyBlocksOpen() )
+	{
+		logError( u8"iContext.profilerGetData should be called after the measures have stopped" );
+		return E_FAIL;
+	}
+	return collection.getData( pfn, pv );
+}
+
+HRESULT CpuProfiler::getPercentiles( const float* percentiles, int count, Cgml::pfnProfilerPercentiles pfn, void* pv, bool reset ) noexcept
+{
+	std::lock_guard<std::mutex> guard{ lock };
+	if( anyBlocksOpen() )
+	{
+		logError( u8"iContext.profilerGetPercentiles should be called after the measures have stopped" );
+		return E_FAIL;
+	}
+	return collection.getPercentiles( percentiles, count, pfn, pv, reset );
+}
+
+HRESULT CpuProfiler::captureTimeline( uint32_t capacity ) noexcept
+{
+	std::lock_guard<std::mutex> guard{ lock };
+	if( anyBlocksOpen() )
+	{
+		logError( u8"iContext.profilerCaptureTimeline should be called outside of the profiler blocks" );
+		return E_FAIL;
+	}
+	timelineOrigin = Clock::now().time_since_epoch().count();
+	return timeline.setCapacity( capacity );
+}
+
+HRESULT CpuProfiler::getTimeline( Cgml::pfnProfilerEvents pfn, void* pv ) noexcept
+{
+	std::lock_guard<std::mutex> guard{ lock };
+	if( anyBlocksOpen() )
+	{
+		logError( u8"iContext.profilerGetTimeline should be called after the measures have stopped" );
+		return E_FAIL;
+	}
+	return timeline.getData( pfn, pv );
+}
\ No newline at end of file
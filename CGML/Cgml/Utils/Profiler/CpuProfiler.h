@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include "iProfiler.h"
+#include "ProfileCollection.h"
+#include "TimelineCapture.h"
+
+// Backend-neutral profiler which measures wall clock time with std::chrono::steady_clock
+// The events are appended to per-thread buffers without locks, the aggregation into ProfileCollection happens when the top-level block ends.
+// When the compute shaders run on the GPU, the measured shader time is the CPU cost of binding and dispatching them.
+class CpuProfiler: public iProfiler
+{
+	using Clock = std::chrono::steady_clock;
+	static constexpr uint16_t EmptyShader = ~(uint16_t)0;
+
+	enum struct eEvent: uint8_t
+	{
+		BlockStart,
+		BlockEnd,
+		Shader
+	};
+
+	struct Event
+	{
+		Clock::rep time;
+		uint16_t id;
+		eEvent event;
+	};
+
+	// Events recorded by a single thread; only that thread writes into the buffer
+	struct ThreadBuffer
+	{
+		std::thread::id thread;
+		std::vector<Event> events;
+		// Count of the blocks started but not yet ended; atomic because getData() reads it from another thread
+		std::atomic_uint32_t depth = 0;
+	};
+
+	// Unique ID of this profiler, to validate the thread-local cache of the buffer
+	const uint64_t instance;
+
+	// Protects the list of buffers, and the collection
+	std::mutex lock;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	ProfileCollection collection;
+	TimelineCapture timeline;
+	// Clock time when the timeline capture has started
+	Clock::rep timelineOrigin = 0;
+
+	ThreadBuffer& threadBuffer();
+	void addEvent( ThreadBuffer& tb, eEvent evt, uint16_t id );
+	void aggregate( ThreadBuffer& tb );
+	// The caller must hold the lock
+	bool anyBlocksOpen() const;
+
+public:
+
+	CpuProfiler();
+
+	HRESULT computeShader( uint16_t cs ) noexcept override final;
+
+	HRESULT blockStart( uint16_t which ) noexcept override final;
+	HRESULT blockEnd() noexcept override final;
+
+	HRESULT getData( Cgml::pfnProfilerData pfn, void* pv ) noexcept override final;
+	HRESULT getPercentiles( const float* percentiles, int count, Cgml::pfnProfilerPercentiles pfn, void* pv, bool reset ) noexcept override final;
+
+	HRESULT captureTimeline( uint32_t capacity ) noexcept override final;
+	HRESULT getTimeline( Cgml::pfnProfilerEvents pfn, void* pv ) noexcept override final;
+};
\ No newline at end of file
@@ -6,6 +6,7 @@ inline void GpuProfiler::sProfilerData::reset()
 {
 	_mm_storeu_si128( ( __m128i* ) ( &callsPending ), _mm_setzero_si128() );
 	timeMax = 0;
+	samplesPending.clear();
 }
 
 inline void GpuProfiler::sProfilerData::addPending( int64_t time )
@@ -13,13 +14,25 @@ inline void GpuProfiler::sProfilerData::addPending( int64_t time )
 	callsPending++;
 	timePending += time;
 	timeMax = std::max( timeMax, (uint64_t)time );
+	try
+	{
+		// clear() keeps the capacity, this only allocates memory for the first few measures
+		samplesPending.push_back( (uint64_t)time );
+	}
+	catch( const std::bad_alloc& )
+	{
+		throw E_OUTOFMEMORY;
+	}
 }
 
 inline void GpuProfiler::sProfilerData::makeTime( uint64_t freq )
 {
-	dest->count += callsPending;
-	dest->totalTicks += ::makeTime( timePending, freq );
-	dest->max = std::max( dest->max, ::makeTime( timeMax, freq ) );
+	Cgml::ProfilerMeasure& m = dest->measure;
+	m.count += callsPending;
+	m.totalTicks += ::makeTime( timePending, freq );
+	m.max = std::max( m.max, ::makeTime( timeMax, freq ) );
+	for( uint64_t s : samplesPending )
+		dest->histogram.add( ::makeTime( s, freq ) );
 
 	reset();
 }
@@ -149,6 +162,7 @@ void GpuProfiler::BlockState::completePrevShader( uint64_t time, GpuProfiler& pr
 		dest = &res;
 	}
 	dest->addPending( elapsed );
+	profiler.timelineAdd( shaderStart, (int64_t)time, Cgml::eProfilerMeasure::Shader, (uint8_t)( depth + 1 ), prevShader );
 
 #if PROFILER_COLLECT_TAGS
 	if( 0 != prevShaderTag )
@@ -188,6 +202,7 @@ void GpuProfiler::BlockState::haveTimestamp( eEvent evt, uint16_t cs, uint16_t t
 		assert( cs == EmptyShader );
 		completePrevShader( time, profiler );
 		destBlock->addPending( (int64_t)time - timeStart );
+		profiler.timelineAdd( timeStart, (int64_t)time, Cgml::eProfilerMeasure::Block, depth, id );
 		timeStart = -1;
 		return;
 	case eEvent::Shader:
@@ -239,9 +254,11 @@ HRESULT GpuProfiler::blockStart( uint16_t which ) noexcept
 			BlockState& block = blockStates[ which ];
 			block.destBlock = &results[ ~which ];
 			block.destBlock->dest = &collection.block( which );
+			block.id = which;
 			bs = &block;
 		}
 		bs->parentBlock = parentBlock;
+		bs->depth = (uint8_t)stack.size();
 		queries.submit( bs, eEvent::BlockStart );
 		stack.push_back( bs );
 		return S_OK;
@@ -274,6 +291,7 @@ HRESULT GpuProfiler::blockEnd() noexcept
 			// On nVidia 1080Ti, that frequency is 1E+9 = 1 GHz
 			const uint64_t freq = dtsd.Frequency;
 			resultsMakeTime( freq );
+			timelineMakeTime( freq );
 		}
 		else
 		{
@@ -281,6 +299,7 @@ HRESULT GpuProfiler::blockEnd() noexcept
 			// that caused the timestamp counter to become discontinuous or disjoint, such as unplugging the AC cord on a laptop, overheating, or throttling up/down due to laptop savings events.
 			// The timestamp returned by ID3D11DeviceContext::GetData for a timestamp query is only reliable if Disjoint is FALSE.
 			resultsReset();
+			timelinePending.clear();
 		}
 
 		renderDocCapture.reset();
@@ -346,4 +365,91 @@ HRESULT GpuProfiler::getData( Cgml::pfnProfilerData pfn, void* pv ) noexcept
 	}
 
 	return collection.getData( pfn, pv );
+}
+
+HRESULT GpuProfiler::getPercentiles( const float* percentiles, int count, Cgml::pfnProfilerPercentiles pfn, void* pv, bool reset ) noexcept
+{
+	if( !stack.empty() )
+	{
+		logError( u8"iContext.profilerGetPercentiles should be called after the measures have stopped" );
+		return E_FAIL;
+	}
+
+	return collection.getPercentiles( percentiles, count, pfn, pv, reset );
+}
+
+void GpuProfiler::timelineAdd( int64_t start, int64_t end, Cgml::eProfilerMeasure what, uint8_t depth, uint16_t id )
+{
+	if( !timeline.enabled() )
+		return;
+	try
+	{
+		timelinePending.push_back( PendingEvent{ start, end, what, depth, id } );
+	}
+	catch( const std::bad_alloc& )
+	{
+		throw E_OUTOFMEMORY;
+	}
+}
+
+namespace
+{
+	// Convert GPU ticks into 100-nanosecond ticks; unlike makeTime(), doesn't overflow for long captures
+	inline uint64_t makeTimeLong( int64_t ticks, uint64_t freq )
+	{
+		if( ticks <= 0 )
+			return 0;
+		const uint64_t t = (uint64_t)ticks;
+		return ( t / freq ) * 10'000'000 + makeTime( t % freq, freq );
+	}
+}
+
+void GpuProfiler::timelineMakeTime( uint64_t freq )
+{
+	if( timelinePending.empty() )
+		return;
+	if( timeline.enabled() )
+	{
+		if( timelineOrigin < 0 )
+		{
+			// The first event of the capture, the top-level block has the earliest start time
+			timelineOrigin = timelinePending.front().start;
+			for( const PendingEvent& e : timelinePending )
+				timelineOrigin = std::min( timelineOrigin, e.start );
+		}
+
+		for( const PendingEvent& e : timelinePending )
+		{
+			Cgml::ProfilerEvent pe;
+			pe.start = makeTimeLong( e.start - timelineOrigin, freq );
+			pe.end = makeTimeLong( e.end - timelineOrigin, freq );
+			pe.what = e.what;
+			pe.depth = e.depth;
+			pe.id = e.id;
+			timeline.add( pe );
+		}
+	}
+	timelinePending.clear();
+}
+
+HRESULT GpuProfiler::captureTimeline( uint32_t capacity ) noexcept
+{
+	if( !stack.empty() )
+	{
+		logError( u8"iContext.profilerCaptureTimeline should be called outside of the profiler blocks" );
+		return E_FAIL;
+	}
+	timelinePending.clear();
+	timelineOrigin = -1;
+	return timeline.setCapacity( capacity );
+}
+
+HRESULT GpuProfiler::getTimeline( Cgml::pfnProfilerEvents pfn, void* pv ) noexcept
+{
+	if( !stack.empty() )
+	{
+		logError( u8"iContext.profilerGetTimeline should be called after the measures have stopped" );
+		return E_FAIL;
+	}
+	return timeline.getData( pfn, pv );
 }
\ No newline at end of file
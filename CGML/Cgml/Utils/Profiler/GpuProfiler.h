@@ -1,10 +1,13 @@
 #pragma once
 #include <optional>
+#include <atlcoll.h>
+#include "iProfiler.h"
 #include "ProfileCollection.h"
+#include "TimelineCapture.h"
 #include "DelayExecution.h"
 #include <D3D/RenderDoc/renderDoc.h>
 
-class GpuProfiler
+class GpuProfiler: public iProfiler
 {
 	ID3D11Device* const device;
 	ID3D11DeviceContext* const context;
@@ -67,6 +70,9 @@ class GpuProfiler
 		uint16_t prevShader = EmptyShader;
 		uint16_t prevShaderTag = 0;
 		BlockState* parentBlock = nullptr;
+		uint16_t id = 0;
+		// Nesting level of the block, for the timeline
+		uint8_t depth = 0;
 		void haveTimestamp( eEvent evt, uint16_t cs, uint16_t tag, uint64_t time, GpuProfiler& profiler );
 	private:
 		void completePrevShader( uint64_t time, GpuProfiler& profiler );
@@ -83,7 +89,10 @@ class GpuProfiler
 		// Maximum time spent, expressed in GPU ticks
 		uint64_t timeMax;
 
-		Cgml::ProfilerMeasure* dest;
+		// Individual measures expressed in GPU ticks, for the histogram
+		std::vector<uint64_t> samplesPending;
+
+		ProfileCollection::Entry* dest;
 
 		inline void makeTime( uint64_t freq );
 		inline void addPending( int64_t time );
@@ -104,6 +113,22 @@ class GpuProfiler
 #endif
 
 	ProfileCollection collection;
+
+	// Timeline events expressed in GPU ticks, waiting for the disjoint data of the top-level block
+	struct PendingEvent
+	{
+		int64_t start, end;
+		Cgml::eProfilerMeasure what;
+		uint8_t depth;
+		uint16_t id;
+	};
+	std::vector<PendingEvent> timelinePending;
+	// GPU time of the first captured event, or -1 when nothing was captured yet
+	int64_t timelineOrigin = -1;
+	TimelineCapture timeline;
+	void timelineAdd( int64_t start, int64_t end, Cgml::eProfilerMeasure what, uint8_t depth, uint16_t id );
+	void timelineMakeTime( uint64_t freq );
+
 	std::optional<DirectCompute::CaptureRaii> renderDocCapture;
 
 	void resultsMakeTime( uint64_t freq );
@@ -115,10 +140,14 @@ public:
 
 	HRESULT create( size_t maxDepth = 8 );
 
-	HRESULT computeShader( uint16_t cs ) noexcept;
+	HRESULT computeShader( uint16_t cs ) noexcept override final;
+
+	HRESULT blockStart( uint16_t which ) noexcept override final;
+	HRESULT blockEnd() noexcept override final;
 
-	HRESULT blockStart( uint16_t which ) noexcept;
-	HRESULT blockEnd() noexcept;
+	HRESULT getData( Cgml::pfnProfilerData pfn, void* pv ) noexcept override final;
+	HRESULT getPercentiles( const float* percentiles, int count, Cgml::pfnProfilerPercentiles pfn, void* pv, bool reset ) noexcept override final;
 
-	HRESULT getData( Cgml::pfnProfilerData pfn, void* pv ) noexcept;
+	HRESULT captureTimeline( uint32_t capacity ) noexcept override final;
+	HRESULT getTimeline( Cgml::pfnProfilerEvents pfn, void* pv ) noexcept override final;
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "stdafx.h"
+#include "LatencyHistogram.h"
+#include <bit>
+#include <cmath>
+
+size_t LatencyHistogram::bucketIndex( uint64_t val )
+{
+	// Setting the subBuckets bit makes the shift 0 for the small values, they go into the exact buckets [ 0 .. subBuckets ) without a branch.
+	// For larger values, ( val >> shift ) is in [ subBuckets .. 2 * subBuckets ) interval: the highest bit adds 1 to the power of 2, the next 4 bits select the linear bucket within it.
+	const uint32_t shift = (uint32_t)std::bit_width( val | subBuckets ) - ( subBucketBits + 1 );
+	return ( (size_t)shift << subBucketBits ) + (size_t)( val >> shift );
+}
+
+uint64_t LatencyHistogram::bucketMaxValue( size_t idx )
+{
+	if( idx < subBuckets )
+		return idx;
+
+	const uint32_t shift = (uint32_t)( idx >> subBucketBits ) - 1;
+	const uint64_t sub = idx & ( subBuckets - 1 );
+	const uint64_t lowest = ( subBuckets + sub ) << shift;
+	return lowest + ( ( 1ull << shift ) - 1 );
+}
+
+void LatencyHistogram::reset()
+{
+	buckets.fill( 0 );
+	totalCount = 0;
+}
+
+uint64_t LatencyHistogram::percentile( double p ) const
+{
+	if( 0 == totalCount )
+		return 0;
+
+	p = std::clamp( p, 0.0, 100.0 );
+	// 1-based rank of the value, nearest-rank method
+	uint64_t rank = (uint64_t)std::ceil( p * 0.01 * (double)totalCount );
+	rank = std::clamp( rank, (uint64_t)1, totalCount );
+
+	uint64_t acc = 0;
+	for( size_t i = 0; i < countBuckets; i++ )
+	{
+		acc += buckets[ i ];
+		if( acc >= rank )
+			return bucketMaxValue( i );
+	}
+	assert( false );
+	return bucketMaxValue( countBuckets - 1 );
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+
+// Log-linear histogram of time measures in 100-nanosecond ticks, similar to HdrHistogram
+// Every power of 2 is split into 16 linear buckets, the relative error of the percentiles is under 6.25%.
+// The memory is fixed, about 4kb per histogram, recording a value is a few instructions without branches on the hot path.
+class LatencyHistogram
+{
+	static constexpr uint32_t subBucketBits = 4;
+	static constexpr uint32_t subBuckets = 1u << subBucketBits;
+	// Values below subBuckets have exact buckets, the rest of the 64-bit range uses subBuckets buckets per power of 2
+	static constexpr size_t countBuckets = subBuckets + ( 64 - subBucketBits ) * subBuckets;
+
+	std::array<uint32_t, countBuckets> buckets;
+	uint64_t totalCount;
+
+	static size_t bucketIndex( uint64_t val );
+	// Largest value which goes into the bucket
+	static uint64_t bucketMaxValue( size_t idx );
+
+public:
+	LatencyHistogram()
+	{
+		reset();
+	}
+
+	void reset();
+
+	void add( uint64_t val )
+	{
+		buckets[ bucketIndex( val ) ]++;
+		totalCount++;
+	}
+
+	uint64_t count() const
+	{
+		return totalCount;
+	}
+
+	// Compute the percentile of the recorded values, the argument is in [ 0 .. 100 ] interval.
+	// The result is the upper bound of the bucket which contains the percentile; 0 if the histogram is empty.
+	uint64_t percentile( double p ) const;
+};
\ No newline at end of file
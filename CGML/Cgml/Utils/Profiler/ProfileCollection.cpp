@@ -37,13 +37,13 @@ namespace
 	};
 }
 
-Cgml::ProfilerMeasure& ProfileCollection::block( uint16_t id )
+ProfileCollection::Entry& ProfileCollection::block( uint16_t id )
 {
 	const uint32_t key = makeKey( id, eProfilerMeasure::Block );
 	return measures[ key ];
 }
 
-Cgml::ProfilerMeasure& ProfileCollection::shader( uint16_t id )
+ProfileCollection::Entry& ProfileCollection::shader( uint16_t id )
 {
 	const uint32_t key = makeKey( id, eProfilerMeasure::Shader );
 	return measures[ key ];
@@ -54,21 +54,74 @@ HRESULT ProfileCollection::getData( Cgml::pfnProfilerData pfn, void* pv ) noexce
 	std::vector<ProfilerResult> vec;
 	try
 	{
-		vec.reserve( measures.GetCount() );
+		vec.reserve( measures.size() );
 	}
 	catch( const std::bad_alloc& )
 	{
 		return E_OUTOFMEMORY;
 	}
 
-	for( POSITION pos = measures.GetStartPosition(); nullptr != pos; )
+	for( const auto& pair : measures )
 	{
-		auto pair = measures.GetNext( pos );
-		vec.emplace_back( makeResult( pair->m_key, pair->m_value ) );
+		// Entries are reset in place by getPercentiles, skip the empty ones
+		if( 0 != pair.second.measure.count )
+			vec.emplace_back( makeResult( pair.first, pair.second.measure ) );
 	}
 
 	if( vec.empty() )
 		return S_FALSE;
 	std::sort( vec.begin(), vec.end(), SortResults{} );
 	return pfn( vec.data(), (int)vec.size(), pv );
+}
+
+HRESULT ProfileCollection::getPercentiles( const float* percentiles, int count, Cgml::pfnProfilerPercentiles pfn, void* pv, bool reset ) noexcept
+{
+	if( count < 0 || ( count > 0 && nullptr == percentiles ) )
+		return E_INVALIDARG;
+
+	std::vector<std::pair<ProfilerResult, const LatencyHistogram*>> sorted;
+	std::vector<ProfilerResult> vec;
+	std::vector<uint64_t> values;
+	try
+	{
+		sorted.reserve( measures.size() );
+		for( const auto& pair : measures )
+		{
+			if( 0 != pair.second.measure.count )
+				sorted.emplace_back( makeResult( pair.first, pair.second.measure ), &pair.second.histogram );
+		}
+		if( sorted.empty() )
+			return S_FALSE;
+
+		std::sort( sorted.begin(), sorted.end(), []( const auto& a, const auto& b ) { return SortResults{}( a.first, b.first ); } );
+
+		vec.reserve( sorted.size() );
+		values.reserve( sorted.size() * (size_t)count );
+		for( const auto& e : sorted )
+		{
+			vec.push_back( e.first );
+			for( int i = 0; i < count; i++ )
+			{
+				// The upper bound of the bucket may exceed the maximum measured value
+				const uint64_t val = e.second->percentile( percentiles[ i ] );
+				values.push_back( std::min( val, e.first.result.max ) );
+			}
+		}
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	if( reset )
+	{
+		// Other profiler objects keep pointers to these entries, reset them in place instead of erasing
+		for( auto& pair : measures )
+		{
+			pair.second.measure.reset();
+			pair.second.histogram.reset();
+		}
+	}
+
+	return pfn( vec.data(), values.data(), (uint32_t)vec.size(), pv );
 }
\ No newline at end of file
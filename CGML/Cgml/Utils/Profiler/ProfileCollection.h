@@ -1,15 +1,32 @@
 #pragma once
 #include "../../API/profiler.h"
-#include <atlcoll.h>
+#include "LatencyHistogram.h"
+#include <unordered_map>
 
 class ProfileCollection
 {
-	CAtlMap<uint32_t, Cgml::ProfilerMeasure> measures;
-
 public:
+	// Accumulated measure, and the histogram of the individual values
+	struct Entry
+	{
+		Cgml::ProfilerMeasure measure;
+		LatencyHistogram histogram;
+
+		void add( uint64_t val )
+		{
+			measure.add( val );
+			histogram.add( val );
+		}
+	};
 
-	Cgml::ProfilerMeasure& block( uint16_t id );
-	Cgml::ProfilerMeasure& shader( uint16_t id );
+	Entry& block( uint16_t id );
+	Entry& shader( uint16_t id );
 
 	HRESULT getData( Cgml::pfnProfilerData pfn, void* pv ) noexcept;
+
+	// Compute the requested percentiles of all measures, and optionally reset the collection
+	HRESULT getPercentiles( const float* percentiles, int count, Cgml::pfnProfilerPercentiles pfn, void* pv, bool reset ) noexcept;
+
+private:
+	std::unordered_map<uint32_t, Entry> measures;
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "stdafx.h"
+#include "TimelineCapture.h"
+
+HRESULT TimelineCapture::setCapacity( uint32_t capacity ) noexcept
+{
+	try
+	{
+		ring.clear();
+		ring.shrink_to_fit();
+		ring.resize( capacity );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+	nextEvent = 0;
+	wrapped = false;
+	return S_OK;
+}
+
+HRESULT TimelineCapture::getData( Cgml::pfnProfilerEvents pfn, void* pv ) const noexcept
+{
+	if( !wrapped )
+	{
+		if( 0 == nextEvent )
+			return S_FALSE;
+		return pfn( ring.data(), (uint32_t)nextEvent, pv );
+	}
+
+	// The buffer has wrapped around, rotate into a temporary vector
+	std::vector<Cgml::ProfilerEvent> vec;
+	try
+	{
+		vec.reserve( ring.size() );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+	vec.insert( vec.end(), ring.begin() + nextEvent, ring.end() );
+	vec.insert( vec.end(), ring.begin(), ring.begin() + nextEvent );
+	return pfn( vec.data(), (uint32_t)vec.size(), pv );
+}
\ No newline at end of file
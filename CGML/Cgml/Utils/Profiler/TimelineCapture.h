@@ -0,0 +1,36 @@
+#pragma once
+#include "../../API/profiler.h"
+
+// Bounded ring buffer with the raw timeline of the profiler events
+// When full, the oldest events are overwritten.
+class TimelineCapture
+{
+	std::vector<Cgml::ProfilerEvent> ring;
+	size_t nextEvent = 0;
+	bool wrapped = false;
+
+public:
+
+	bool enabled() const
+	{
+		return !ring.empty();
+	}
+
+	// Drop the captured events, and set the capacity of the buffer. Zero capacity disables the capture.
+	HRESULT setCapacity( uint32_t capacity ) noexcept;
+
+	void add( const Cgml::ProfilerEvent& e )
+	{
+		assert( enabled() );
+		ring[ nextEvent ] = e;
+		nextEvent++;
+		if( nextEvent == ring.size() )
+		{
+			nextEvent = 0;
+			wrapped = true;
+		}
+	}
+
+	// Pass the captured events to the callback, oldest first
+	HRESULT getData( Cgml::pfnProfilerEvents pfn, void* pv ) const noexcept;
+};
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include "../../API/profiler.h"
+
+// Interface of the profiler used by the context.
+// GpuProfiler measures GPU time with D3D11 timestamp queries, CpuProfiler measures wall clock time on the CPU.
+struct iProfiler
+{
+	virtual ~iProfiler() { }
+
+	// A compute shader is about to run; the time until the next event is accounted to that shader
+	virtual HRESULT computeShader( uint16_t cs ) noexcept = 0;
+
+	virtual HRESULT blockStart( uint16_t which ) noexcept = 0;
+	virtual HRESULT blockEnd() noexcept = 0;
+
+	// Produce the accumulated measures, sorted by type then time
+	virtual HRESULT getData( Cgml::pfnProfilerData pfn, void* pv ) noexcept = 0;
+
+	// Produce the requested percentiles of the measures, and optionally reset all measures after the snapshot
+	virtual HRESULT getPercentiles( const float* percentiles, int count, Cgml::pfnProfilerPercentiles pfn, void* pv, bool reset ) noexcept = 0;
+
+	// Drop the captured timeline, and start capturing the last `capacity` events. Zero capacity disables the capture.
+	virtual HRESULT captureTimeline( uint32_t capacity ) noexcept = 0;
+
+	// Produce the captured timeline, oldest events first
+	virtual HRESULT getTimeline( Cgml::pfnProfilerEvents pfn, void* pv ) noexcept = 0;
+};
\ No newline at end of file
@@ -98,4 +98,23 @@ inline bool checkF16cSuppport()
 	int cpuInfo[ 4 ];
 	__cpuid( cpuInfo, 1 );
 	return ( cpuInfo[ 2 ] & ( 1 << 29 ) ) != 0;
+}
+
+inline bool checkAvx512Support()
+{
+	// AVX512F, AVX512BW and AVX512VL, https://en.wikipedia.org/wiki/CPUID#EAX=7,_ECX=0:_Extended_Features
+	int cpuInfo[ 4 ];
+	__cpuidex( cpuInfo, 7, 0 );
+	constexpr uint32_t features = ( 1u << 16 ) | ( 1u << 30 ) | ( 1u << 31 );
+	if( ( (uint32_t)cpuInfo[ 1 ] & features ) != features )
+		return false;
+
+	// XGETBV instruction faults unless the OS has enabled it, OSXSAVE bit in CPUID.1:ECX
+	__cpuid( cpuInfo, 1 );
+	if( 0 == ( cpuInfo[ 2 ] & ( 1 << 27 ) ) )
+		return false;
+
+	// The OS must preserve opmask and ZMM registers, https://en.wikipedia.org/wiki/Control_register#XCR0_and_XSS
+	constexpr uint64_t xcr0 = 0xE6;
+	return ( _xgetbv( 0 ) & xcr0 ) == xcr0;
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "stdafx.h"
+#include "parallelFor.h"
+#include <atomic>
+#include <thread>
+
+namespace
+{
+	struct Context
+	{
+		pfnParallelJob pfn;
+		void* pv;
+		size_t length;
+		std::atomic_size_t next = 0;
+		volatile HRESULT status = S_OK;
+
+		// Run jobs until the work is complete, or one of them failed
+		void run()
+		{
+			while( true )
+			{
+				if( FAILED( status ) )
+					return;
+				const size_t i = next++;
+				if( i >= length )
+					return;
+
+				HRESULT hr;
+				try
+				{
+					hr = pfn( i, pv );
+				}
+				catch( const std::bad_alloc& )
+				{
+					hr = E_OUTOFMEMORY;
+				}
+				catch( const std::exception& )
+				{
+					hr = E_FAIL;
+				}
+
+				if( FAILED( hr ) )
+				{
+					InterlockedCompareExchange( &status, hr, S_OK );
+					return;
+				}
+			}
+		}
+	};
+
+	void __stdcall workCallback( PTP_CALLBACK_INSTANCE Instance, PVOID pv, PTP_WORK Work )
+	{
+		( (Context*)pv )->run();
+	}
+}
+
+HRESULT parallelFor( pfnParallelJob pfn, void* context, size_t length, size_t maxThreads )
+{
+	if( 0 == length )
+		return S_OK;
+
+	size_t threads = std::thread::hardware_concurrency();
+	if( 0 != maxThreads )
+		threads = std::min( threads, maxThreads );
+	threads = std::min( threads, length );
+
+	Context ctx;
+	ctx.pfn = pfn;
+	ctx.pv = context;
+	ctx.length = length;
+
+	if( threads <= 1 )
+	{
+		ctx.run();
+		return ctx.status;
+	}
+
+	PTP_WORK work = CreateThreadpoolWork( &workCallback, &ctx, nullptr );
+	if( nullptr == work )
+		return getLastHr();
+
+	// The calling thread is one of the workers
+	for( size_t i = 1; i < threads; i++ )
+		SubmitThreadpoolWork( work );
+	ctx.run();
+
+	WaitForThreadpoolWorkCallbacks( work, FALSE );
+	CloseThreadpoolWork( work );
+	return ctx.status;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+// Callback for parallelFor function, called once for each index
+using pfnParallelJob = HRESULT( * )( size_t i, void* context );
+
+// Run the callback for every index in [ 0 .. length ) interval, using the calling thread plus the Windows thread pool.
+// Returns after all callbacks have completed, or the first failed status code.
+HRESULT parallelFor( pfnParallelJob pfn, void* context, size_t length, size_t maxThreads = 0 );
+
+// Same as above, for lambdas which take size_t argument and return HRESULT
+template<class Lambda>
+inline HRESULT parallelFor( size_t length, Lambda& lambda, size_t maxThreads = 0 )
+{
+	pfnParallelJob pfn = []( size_t i, void* pv ) -> HRESULT
+	{
+		Lambda& l = *(Lambda*)pv;
+		return l( i );
+	};
+	return parallelFor( pfn, &lambda, length, maxThreads );
+}
\ No newline at end of file
@@ -1,31 +1,34 @@
 #include "stdafx.h"
 #include "tensorLoadTransforms.h"
 #include "Compression/bcml1.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
 
 namespace
 {
-	__forceinline void makeIeeeFp16( uint16_t* pointer )
+	__forceinline __m128i bf16ToFp16( __m128i iv )
 	{
-		__m128i* const p = ( __m128i* )pointer;
-		__m128i iv = _mm_loadu_si128( p );
-
 		__m256i integers = _mm256_cvtepu16_epi32( iv );
 		integers = _mm256_slli_epi32( integers, 16 );
 
 		__m256 floats = _mm256_castsi256_ps( integers );
-		iv = _mm256_cvtps_ph( floats, _MM_FROUND_TO_NEAREST_INT );
-
-		_mm_storeu_si128( p, iv );
+		return _mm256_cvtps_ph( floats, _MM_FROUND_TO_NEAREST_INT );
 	}
 
-	static void __declspec( noinline ) makeIeeeFp16( uint16_t* buffer, size_t length )
+	// The source and destination are allowed to be the same buffer
+	static void __declspec( noinline ) makeIeeeFp16( const void* source, void* dest, size_t length )
 	{
+		const uint16_t* rsi = (const uint16_t*)source;
+		uint16_t* rdi = (uint16_t*)dest;
+
 		constexpr size_t maskAlign8 = ~(size_t)7;
-		uint16_t* const endAligned = buffer + ( length & maskAlign8 );
+		const uint16_t* const rsiEndAligned = rsi + ( length & maskAlign8 );
 		const size_t rem = length % 8;
 
-		for( ; buffer < endAligned; buffer += 8 )
-			makeIeeeFp16( buffer );
+		for( ; rsi < rsiEndAligned; rsi += 8, rdi += 8 )
+			_mm_storeu_si128( ( __m128i* )rdi, bf16ToFp16( _mm_loadu_si128( ( const __m128i* )rsi ) ) );
 
 		if( 0 == rem )
 			return;
@@ -35,15 +38,16 @@ namespace
 		// That's why the roundtrip pointer -> stack -> registers -> stack -> pointer
 		uint16_t remainder[ 8 ];
 		_mm_storeu_si128( ( __m128i* )( &remainder[ 0 ] ), _mm_setzero_si128() );
-		__movsw( remainder, buffer, rem );
-		makeIeeeFp16( remainder );
-		__movsw( buffer, remainder, rem );
+		__movsw( remainder, rsi, rem );
+		_mm_storeu_si128( ( __m128i* )( &remainder[ 0 ] ), bf16ToFp16( _mm_loadu_si128( ( const __m128i* )( &remainder[ 0 ] ) ) ) );
+		__movsw( rdi, remainder, rem );
 	}
 
-	static void __declspec( noinline ) downcastFp32Floats( void* pv, size_t length )
+	// The destination is allowed to be the start of the source buffer, because the output is written behind the input
+	static void __declspec( noinline ) downcastFp32Floats( const void* source, void* dest, size_t length )
 	{
-		const float* rsi = (const float*)pv;
-		uint16_t* rdi = (uint16_t*)pv;
+		const float* rsi = (const float*)source;
+		uint16_t* rdi = (uint16_t*)dest;
 
 		constexpr size_t maskAlign8 = ~(size_t)7;
 		const float* const rsiEndAligned = rsi + ( length & maskAlign8 );
@@ -65,52 +69,422 @@ namespace
 			__movsd( (DWORD*)( &sourceBuffer[ 0 ] ), (const DWORD*)( rsi ), rem );
 			__stosd( (DWORD*)( &sourceBuffer[ rem ] ), 0, 8 - rem );
 
-			__m256 floats = _mm256_loadu_ps( rsi );
+			__m256 floats = _mm256_loadu_ps( &sourceBuffer[ 0 ] );
 			__m128i f16 = _mm256_cvtps_ph( floats, _MM_FROUND_TO_NEAREST_INT );
 			_mm_storeu_si128( ( __m128i* )( &resultBuffer[ 0 ] ), f16 );
 			__movsw( rdi, &resultBuffer[ 0 ], rem );
 		}
 	}
-}
 
-HRESULT Cgml::loadTransform( eLoadTransform tform, eDataType& dt, DXGI_FORMAT& viewFormat, void* pv, size_t& bytes, size_t elements )
-{
-	assert( tform != eLoadTransform::None );
-	if( tform == eLoadTransform::Fp16MakeIeee )
+	__forceinline __m256i bf16ToFp16( __m256i iv )
 	{
-		if( dt != eDataType::BF16 )
-			return S_OK;
+		__m512i integers = _mm512_cvtepu16_epi32( iv );
+		integers = _mm512_slli_epi32( integers, 16 );
+		return _mm512_cvtps_ph( _mm512_castsi512_ps( integers ), _MM_FROUND_TO_NEAREST_INT );
+	}
+
+	// AVX-512 version of the BF16 to FP16 conversion, 16 elements per iteration
+	static void __declspec( noinline ) makeIeeeFp16Avx512( const void* source, void* dest, size_t length )
+	{
+		const uint16_t* rsi = (const uint16_t*)source;
+		uint16_t* rdi = (uint16_t*)dest;
+
+		constexpr size_t maskAlign16 = ~(size_t)15;
+		const uint16_t* const rsiEndAligned = rsi + ( length & maskAlign16 );
+		const size_t rem = length % 16;
 
-		if( Bcml1::checkExtensionFlags( Bcml1::eCpuExtensionFlags::AVX2 | Bcml1::eCpuExtensionFlags::F16C ) )
+		for( ; rsi < rsiEndAligned; rsi += 16, rdi += 16 )
+			_mm256_storeu_si256( ( __m256i* )rdi, bf16ToFp16( _mm256_loadu_si256( ( const __m256i* )rsi ) ) );
+
+		if( 0 != rem )
 		{
-			makeIeeeFp16( (uint16_t*)pv, elements );
-			dt = eDataType::FP16;
-			viewFormat = DXGI_FORMAT_R16_FLOAT;
-			return S_OK;
+			// Unlike AVX2, AVX512BW has masked loads and stores for 2-byte lanes
+			const __mmask16 mask = (__mmask16)( ( 1u << rem ) - 1 );
+			__m256i iv = _mm256_maskz_loadu_epi16( mask, rsi );
+			_mm256_mask_storeu_epi16( rdi, mask, bf16ToFp16( iv ) );
 		}
-		else
+	}
+
+	// AVX-512 version of the FP32 to FP16 conversion, 16 elements per iteration
+	static void __declspec( noinline ) downcastFp32FloatsAvx512( const void* source, void* dest, size_t length )
+	{
+		const float* rsi = (const float*)source;
+		uint16_t* rdi = (uint16_t*)dest;
+
+		constexpr size_t maskAlign16 = ~(size_t)15;
+		const float* const rsiEndAligned = rsi + ( length & maskAlign16 );
+		const size_t rem = length % 16;
+
+		for( ; rsi < rsiEndAligned; rsi += 16, rdi += 16 )
+		{
+			__m256i f16 = _mm512_cvtps_ph( _mm512_loadu_ps( rsi ), _MM_FROUND_TO_NEAREST_INT );
+			_mm256_storeu_si256( ( __m256i* )rdi, f16 );
+		}
+
+		if( 0 != rem )
+		{
+			const __mmask16 mask = (__mmask16)( ( 1u << rem ) - 1 );
+			__m256i f16 = _mm512_cvtps_ph( _mm512_maskz_loadu_ps( mask, rsi ), _MM_FROUND_TO_NEAREST_INT );
+			_mm256_mask_storeu_epi16( rdi, mask, f16 );
+		}
+	}
+
+	// Round FP32 to BF16, to nearest even
+	__forceinline __m128i fp32ToBf16( __m256 f )
+	{
+		const __m256i u = _mm256_castps_si256( f );
+		// Add 0x7FFF plus the lowest bit of the result, then truncate
+		__m256i lsb = _mm256_and_si256( _mm256_srli_epi32( u, 16 ), _mm256_set1_epi32( 1 ) );
+		__m256i rounded = _mm256_add_epi32( u, _mm256_add_epi32( lsb, _mm256_set1_epi32( 0x7FFF ) ) );
+		// The rounding would turn NaN into infinity, or flip the sign; keep the high half of NaN, setting the quiet bit
+		const __m256i nan = _mm256_castps_si256( _mm256_cmp_ps( f, f, _CMP_UNORD_Q ) );
+		rounded = _mm256_blendv_epi8( rounded, _mm256_or_si256( u, _mm256_set1_epi32( 0x400000 ) ), nan );
+		rounded = _mm256_srli_epi32( rounded, 16 );
+		// The values are in [ 0 .. 0xFFFF ] interval, the unsigned saturation doesn't change them
+		return _mm_packus_epi32( _mm256_castsi256_si128( rounded ), _mm256_extracti128_si256( rounded, 1 ) );
+	}
+
+	static void __declspec( noinline ) downcastBf16( const void* source, void* dest, size_t length )
+	{
+		const float* rsi = (const float*)source;
+		uint16_t* rdi = (uint16_t*)dest;
+
+		const float* const rsiEndAligned = rsi + ( length / 8 ) * 8;
+		const size_t rem = length % 8;
+		for( ; rsi < rsiEndAligned; rsi += 8, rdi += 8 )
+			_mm_storeu_si128( ( __m128i* )rdi, fp32ToBf16( _mm256_loadu_ps( rsi ) ) );
+
+		if( 0 != rem )
+		{
+			__m256 floats = _mm256_maskload_ps( rsi, makeAvxMask( rem ) );
+			uint16_t remainder[ 8 ];
+			_mm_storeu_si128( ( __m128i* )( &remainder[ 0 ] ), fp32ToBf16( floats ) );
+			__movsw( rdi, remainder, rem );
+		}
+	}
+
+	__forceinline __m256i fp32ToBf16( __m512 f )
+	{
+		const __m512i u = _mm512_castps_si512( f );
+		__m512i lsb = _mm512_and_si512( _mm512_srli_epi32( u, 16 ), _mm512_set1_epi32( 1 ) );
+		__m512i rounded = _mm512_add_epi32( u, _mm512_add_epi32( lsb, _mm512_set1_epi32( 0x7FFF ) ) );
+		const __mmask16 nan = _mm512_cmp_ps_mask( f, f, _CMP_UNORD_Q );
+		rounded = _mm512_mask_or_epi32( rounded, nan, u, _mm512_set1_epi32( 0x400000 ) );
+		return _mm512_cvtepi32_epi16( _mm512_srli_epi32( rounded, 16 ) );
+	}
+
+	static void __declspec( noinline ) downcastBf16Avx512( const void* source, void* dest, size_t length )
+	{
+		const float* rsi = (const float*)source;
+		uint16_t* rdi = (uint16_t*)dest;
+
+		const float* const rsiEndAligned = rsi + ( length / 16 ) * 16;
+		const size_t rem = length % 16;
+		for( ; rsi < rsiEndAligned; rsi += 16, rdi += 16 )
+			_mm256_storeu_si256( ( __m256i* )rdi, fp32ToBf16( _mm512_loadu_ps( rsi ) ) );
+
+		if( 0 != rem )
 		{
-			logError( u8"The specified tensor format transformation requires AVX2 and F16C support" );
-			return HRESULT_FROM_WIN32( ERROR_HV_CPUID_FEATURE_VALIDATION );
+			const __mmask16 mask = (__mmask16)( ( 1u << rem ) - 1 );
+			_mm256_mask_storeu_epi16( rdi, mask, fp32ToBf16( _mm512_maskz_loadu_ps( mask, rsi ) ) );
 		}
 	}
-	if( tform == eLoadTransform::Fp32DowncastIeee )
+
+	__forceinline __m256 upcast( __m128i iv, bool bf16 )
+	{
+		if( bf16 )
+			return _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_cvtepu16_epi32( iv ), 16 ) );
+		return _mm256_cvtph_ps( iv );
+	}
+
+	// Upcast FP16 or BF16 numbers into FP32
+	template<bool bf16>
+	static void __declspec( noinline ) upcastFloats( const void* source, void* dest, size_t length )
+	{
+		const uint16_t* rsi = (const uint16_t*)source;
+		float* rdi = (float*)dest;
+
+		const uint16_t* const rsiEndAligned = rsi + ( length / 8 ) * 8;
+		const size_t rem = length % 8;
+		for( ; rsi < rsiEndAligned; rsi += 8, rdi += 8 )
+			_mm256_storeu_ps( rdi, upcast( _mm_loadu_si128( ( const __m128i* )rsi ), bf16 ) );
+
+		if( 0 != rem )
+		{
+			uint16_t remainder[ 8 ];
+			_mm_storeu_si128( ( __m128i* )( &remainder[ 0 ] ), _mm_setzero_si128() );
+			__movsw( remainder, rsi, rem );
+			__m256 floats = upcast( _mm_loadu_si128( ( const __m128i* )( &remainder[ 0 ] ) ), bf16 );
+			_mm256_maskstore_ps( rdi, makeAvxMask( rem ), floats );
+		}
+	}
+
+	__forceinline __m512 upcast( __m256i iv, bool bf16 )
+	{
+		if( bf16 )
+			return _mm512_castsi512_ps( _mm512_slli_epi32( _mm512_cvtepu16_epi32( iv ), 16 ) );
+		return _mm512_cvtph_ps( iv );
+	}
+
+	template<bool bf16>
+	static void __declspec( noinline ) upcastFloatsAvx512( const void* source, void* dest, size_t length )
 	{
-		if( dt != eDataType::FP32 )
+		const uint16_t* rsi = (const uint16_t*)source;
+		float* rdi = (float*)dest;
+
+		const uint16_t* const rsiEndAligned = rsi + ( length / 16 ) * 16;
+		const size_t rem = length % 16;
+		for( ; rsi < rsiEndAligned; rsi += 16, rdi += 16 )
+			_mm512_storeu_ps( rdi, upcast( _mm256_loadu_si256( ( const __m256i* )rsi ), bf16 ) );
+
+		if( 0 != rem )
+		{
+			const __mmask16 mask = (__mmask16)( ( 1u << rem ) - 1 );
+			_mm512_mask_storeu_ps( rdi, mask, upcast( _mm256_maskz_loadu_epi16( mask, rsi ), bf16 ) );
+		}
+	}
+
+	using pfnConvert = void( * )( const void* rsi, void* rdi, size_t length );
+
+	// Conversion function of the load transformation, sizes of the elements, and the output type
+	struct sConversion
+	{
+		pfnConvert pfn = nullptr;
+		uint8_t cbSource = 0;
+		uint8_t cbDest = 0;
+		eDataType dataType = eDataType::FP16;
+		DXGI_FORMAT format = DXGI_FORMAT_R16_FLOAT;
+	};
+
+	using Bcml1::eCpuExtensionFlags;
+
+	// Select the conversion for the transformation and source data type
+	// Returns S_FALSE when the transformation doesn't apply to that data type
+	HRESULT getConversion( sConversion& rdi, eLoadTransform tform, eDataType dt )
+	{
+		const bool avx512 = Bcml1::checkExtensionFlags( eCpuExtensionFlags::AVX512 | eCpuExtensionFlags::F16C );
+		eCpuExtensionFlags required = eCpuExtensionFlags::AVX2 | eCpuExtensionFlags::F16C;
+		switch( tform )
+		{
+		case eLoadTransform::Fp16MakeIeee:
+			if( dt != eDataType::BF16 )
+				return S_FALSE;
+			rdi.pfn = avx512 ? &makeIeeeFp16Avx512 : &makeIeeeFp16;
+			rdi.cbSource = 2;
+			rdi.cbDest = 2;
+			break;
+		case eLoadTransform::Fp32DowncastIeee:
+			if( dt != eDataType::FP32 )
+				return S_FALSE;
+			rdi.pfn = avx512 ? &downcastFp32FloatsAvx512 : &downcastFp32Floats;
+			rdi.cbSource = 4;
+			rdi.cbDest = 2;
+			required = eCpuExtensionFlags::F16C;
+			break;
+		case eLoadTransform::Fp32DowncastBf16:
+			if( dt != eDataType::FP32 )
+				return S_FALSE;
+			rdi.pfn = avx512 ? &downcastBf16Avx512 : &downcastBf16;
+			rdi.cbSource = 4;
+			rdi.cbDest = 2;
+			rdi.dataType = eDataType::BF16;
+			rdi.format = DXGI_FORMAT_R16_UINT;
+			// BF16 rounding is integer math
+			required = eCpuExtensionFlags::AVX2;
+			break;
+		case eLoadTransform::Fp16Upcast:
+			if( dt == eDataType::FP16 )
+				rdi.pfn = avx512 ? &upcastFloatsAvx512<false> : &upcastFloats<false>;
+			else if( dt == eDataType::BF16 )
+			{
+				rdi.pfn = avx512 ? &upcastFloatsAvx512<true> : &upcastFloats<true>;
+				required = eCpuExtensionFlags::AVX2;
+			}
+			else
+				return S_FALSE;
+			rdi.cbSource = 2;
+			rdi.cbDest = 4;
+			rdi.dataType = eDataType::FP32;
+			rdi.format = DXGI_FORMAT_R32_FLOAT;
+			break;
+		default:
+			return E_NOTIMPL;
+		}
+
+		if( Bcml1::checkExtensionFlags( required ) )
 			return S_OK;
-		if( Bcml1::checkExtensionFlags( Bcml1::eCpuExtensionFlags::F16C ) )
+
+		// Name the instruction sets which are actually missing
+		auto isMissing = [ required ]( eCpuExtensionFlags f )
 		{
-			downcastFp32Floats( pv, elements );
-			dt = eDataType::FP16;
-			viewFormat = DXGI_FORMAT_R16_FLOAT;
-			bytes /= 2;
+			return 0 != ( (uint8_t)required & (uint8_t)f ) && !Bcml1::checkExtensionFlags( f );
+		};
+		const bool noAvx2 = isMissing( eCpuExtensionFlags::AVX2 );
+		const bool noF16c = isMissing( eCpuExtensionFlags::F16C );
+		const char* missing = ( noAvx2 && noF16c ) ? "AVX2 and F16C" : ( noAvx2 ? "AVX2" : "F16C" );
+		logError( u8"Tensor load transformation %i requires %s support, the CPU doesn't have it", (int)tform, missing );
+		return HRESULT_FROM_WIN32( ERROR_HV_CPUID_FEATURE_VALIDATION );
+	}
+
+	// Tensors are read and converted in chunks of this count of elements
+	constexpr size_t chunkElements = 1u << 20;
+
+	// When the conversion shrinks the elements, the source chunks are read into a ring of staging buffers of this length
+	constexpr size_t stagingSlots = 8;
+
+	// Reads chunks of the tensor from the stream on the calling thread, and converts them on the Windows thread pool
+	class ChunkedTransform
+	{
+		const sConversion conv;
+		const size_t elements;
+		const size_t chunks;
+		uint8_t* const rdi;
+		// When the element size is the same, the source chunks are read straight into the destination buffer and converted in place
+		std::vector<uint8_t> staging;
+
+		PTP_WORK work = nullptr;
+		// Every submitted work item converts the next chunk; chunks are submitted after they are read, in order
+		std::atomic_size_t nextChunk = 0;
+
+		std::mutex mutex;
+		std::condition_variable condVar;
+		std::array<bool, stagingSlots> slotBusy = {};
+		using Lock = std::unique_lock<std::mutex>;
+
+		static void __stdcall workCallbackStatic( PTP_CALLBACK_INSTANCE Instance, PVOID pv, PTP_WORK Work )
+		{
+			( (ChunkedTransform*)pv )->convertChunk( ( (ChunkedTransform*)pv )->nextChunk++ );
+		}
+
+		size_t chunkLength( size_t i ) const
+		{
+			return std::min( chunkElements, elements - i * chunkElements );
+		}
+
+		uint8_t* sourceChunk( size_t i )
+		{
+			if( staging.empty() )
+				return rdi + i * chunkElements * conv.cbSource;
+			return staging.data() + ( i % stagingSlots ) * chunkElements * conv.cbSource;
+		}
+
+		void convertChunk( size_t i )
+		{
+			conv.pfn( sourceChunk( i ), rdi + i * chunkElements * conv.cbDest, chunkLength( i ) );
+			if( staging.empty() )
+				return;
+
+			Lock lk{ mutex };
+			slotBusy[ i % stagingSlots ] = false;
+			condVar.notify_one();
+		}
+
+	public:
+
+		ChunkedTransform( const sConversion& c, size_t length, uint8_t* dest ) :
+			conv( c ), elements( length ), chunks( ( length + chunkElements - 1 ) / chunkElements ), rdi( dest ) { }
+
+		~ChunkedTransform()
+		{
+			if( nullptr != work )
+			{
+				WaitForThreadpoolWorkCallbacks( work, FALSE );
+				CloseThreadpoolWork( work );
+				work = nullptr;
+			}
+		}
+
+		HRESULT create()
+		{
+			if( conv.cbSource != conv.cbDest )
+			{
+				try
+				{
+					staging.resize( chunkElements * conv.cbSource * std::min( chunks, stagingSlots ) );
+				}
+				catch( const std::bad_alloc& )
+				{
+					return E_OUTOFMEMORY;
+				}
+			}
+
+			work = CreateThreadpoolWork( &workCallbackStatic, this, nullptr );
+			if( nullptr == work )
+				return getLastHr();
 			return S_OK;
 		}
+
+		HRESULT run( ComLight::iReadStream* stream )
+		{
+			for( size_t i = 0; i < chunks; i++ )
+			{
+				if( !staging.empty() )
+				{
+					// Wait for the pool to release the staging buffer
+					Lock lk{ mutex };
+					bool& busy = slotBusy[ i % stagingSlots ];
+					while( busy )
+						condVar.wait( lk );
+					busy = true;
+				}
+
+				// If the read fails, the destructor waits for the chunks already submitted
+				CHECK( stream->read( sourceChunk( i ), chunkLength( i ) * conv.cbSource ) );
+				SubmitThreadpoolWork( work );
+			}
+
+			WaitForThreadpoolWorkCallbacks( work, FALSE );
+			return S_OK;
+		}
+	};
+}
+
+HRESULT Cgml::readTransformed( eLoadTransform tform, eDataType& dt, DXGI_FORMAT& viewFormat, ComLight::iReadStream* stream, LargeBuffer& buffer, size_t& bytes, size_t elements )
+{
+	assert( tform != eLoadTransform::None );
+	sConversion conv;
+	const HRESULT hr = getConversion( conv, tform, dt );
+	CHECK( hr );
+	if( S_FALSE == hr )
+	{
+		// The transformation doesn't apply to the data type, read the tensor as is
+		CHECK( buffer.allocate( bytes ) );
+		return stream->read( buffer.pointer(), bytes );
+	}
+
+	CHECK( buffer.allocate( elements * conv.cbDest ) );
+	if( elements <= chunkElements )
+	{
+		// Small tensor, the thread pool ain't worth it
+		if( conv.cbSource == conv.cbDest )
+		{
+			CHECK( stream->read( buffer.pointer(), elements * conv.cbSource ) );
+			conv.pfn( buffer.pointer(), buffer.pointer(), elements );
+		}
 		else
 		{
-			logError( u8"The specified tensor format transformation requires F16C support" );
-			return HRESULT_FROM_WIN32( ERROR_HV_CPUID_FEATURE_VALIDATION );
+			std::vector<uint8_t> source;
+			try
+			{
+				source.resize( elements * conv.cbSource );
+			}
+			catch( const std::bad_alloc& )
+			{
+				return E_OUTOFMEMORY;
+			}
+			CHECK( stream->read( source.data(), source.size() ) );
+			conv.pfn( source.data(), buffer.pointer(), elements );
 		}
 	}
-	return E_NOTIMPL;
+	else
+	{
+		ChunkedTransform ct{ conv, elements, buffer.pointer() };
+		CHECK( ct.create() );
+		CHECK( ct.run( stream ) );
+	}
+
+	dt = conv.dataType;
+	viewFormat = conv.format;
+	bytes = elements * conv.cbDest;
+	return S_OK;
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
 #pragma once
 #include <API/sTensorDesc.h>
+#include "../../ComLightLib/streams.h"
+#include "LargeBuffer.h"
 
 namespace Cgml
 {
-	// Apply tensor load transformation, in place
-	HRESULT loadTransform( eLoadTransform tform, eDataType& dt, DXGI_FORMAT& viewFormat, void* pv, size_t& bytes, size_t elements );
+	// Read dense tensor from the stream into the newly allocated buffer, applying the load transformation.
+	// Large tensors are read in chunks, each chunk is converted on the thread pool while the next one is being read.
+	// When the transformation doesn't apply to the data type, the tensor is read without changes.
+	HRESULT readTransformed( eLoadTransform tform, eDataType& dt, DXGI_FORMAT& viewFormat, ComLight::iReadStream* stream, LargeBuffer& buffer, size_t& bytes, size_t elements );
 }
\ No newline at end of file
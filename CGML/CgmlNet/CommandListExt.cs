@@ -0,0 +1,56 @@
+﻿namespace Cgml;
+
+/// <summary>Extension methods for <see cref="iCommandList" /> COM interface</summary>
+public static class CommandListExt
+{
+	/// <summary>Replace constant buffer data of the <c>bindShader</c> call #index</summary>
+	public static void patchConstants<T>( this iCommandList list, int index, ref T cbData ) where T : unmanaged
+	{
+		unsafe
+		{
+			int len = sizeof( T );
+			fixed( T* ptr = &cbData )
+				list.patchConstants( index, (IntPtr)ptr, len );
+		}
+	}
+
+	/// <summary>Replace constant buffer data of the <c>bindShader</c> call #index</summary>
+	public static void patchConstants<T>( this iCommandList list, int index, ReadOnlySpan<T> cbData ) where T : unmanaged
+	{
+		unsafe
+		{
+			int len = sizeof( T ) * cbData.Length;
+			fixed( T* ptr = cbData )
+				list.patchConstants( index, (IntPtr)ptr, len );
+		}
+	}
+
+	/// <summary>Count of the recorded <c>bindShader</c> calls</summary>
+	public static int countShaders( this iCommandList list )
+	{
+		list.getSize( out int shaders, out int _ );
+		return shaders;
+	}
+
+	/// <summary>Find recorded <c>bindShader</c> calls of the shader</summary>
+	/// <returns>Indices of the <c>bindShader</c> calls for <see cref="iCommandList.patchConstants" />, and of the first <c>dispatch</c> calls after them for <see cref="iCommandList.patchDispatch" /></returns>
+	public static List<(int shader, int dispatch)> findShader( this iCommandList list, ushort id )
+	{
+		List<(int, int)> res = new List<(int, int)>();
+		int count = list.countShaders();
+		for( int i = 0; i < count; i++ )
+		{
+			list.getShader( i, out ushort s, out int dispatch );
+			if( s == id )
+				res.Add( (i, dispatch) );
+		}
+		return res;
+	}
+
+	/// <summary>Count of the recorded <c>dispatch</c> calls</summary>
+	public static int countDispatches( this iCommandList list )
+	{
+		list.getSize( out int _, out int dispatches );
+		return dispatches;
+	}
+}
\ No newline at end of file
@@ -158,6 +158,43 @@ public static class ContextExt
 		return result;
 	}
 
+	/// <summary>Get percentiles of the profiler measures, like p50, p90 and p99</summary>
+	/// <param name="context">The context</param>
+	/// <param name="percentiles">Requested percentiles in [ 0 .. 100 ] interval</param>
+	/// <param name="reset">Reset all measures after taking the snapshot, for periodic scraping</param>
+	public static ProfilerPercentiles[]? profilerGetPercentiles( this iContext context, float[] percentiles, bool reset = false )
+	{
+		ProfilerPercentiles[]? result = null;
+		pfnProfilerPercentilesUnsafe pfn = delegate ( ProfilerResult[] arr, IntPtr values, int length, IntPtr pv )
+		{
+			var res = new ProfilerPercentiles[ length ];
+			for( int i = 0; i < length; i++ )
+			{
+				TimeSpan[] row = new TimeSpan[ percentiles.Length ];
+				for( int j = 0; j < row.Length; j++ )
+					row[ j ] = TimeSpan.FromTicks( Marshal.ReadInt64( values, ( i * row.Length + j ) * 8 ) );
+				res[ i ] = new ProfilerPercentiles( arr[ i ], row );
+			}
+			result = res;
+			return 0;
+		};
+		context.profilerGetPercentiles( percentiles, percentiles.Length, pfn, IntPtr.Zero, reset );
+		return result;
+	}
+
+	/// <summary>Get the timeline captured after <see cref="iContext.profilerCaptureTimeline" />, oldest events first</summary>
+	public static ProfilerEvent[]? profilerGetTimeline( this iContext context )
+	{
+		ProfilerEvent[]? result = null;
+		pfnProfilerEventsUnsafe pfn = delegate ( ProfilerEvent[] arr, int length, IntPtr pv )
+		{
+			result = arr;
+			return 0;
+		};
+		context.profilerGetTimeline( pfn, IntPtr.Zero );
+		return result;
+	}
+
 	/// <summary>Begin a profiler block</summary>
 	public static ProfilerBlock profilerBlock( this iContext context, ushort id ) =>
 		new ProfilerBlock( context, id );
@@ -169,4 +206,13 @@ public static class ContextExt
 		Debug.Assert( tensor.getDesc().usage == eBufferUse.ReadWriteDownload );
 		context.download( tensor, null, IntPtr.Zero, eDownloadFlag.CopyToStaging );
 	}
+
+	/// <summary>True when the GPU has completed all commands submitted before the fence returned by <see cref="iContext.fenceSignal" /></summary>
+	/// <remarks>Not thread safe, same as <see cref="iContext.fenceCheck" /></remarks>
+	public static bool fenceComplete( this iContext context, ulong fence ) =>
+		0 != context.fenceCheck( fence, false );
+
+	/// <summary>Block the calling thread until the GPU completes all commands submitted before the fence</summary>
+	public static void fenceWait( this iContext context, ulong fence ) =>
+		context.fenceCheck( fence, true );
 }
\ No newline at end of file
@@ -14,6 +14,72 @@ public static class DeviceExt
 		}
 	}
 
+	/// <summary>Create immutable tensor in VRAM from llama.cpp block-quantized data in system memory</summary>
+	/// <param name="dev">Device</param>
+	/// <param name="size">Size of the tensor, in elements; the rows need to contain complete blocks of 32 elements</param>
+	/// <param name="layout">VRAM layout of the result</param>
+	/// <param name="type">Block format of the data</param>
+	/// <param name="data">Payload data</param>
+	public static iTensor uploadQuantizedTensor( this iDevice dev, in Int128 size, eTensorLayout layout, eGgmlType type, ReadOnlySpan<byte> data )
+	{
+		sTensorDesc desc = new sTensorDesc
+		{
+			shape = new TensorShape( size ),
+			dataType = eDataType.FP16,
+			usage = eBufferUse.Immutable,
+			layout = layout
+		};
+		unsafe
+		{
+			fixed( byte* rsi = data )
+				return dev.uploadQuantizedTensor( ref desc, type, (IntPtr)rsi, data.Length );
+		}
+	}
+
+	static unsafe void reshapeGptq<T>( iDevice dev, Span<uint> result, MatrixView<uint> qweight, MatrixView<T> scales, MatrixView<uint> qzeros, eGptqCodec codec ) where T : unmanaged
+	{
+		uint rows = qweight.size.x;
+		uint groups = ( qweight.size.y + 15 ) / 16;
+		if( scales.size != new uint2( rows, groups ) )
+			throw new ArgumentException( "Unexpected size of the scales matrix" );
+		if( qzeros.size != new uint2( ( rows + 7 ) / 8, groups ) )
+			throw new ArgumentException( "Unexpected size of the qzeros matrix" );
+
+		fixed( uint* rdi = result )
+		fixed( uint* w = qweight.span )
+		fixed( T* s = scales.span )
+		fixed( uint* z = qzeros.span )
+		{
+			sGptqTensor source = new sGptqTensor
+			{
+				qweight = (IntPtr)w,
+				scales = (IntPtr)s,
+				qzeros = (IntPtr)z,
+				rows = (int)rows,
+				rowLengthIntegers = (int)qweight.size.y
+			};
+			dev.reshapeGptq( (IntPtr)rdi, result.Length, ref source, codec );
+		}
+	}
+
+	/// <summary>Reshape GPTQ matrix with FP32 scales into BCML3 panels</summary>
+	/// <param name="dev">Device</param>
+	/// <param name="bc3">Output buffer, the length must be exact</param>
+	/// <param name="qweight">Quantized weights, X is the output row index</param>
+	/// <param name="scales">FP32 scales, one per 128 weights</param>
+	/// <param name="qzeros">Quantized zero points</param>
+	public static void reshapeBcml3( this iDevice dev, Span<uint> bc3, MatrixView<uint> qweight, MatrixView<float> scales, MatrixView<uint> qzeros ) =>
+		reshapeGptq( dev, bc3, qweight, scales, qzeros, eGptqCodec.BCML3 );
+
+	/// <summary>Reshape GPTQ matrix with FP16 scales into BCML4 panels</summary>
+	/// <param name="dev">Device</param>
+	/// <param name="bc4">Output buffer, the length must be exact</param>
+	/// <param name="qweight">Quantized weights, X is the output row index</param>
+	/// <param name="scales">FP16 scales, one per 128 weights</param>
+	/// <param name="qzeros">Quantized zero points</param>
+	public static void reshapeBcml4( this iDevice dev, Span<uint> bc4, MatrixView<uint> qweight, MatrixView<ushort> scales, MatrixView<uint> qzeros ) =>
+		reshapeGptq( dev, bc4, qweight, scales, qzeros, eGptqCodec.BCML4 );
+
 	/// <summary>Create a dense row major tensor of the specified size</summary>
 	/// <remarks>The initial content of the memory for the buffer is undefined.<br />
 	/// You need to write the buffer content some other way before the resource is read.</remarks>
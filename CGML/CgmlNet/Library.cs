@@ -26,6 +26,9 @@ public static class Library
 	[DllImport( dll, CallingConvention = RuntimeClass.defaultCallingConvention, PreserveSig = false )]
 	internal static extern void setupLogger( [In] ref sLoggerSetup setup );
 
+	[DllImport( dll, CallingConvention = CallingConvention.StdCall )]
+	internal static extern ulong loggerDroppedMessages();
+
 	/// <summary>Set up delegate to receive log messages from the C++ library</summary>
 	internal static void setLogSink( eLogLevel lvl, eLoggerFlags flags = eLoggerFlags.SkipFormatMessage, pfnLogMessage? pfn = null )
 	{
@@ -58,4 +58,8 @@ public static class Logger
 
 	/// <summary>True if messages of the specified level will be processed by the logger, and not discarded</summary>
 	public static bool willLogMessageOfLevel( eLogLevel lvl ) => lvl.willLog();
+
+	/// <summary>Count of the C++ log messages dropped because the queue of the producing thread was full</summary>
+	/// <remarks>Errors don't go through the queue, the C++ library delivers them on the calling thread</remarks>
+	public static ulong droppedNativeMessages => Library.loggerDroppedMessages();
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 ﻿namespace SentencePiece;
 using System.Runtime.InteropServices;
+using System.Text;
 
 /// <summary>Extension methods for <see cref="iProcessor" /></summary>
 public static class ProcessorExt
@@ -32,4 +33,99 @@ public static class ProcessorExt
 		}
 		return Marshal.PtrToStringUTF8( text ) ?? string.Empty;
 	}
+
+	/// <summary>Encode multiple strings into a single flat buffer of tokens</summary>
+	/// <remarks>Tokens of the string #i are in <c>[ offsets[ i ] .. offsets[ i + 1 ] )</c> slice of the output.<br/>
+	/// Unlike <see cref="encode(iProcessor, string)" />, this method is thread safe.</remarks>
+	/// <param name="processor">Tokenizer</param>
+	/// <param name="inputs">Strings to encode</param>
+	/// <param name="tokens">Output buffer for the tokens</param>
+	/// <param name="offsets">Output buffer for the offsets, the length must be <c>inputs.Count + 1</c></param>
+	/// <returns>Count of tokens in the output. When larger than <c>tokens.Length</c>, the tokens buffer was not written, only the offsets.</returns>
+	public static int encodeBatch( this iProcessor processor, IReadOnlyList<string> inputs, Span<int> tokens, Span<int> offsets )
+	{
+		int count = inputs.Count;
+		if( offsets.Length != count + 1 )
+			throw new ArgumentException( "The offsets buffer must have 1 more element than the count of inputs" );
+
+		// Convert all strings to null-terminated UTF-8 in a single buffer
+		int[] textOffsets = new int[ count ];
+		int cb = 0;
+		for( int i = 0; i < count; i++ )
+		{
+			textOffsets[ i ] = cb;
+			cb += Encoding.UTF8.GetByteCount( inputs[ i ] ) + 1;
+		}
+		byte[] utf8 = new byte[ cb ];
+		for( int i = 0; i < count; i++ )
+			Encoding.UTF8.GetBytes( inputs[ i ], utf8.AsSpan( textOffsets[ i ] ) );
+
+		IntPtr[] pointers = new IntPtr[ count ];
+		unsafe
+		{
+			fixed( byte* rsi = utf8 )
+			fixed( IntPtr* pp = pointers )
+			fixed( int* rdi = tokens )
+			fixed( int* off = offsets )
+			{
+				for( int i = 0; i < count; i++ )
+					pointers[ i ] = (IntPtr)( rsi + textOffsets[ i ] );
+				processor.encodeBatch( (IntPtr)pp, count, (IntPtr)rdi, tokens.Length, (IntPtr)off );
+			}
+		}
+		return offsets[ count ];
+	}
+
+	/// <summary>Encode multiple strings into a single flat array of tokens</summary>
+	/// <remarks>Tokens of the string #i are in <c>[ offsets[ i ] .. offsets[ i + 1 ] )</c> slice of the result.</remarks>
+	public static int[] encodeBatch( this iProcessor processor, IReadOnlyList<string> inputs, out int[] offsets )
+	{
+		offsets = new int[ inputs.Count + 1 ];
+		// SentencePiece emits at most 1 token per UTF-8 byte, plus the dummy prefix
+		int capacity = inputs.Sum( s => Encoding.UTF8.GetByteCount( s ) + 1 );
+		int[] tokens = new int[ capacity ];
+		int length = processor.encodeBatch( inputs, tokens, offsets );
+		if( length > capacity )
+		{
+			tokens = new int[ length ];
+			processor.encodeBatch( inputs, tokens, offsets );
+		}
+		else
+			Array.Resize( ref tokens, length );
+		return tokens;
+	}
+
+	/// <summary>Decode multiple sequences of tokens, sequence #i is in <c>[ offsets[ i ] .. offsets[ i + 1 ] )</c> slice of the tokens</summary>
+	/// <remarks>Unlike <see cref="decode(iProcessor, ReadOnlySpan{int})" />, this method is thread safe.</remarks>
+	public static string[] decodeBatch( this iProcessor processor, ReadOnlySpan<int> tokens, ReadOnlySpan<int> offsets )
+	{
+		int count = offsets.Length - 1;
+		if( count < 0 || offsets[ count ] > tokens.Length )
+			throw new ArgumentException( "The offsets don’t match the tokens" );
+
+		int[] textOffsets = new int[ count + 1 ];
+		// Most pieces are short; when the guess is wrong, the second call uses the exact length
+		byte[] text = new byte[ Math.Max( tokens.Length * 8, 1 ) ];
+		unsafe
+		{
+			fixed( int* rsi = tokens )
+			fixed( int* off = offsets )
+			fixed( int* rdiOff = textOffsets )
+			{
+				for( int pass = 0; pass < 2; pass++ )
+				{
+					fixed( byte* rdi = text )
+						processor.decodeBatch( (IntPtr)rsi, (IntPtr)off, count, (IntPtr)rdi, text.Length, (IntPtr)rdiOff );
+					if( textOffsets[ count ] <= text.Length )
+						break;
+					text = new byte[ textOffsets[ count ] ];
+				}
+			}
+		}
+
+		string[] result = new string[ count ];
+		for( int i = 0; i < count; i++ )
+			result[ i ] = Encoding.UTF8.GetString( text, textOffsets[ i ], textOffsets[ i + 1 ] - textOffsets[ i ] );
+		return result;
+	}
 }
\ No newline at end of file
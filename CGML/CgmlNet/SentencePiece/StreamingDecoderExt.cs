@@ -0,0 +1,30 @@
+﻿namespace SentencePiece;
+using System.Text;
+
+/// <summary>Extension methods for <see cref="iStreamingDecoder" /></summary>
+public static class StreamingDecoderExt
+{
+	static string makeString( IntPtr text, int length )
+	{
+		if( length <= 0 )
+			return string.Empty;
+		unsafe
+		{
+			return Encoding.UTF8.GetString( (byte*)text, length );
+		}
+	}
+
+	/// <summary>Decode one more token, get the newly completed text</summary>
+	public static string push( this iStreamingDecoder decoder, int token )
+	{
+		decoder.push( token, out IntPtr text, out int length );
+		return makeString( text, length );
+	}
+
+	/// <summary>Finish the sequence, get the remaining text</summary>
+	public static string flush( this iStreamingDecoder decoder )
+	{
+		decoder.flush( out IntPtr text, out int length );
+		return makeString( text, length );
+	}
+}
\ No newline at end of file
@@ -4,7 +4,8 @@ using System.ComponentModel;
 using System.Runtime.InteropServices;
 
 /// <summary>A sane API of the Google’s SentencePiece C++ library</summary>
-/// <remarks>The interface is not thread safe: the returned tokens/strings are stored in the memory owned by the object.</remarks>
+/// <remarks>The encode and decode methods are not thread safe: the returned tokens/strings are stored in the memory owned by the object.<br/>
+/// The batch methods are thread safe.</remarks>
 [ComInterface( "d045f91d-b65e-4cca-b372-e49545eab55a", eMarshalDirection.ToManaged ), CustomConventions( typeof( Cgml.Internal.NativeLogger ) )]
 public interface iProcessor: IDisposable
 {
@@ -19,4 +20,23 @@ public interface iProcessor: IDisposable
 	/// <summary>Get some information about the model</summary>
 	[RetValIndex]
 	sProcessorInfo getInfo();
+
+	/// <summary>Encode multiple strings on the thread pool</summary>
+	/// <remarks>The batch methods don’t use memory owned by the object, they can be called concurrently from multiple threads.</remarks>
+	[EditorBrowsable( EditorBrowsableState.Never )]
+	void encodeBatch( IntPtr inputs, int count, IntPtr tokens, int capacity, IntPtr offsets );
+
+	/// <summary>Decode multiple sequences of tokens on the thread pool</summary>
+	/// <remarks>The batch methods don’t use memory owned by the object, they can be called concurrently from multiple threads.</remarks>
+	[EditorBrowsable( EditorBrowsableState.Never )]
+	void decodeBatch( IntPtr tokens, IntPtr offsets, int count, IntPtr text, int capacity, IntPtr textOffsets );
+
+	/// <summary>Create a decoder to stream the output of the model</summary>
+	/// <remarks>The decoder is independent from this object, it can be used on another thread</remarks>
+	[RetValIndex]
+	iStreamingDecoder createStreamingDecoder();
+
+	/// <summary>Enable or disable the SIMD fast path of identity normalizers, it's enabled by default</summary>
+	/// <remarks>The tokens are the same either way, disable it to test the fast path against the generic normalizer</remarks>
+	void setNormalizerFastPath( [MarshalAs( UnmanagedType.U1 )] bool enabled );
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+﻿namespace SentencePiece;
+using ComLight;
+using System.ComponentModel;
+
+/// <summary>Stateful decoder which accepts one token at a time, and returns the newly completed text</summary>
+/// <remarks>The cost of each call is proportional to the length of the token, not the length of the sequence.</remarks>
+[ComInterface( "5002cf75-f364-449f-ad04-b469c468de87", eMarshalDirection.ToManaged ), CustomConventions( typeof( Cgml.Internal.NativeLogger ) )]
+public interface iStreamingDecoder: IDisposable
+{
+	/// <summary>Decode one more token, get the newly completed UTF-8 text</summary>
+	/// <remarks>Byte-fallback pieces are held until they form a complete UTF-8 character</remarks>
+	[EditorBrowsable( EditorBrowsableState.Never )]
+	void push( int token, out IntPtr text, out int length );
+
+	/// <summary>Finish the sequence, replace the incomplete UTF-8 sequence at the end, if any, with U+FFFD characters</summary>
+	[EditorBrowsable( EditorBrowsableState.Never )]
+	void flush( out IntPtr text, out int length );
+
+	/// <summary>Reset the state, the next token is decoded as the start of a new sequence</summary>
+	void reset();
+}
\ No newline at end of file
@@ -9,7 +9,9 @@ using System.Runtime.Intrinsics;
 public abstract class TensorPool: IDisposable
 {
 	/// <summary>List all tensors in this object</summary>
-	protected IEnumerable<Tensor?> listTensors() => pfnListTensors( this );
+	/// <remarks>Derived classes which keep tensors outside of <see cref="Tensor" /> fields should override this method to include them.<br/>
+	/// Every tensor object must be listed exactly once, otherwise <see cref="getVideoMemoryUsage" /> counts them repeatedly.</remarks>
+	protected virtual IEnumerable<Tensor?> listTensors() => pfnListTensors( this );
 
 	/// <summary>Release all tensors in the fields of the derived class</summary>
 	public virtual void Dispose()
@@ -0,0 +1,17 @@
+﻿namespace Cgml;
+
+/// <summary>Block-quantized formats of the tensors produced by llama.cpp</summary>
+/// <remarks>The values match <c>ggml_type</c> enum in <c>ggml.h</c> header</remarks>
+/// <seealso cref="iDevice.uploadQuantizedTensor" />
+public enum eGgmlType: byte
+{
+	/// <summary>32 elements => FP16 scale, and 16 bytes with 4-bit weights</summary>
+	/// <remarks>Repacked into <see cref="eTensorLayout.BCML1" /> without changing the weights</remarks>
+	Q4_0 = 2,
+	/// <summary>32 elements => FP16 scale, FP16 offset, and 16 bytes with 4-bit weights</summary>
+	/// <remarks>Repacked into <see cref="eTensorLayout.BCML1" /> without changing the weights</remarks>
+	Q4_1 = 3,
+	/// <summary>32 elements => FP16 scale, and 32 bytes with 8-bit weights</summary>
+	/// <remarks>Decompressed into FP16, and then quantized again when the desired layout is <see cref="eTensorLayout.BCML1" /></remarks>
+	Q8_0 = 8,
+}
\ No newline at end of file
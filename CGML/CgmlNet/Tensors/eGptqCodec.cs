@@ -0,0 +1,11 @@
+﻿namespace Cgml;
+
+/// <summary>Output formats for GPTQ matrices reshaped into panels</summary>
+/// <seealso cref="iDevice.reshapeGptq" />
+public enum eGptqCodec: byte
+{
+	/// <summary>FP32 scales, one column of them per 128 elements of the row</summary>
+	BCML3 = 3,
+	/// <summary>FP16 scales, two of them packed into a column per 256 elements of the row</summary>
+	BCML4 = 4,
+}
\ No newline at end of file
@@ -10,4 +10,10 @@ public enum eLoadTransform: byte
 	Fp16MakeIeee = 1,
 	/// <summary>Convert <see cref="eDataType.FP32" /> elements into <see cref="eDataType.FP16" /></summary>
 	Fp32DowncastIeee = 2,
+	/// <summary>Convert <see cref="eDataType.FP32" /> elements into <see cref="eDataType.BF16" />, rounding to nearest even</summary>
+	/// <remarks>Same memory as FP16, for the models with activations which overflow the range of FP16</remarks>
+	Fp32DowncastBf16 = 3,
+	/// <summary>Convert <see cref="eDataType.FP16" /> or <see cref="eDataType.BF16" /> elements into <see cref="eDataType.FP32" /></summary>
+	/// <remarks>Meant for small tensors sensitive to the precision, like weights of the normalization layers</remarks>
+	Fp16Upcast = 4,
 }
\ No newline at end of file
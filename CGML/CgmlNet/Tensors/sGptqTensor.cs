@@ -0,0 +1,19 @@
+﻿namespace Cgml;
+using System.Runtime.InteropServices;
+
+/// <summary>GPTQ-quantized matrix in system memory, 4 bits per weight, 128 weights per quantization group</summary>
+/// <remarks>The pointers need to stay valid for the duration of the <see cref="iDevice.reshapeGptq" /> call</remarks>
+[StructLayout( LayoutKind.Sequential )]
+public struct sGptqTensor
+{
+	/// <summary><c>rowLengthIntegers</c> lines of <c>rows</c> integers, each uint contains 8 consecutive 4-bit weights of a row</summary>
+	public IntPtr qweight;
+	/// <summary><c>( rowLengthIntegers + 15 ) / 16</c> lines of <c>rows</c> scales, FP32 for BCML3 or FP16 for BCML4</summary>
+	public IntPtr scales;
+	/// <summary><c>( rowLengthIntegers + 15 ) / 16</c> lines of <c>( rows + 7 ) / 8</c> integers, each uint contains zero points of 8 consecutive rows</summary>
+	public IntPtr qzeros;
+	/// <summary>Count of rows in the output matrix</summary>
+	public int rows;
+	/// <summary>Length of rows in the output matrix, divided by 8</summary>
+	public int rowLengthIntegers;
+}
\ No newline at end of file
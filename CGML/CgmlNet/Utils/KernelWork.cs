@@ -0,0 +1,48 @@
+﻿namespace Cgml;
+
+/// <summary>Amount of work done by the compute shaders, declared by the dispatch sites from the tensor shapes</summary>
+/// <remarks>Combined with the profiler measures, this gives achieved memory bandwidth and arithmetic throughput of every shader.<br/>
+/// The profiler measures every <c>bindShader</c> call separately. When a dispatch site binds the same shader multiple times, it must declare the work of every call, otherwise the averages are wrong.<br/>
+/// The numbers are the ideal ones, i.e. every input element is loaded once; caches and redundant loads are ignored.</remarks>
+public sealed class KernelWork
+{
+	struct Counters
+	{
+		public long calls, bytesRead, bytesWritten, flops;
+	}
+
+	// Indexed by shader ID
+	Counters[] counters = Array.Empty<Counters>();
+
+	/// <summary>Account a single measured call of the shader</summary>
+	public void add( ushort shader, long bytesRead, long bytesWritten, long flops )
+	{
+		if( shader >= counters.Length )
+			Array.Resize( ref counters, shader + 1 );
+		ref Counters c = ref counters[ shader ];
+		c.calls++;
+		c.bytesRead += bytesRead;
+		c.bytesWritten += bytesWritten;
+		c.flops += flops;
+	}
+
+	/// <summary>Drop the accumulated counters</summary>
+	public void reset() =>
+		Array.Clear( counters );
+
+	/// <summary>Average memory traffic and arithmetic per measured call of the shader</summary>
+	/// <remarks>The profiler may drop some measures, e.g. on disjoint GPU timestamps, averages are immune to that.</remarks>
+	public bool average( ushort shader, out double bytes, out double flops )
+	{
+		if( shader >= counters.Length || 0 == counters[ shader ].calls )
+		{
+			bytes = flops = 0;
+			return false;
+		}
+		ref Counters c = ref counters[ shader ];
+		double mul = 1.0 / c.calls;
+		bytes = ( c.bytesRead + c.bytesWritten ) * mul;
+		flops = c.flops * mul;
+		return true;
+	}
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 namespace Cgml;
 using System.Diagnostics;
 using System.Runtime.InteropServices;
+using System.Text.Json;
 
 /// <summary>Type of the profiler measure</summary>
 public enum eProfilerMeasure: byte
@@ -60,6 +61,54 @@ public delegate int pfnProfilerDataUnsafe(
 	[In, MarshalAs( UnmanagedType.LPArray, SizeParamIndex = 1 )] ProfilerResult[] arr,
 	int length, IntPtr pv );
 
+/// <summary>Function pointer to receive profiler percentiles from C++</summary>
+/// <remarks>The <c>percentiles</c> pointer is a row-major matrix of <c>long</c> numbers in 100-nanosecond ticks, one row per element of the array.</remarks>
+[UnmanagedFunctionPointer( CallingConvention.StdCall )]
+public delegate int pfnProfilerPercentilesUnsafe(
+	[In, MarshalAs( UnmanagedType.LPArray, SizeParamIndex = 2 )] ProfilerResult[] arr,
+	IntPtr percentiles, int length, IntPtr pv );
+
+/// <summary>Profiler measure with the latency distribution</summary>
+public sealed class ProfilerPercentiles
+{
+	/// <summary>What's being measured, and the accumulated measure</summary>
+	public readonly ProfilerResult measure;
+
+	/// <summary>Percentiles of the individual measures, in the same order as requested</summary>
+	/// <remarks>They come from a log-linear histogram, the relative error is under 6.25%</remarks>
+	public readonly TimeSpan[] percentiles;
+
+	internal ProfilerPercentiles( in ProfilerResult measure, TimeSpan[] percentiles )
+	{
+		this.measure = measure;
+		this.percentiles = percentiles;
+	}
+}
+
+/// <summary>A single event of the timeline captured by the profiler</summary>
+public readonly struct ProfilerEvent
+{
+	readonly long m_start, m_end;
+
+	/// <summary>What's being measured</summary>
+	public readonly eProfilerMeasure what;
+	/// <summary>Nesting level, 0 for top-level blocks</summary>
+	public readonly byte depth;
+	/// <summary>Block or shader ID, same as in <see cref="ProfilerResult" /></summary>
+	public readonly ushort id;
+
+	/// <summary>Start time, relative to the first captured event</summary>
+	public TimeSpan start => TimeSpan.FromTicks( m_start );
+	/// <summary>Duration of the event</summary>
+	public TimeSpan duration => TimeSpan.FromTicks( m_end - m_start );
+}
+
+/// <summary>Function pointer to receive the captured profiler timeline from C++</summary>
+[UnmanagedFunctionPointer( CallingConvention.StdCall )]
+public delegate int pfnProfilerEventsUnsafe(
+	[In, MarshalAs( UnmanagedType.LPArray, SizeParamIndex = 1 )] ProfilerEvent[] arr,
+	int length, IntPtr pv );
+
 /// <summary>RAII helper to implement profiler blocks</summary>
 public ref struct ProfilerBlock
 {
@@ -163,4 +212,136 @@ public static class ProfilerExt
 			}
 		}
 	}
+
+	/// <summary>Generate human-readable text from profiler percentiles</summary>
+	public static IEnumerable<string> formatted( this ProfilerPercentiles[]? arr, float[] percentiles, Func<ushort, string> block, Func<ushort, string> shader )
+	{
+		if( null == arr )
+		{
+			yield return "No profiler data";
+			yield break;
+		}
+
+		foreach( var group in arr.GroupBy( x => x.measure.what ) )
+		{
+			Func<ushort, string> pfnName;
+			switch( group.Key )
+			{
+				case eProfilerMeasure.Block:
+					yield return "\tBlocks";
+					pfnName = block;
+					break;
+				case eProfilerMeasure.Shader:
+					yield return "\tCompute Shaders";
+					pfnName = shader;
+					break;
+				default:
+					throw new ApplicationException();
+			}
+
+			foreach( ProfilerPercentiles res in group )
+			{
+				string name = pfnName( res.measure.id );
+				var values = res.percentiles.Select( ( ts, i ) =>
+				{
+					PrintedTime pt = ts;
+					return $"p{percentiles[ i ]} {pt.value} {pt.unit}";
+				} );
+				yield return $"{name}\t{res.measure.result.count} calls, {string.Join( ", ", values )}";
+			}
+		}
+	}
+
+	/// <summary>Write the captured timeline in Chrome trace event format, for <c>chrome://tracing</c> or <c>ui.perfetto.dev</c></summary>
+	/// <remarks>Every event becomes a complete "X" event on a single thread, the viewers reconstruct the nesting from the time intervals.</remarks>
+	public static void writeChromeTrace( this ProfilerEvent[]? arr, Stream stream, Func<ushort, string> block, Func<ushort, string> shader )
+	{
+		using var writer = new Utf8JsonWriter( stream, new JsonWriterOptions { Indented = false } );
+		writer.WriteStartObject();
+		writer.WriteStartArray( "traceEvents" );
+		foreach( ProfilerEvent e in arr ?? Array.Empty<ProfilerEvent>() )
+		{
+			writer.WriteStartObject();
+			switch( e.what )
+			{
+				case eProfilerMeasure.Block:
+					writer.WriteString( "name", block( e.id ) );
+					writer.WriteString( "cat", "block" );
+					break;
+				case eProfilerMeasure.Shader:
+					writer.WriteString( "name", shader( e.id ) );
+					writer.WriteString( "cat", "shader" );
+					break;
+				default:
+					throw new ApplicationException();
+			}
+			writer.WriteString( "ph", "X" );
+			// The format wants microseconds, TimeSpan ticks are 100 nanoseconds
+			writer.WriteNumber( "ts", e.start.Ticks / 10.0 );
+			writer.WriteNumber( "dur", e.duration.Ticks / 10.0 );
+			writer.WriteNumber( "pid", 1 );
+			writer.WriteNumber( "tid", 1 );
+			writer.WriteEndObject();
+		}
+		writer.WriteEndArray();
+		writer.WriteString( "displayTimeUnit", "ns" );
+		writer.WriteEndObject();
+	}
+
+	/// <summary>Generate human-readable roofline report: achieved bandwidth and arithmetic throughput of every compute shader</summary>
+	/// <param name="arr">Profiler measures</param>
+	/// <param name="work">Work declared by the dispatch sites</param>
+	/// <param name="shader">Shader names</param>
+	/// <param name="peakBandwidth">Peak memory bandwidth of the GPU in GB/s, or 0 when unknown</param>
+	/// <param name="peakGflops">Peak arithmetic throughput of the GPU in GFLOP/s, or 0 when unknown</param>
+	public static IEnumerable<string> formattedRoofline( this ProfilerResult[]? arr, KernelWork work, Func<ushort, string> shader,
+		double peakBandwidth = 0, double peakGflops = 0 )
+	{
+		if( null == arr )
+		{
+			yield return "No profiler data";
+			yield break;
+		}
+
+		bool havePeak = peakBandwidth > 0 && peakGflops > 0;
+		// Arithmetic intensity where the bottleneck switches from memory to ALU
+		double ridge = havePeak ? peakGflops / peakBandwidth : 0;
+		if( havePeak )
+			yield return $"\tMachine peak: {peakBandwidth:0.#} GB/s, {peakGflops:0.#} GFLOP/s, ridge point {ridge:0.##} FLOP/byte";
+		yield return "\tCompute Shaders";
+
+		var measures = arr.Where( x => x.what == eProfilerMeasure.Shader )
+			.OrderByDescending( x => x.result.total );
+		foreach( ProfilerResult res in measures )
+		{
+			string name = shader( res.id );
+			if( !work.average( res.id, out double bytes, out double flops ) )
+			{
+				yield return $"{name}\tno work declared";
+				continue;
+			}
+
+			// Bytes per nanosecond is the same as GB/s
+			double nanoseconds = res.result.total.Ticks * 100.0;
+			if( nanoseconds <= 0 )
+				continue;
+			// Average work per measured call times count of the measures is the total work of the measured calls
+			double gbps = bytes * res.result.count / nanoseconds;
+			double gflops = flops * res.result.count / nanoseconds;
+			double intensity = bytes > 0 ? flops / bytes : double.PositiveInfinity;
+
+			string line = $"{name}\t{res.result.total.TotalMilliseconds:0.###} ms, {gbps:0.#} GB/s, {gflops:0.#} GFLOP/s, {intensity:0.##} FLOP/byte";
+			if( havePeak )
+			{
+				// Attainable throughput according to the roofline model
+				double roof = Math.Min( peakGflops, intensity * peakBandwidth );
+				if( intensity < ridge )
+					line += $", memory-bound, {gbps / peakBandwidth * 100:0.#}% of peak bandwidth";
+				else
+					line += $", compute-bound, {gflops / peakGflops * 100:0.#}% of peak ALU";
+				line += $", roof {roof:0.#} GFLOP/s";
+			}
+			yield return line;
+		}
+	}
 }
\ No newline at end of file
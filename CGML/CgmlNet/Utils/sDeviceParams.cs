@@ -22,6 +22,9 @@ public struct sDeviceParams
 		None = 0,
 		/// <summary>Sacrifice a bit of performance to improve power efficiency</summary>
 		PowerSaver = 1,
+		/// <summary>Profile with the CPU wall clock instead of GPU timestamp queries</summary>
+		/// <remarks>With this flag, the time of compute shaders is measured from one <c>bindShader</c> call to the next one on the CPU.</remarks>
+		CpuProfiler = 2,
 	}
 
 	/// <summary>Miscellaneous initialization flags</summary>
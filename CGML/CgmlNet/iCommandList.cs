@@ -0,0 +1,24 @@
+﻿namespace Cgml;
+using ComLight;
+using System.ComponentModel;
+
+/// <summary>A sequence of compute shader commands recorded by <see cref="iContext.beginRecording" /> and <see cref="iContext.endRecording" /> methods</summary>
+/// <remarks>The list keeps references to the bound tensors, and reads their views when replayed.<br/>
+/// Resizing a tensor after the list was recorded is fine, disposing it is not.</remarks>
+[ComInterface( "1e3d5734-a934-43f2-9964-2b2aeadff674", eMarshalDirection.ToManaged ), CustomConventions( typeof( Internal.NativeLogger ) )]
+public interface iCommandList: IDisposable
+{
+	/// <summary>Count of the recorded <c>bindShader</c> and <c>dispatch</c> calls</summary>
+	void getSize( out int countShaders, out int countDispatches );
+
+	/// <summary>Replace constant buffer data of the <c>bindShader</c> call #index</summary>
+	/// <remarks>The size of the new data must be equal to the size of the recorded data</remarks>
+	[EditorBrowsable( EditorBrowsableState.Never )]
+	void patchConstants( int index, IntPtr constantBufferData, int cbSize );
+
+	/// <summary>Replace count of thread groups of the <c>dispatch</c> call #index</summary>
+	void patchDispatch( int index, int groupsX, int groupsY = 1, int groupsZ = 1 );
+
+	/// <summary>Shader ID of the <c>bindShader</c> call #index, and index of the first <c>dispatch</c> call recorded after it, or -1 when there are none</summary>
+	void getShader( int index, out ushort id, out int dispatch );
+}
\ No newline at end of file
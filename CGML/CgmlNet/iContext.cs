@@ -73,4 +73,48 @@ public interface iContext: IDisposable
 
 	/// <summary>Write payload data of the tensor to the stream</summary>
 	void writeTensorData( iTensor tensor, [WriteStream] Stream stream );
+
+	/// <summary>Start recording <c>bindShader</c>, <c>bindTensors</c>, <c>unbindInputs</c>, <c>dispatch</c> and profiler block calls into a command list, instead of executing them</summary>
+	/// <remarks>Methods which need the GPU immediately, like <see cref="copy" /> or <see cref="download" />, fail while recording.<br/>
+	/// The commands are recorded on the CPU, not into a D3D11 deferred context: the device is created single-threaded, and these don't support deferred contexts.</remarks>
+	void beginRecording();
+
+	/// <summary>Stop recording, and return the recorded commands</summary>
+	[RetValIndex]
+	iCommandList endRecording();
+
+	/// <summary>Execute the recorded commands</summary>
+	void replay( iCommandList commands );
+
+	/// <summary>Compute percentiles of the profiler measures, optionally reset all measures after the snapshot</summary>
+	[EditorBrowsable( EditorBrowsableState.Never )]
+	void profilerGetPercentiles( [In, MarshalAs( UnmanagedType.LPArray, SizeParamIndex = 1 )] float[] percentiles, int count,
+		[MarshalAs( UnmanagedType.FunctionPtr )] pfnProfilerPercentilesUnsafe pfn, IntPtr pv, [MarshalAs( UnmanagedType.U1 )] bool reset );
+
+	/// <summary>Drop the captured timeline, and start capturing the last <c>capacity</c> profiler events. Zero capacity stops the capture.</summary>
+	void profilerCaptureTimeline( uint capacity );
+
+	/// <summary>Get the captured timeline of the profiler events</summary>
+	[EditorBrowsable( EditorBrowsableState.Never )]
+	void profilerGetTimeline( [MarshalAs( UnmanagedType.FunctionPtr )] pfnProfilerEventsUnsafe pfn, IntPtr pv );
+
+	/// <summary>Copy elements <c>[ begin .. end )</c> of the dense source tensor into the same elements of the destination tensor using the GPU</summary>
+	/// <remarks>Both tensors must use the same data type</remarks>
+	void copyRange( iTensor destination, iTensor source, int begin, int end );
+
+	/// <summary>Insert a fence into the GPU command queue, and return the ID of that fence</summary>
+	[RetValIndex]
+	ulong fenceSignal();
+
+	/// <summary>Check whether the GPU has completed all commands submitted before the fence, optionally block the calling thread until it does</summary>
+	/// <remarks>The method polls event queries on the immediate context, and recycles them for the next fences.
+	/// Same as the rest of this interface it's not thread safe, don't call concurrently with other methods of the context.</remarks>
+	[RetValIndex, EditorBrowsable( EditorBrowsableState.Never )]
+	byte fenceCheck( ulong fence, [MarshalAs( UnmanagedType.U1 )] bool wait );
+
+	/// <summary>Download elements <c>[ 0 .. length )</c> of the dense tensor, compress them with LZ4 in parallel chunks, and write to the stream</summary>
+	void saveCompressed( iTensor tensor, int length, [WriteStream] Stream stream );
+
+	/// <summary>Read the data written by <see cref="saveCompressed" />, decompress in parallel, and upload into elements <c>[ 0 .. length )</c> of the dense tensor</summary>
+	void loadCompressed( iTensor tensor, int length, [ReadStream] Stream stream );
 }
\ No newline at end of file
@@ -45,4 +45,16 @@ public interface iDevice: IDisposable
 	/// That feature is implemented in ComLight runtime, not gonna work for a DLL imported function.</remarks>
 	[RetValIndex]
 	SentencePiece.iProcessor loadSentencePieceModel( [ReadStream] Stream source, int length );
+
+	/// <summary>Create immutable tensor in VRAM from llama.cpp block-quantized data in system memory</summary>
+	/// <remarks>With <see cref="eTensorLayout.BCML1" /> layout, 4-bit blocks are reshaped into panels without decompressing the weights.<br/>
+	/// With <see cref="eTensorLayout.Dense" /> layout, the weights are decompressed into FP16.</remarks>
+	[RetValIndex, EditorBrowsable( EditorBrowsableState.Never )]
+	iTensor uploadQuantizedTensor( [In] ref sTensorDesc desc, eGgmlType type, IntPtr rsi, int length );
+
+	/// <summary>Reshape GPTQ-quantized matrix into BCML3 or BCML4 panels, without recompressing the weights</summary>
+	/// <remarks>This method doesn’t touch the GPU, the output is in system memory.<br/>
+	/// The panels are processed in parallel on the thread pool.</remarks>
+	[EditorBrowsable( EditorBrowsableState.Never )]
+	void reshapeGptq( IntPtr rdi, int length, [In] ref sGptqTensor source, eGptqCodec codec );
 }
\ No newline at end of file
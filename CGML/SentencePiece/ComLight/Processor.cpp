@@ -1,10 +1,12 @@
 #include <assert.h>
 #include <array>
+#include <climits>
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include <winerror.h>
 #include "Processor.h"
 #include <sentencepiece_model.pb.h>
+#include "../../Cgml/Utils/parallelFor.h"
 
 extern "C"
 {
@@ -79,10 +81,22 @@ HRESULT Processor::load( ComLight::iReadStream* stream, uint32_t length )
 
 	std::string_view view{ content.data(), content.size() };
 	Status s = proc.LoadFromSerializedProto( view );
-	if( s.ok() )
-		return S_OK;
+	if( !s.ok() )
+		return failedStatus( s );
 
-	return failedStatus( s );
+	// Decoded surfaces of the pieces, for the streaming decoders
+	std::shared_ptr<PieceTable> pieces;
+	try
+	{
+		pieces = std::make_shared<PieceTable>();
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+	CHECK( pieces->initialize( proc ) );
+	m_pieces = pieces;
+	return S_OK;
 }
 
 HRESULT COMLIGHTCALL Processor::encode( const char* input, const int** tokens, int& length ) noexcept
@@ -127,4 +141,114 @@ HRESULT COMLIGHTCALL Processor::getInfo( sProcessorInfo& rdi ) const noexcept
 	rdi.idEOS = proc.eos_id();
 	rdi.idPad = proc.pad_id();
 	return S_OK;
+}
+
+namespace
+{
+	// Compute offsets of the batch elements from their lengths, and copy them into the output buffer if it's large enough
+	template<class E, class Vec>
+	HRESULT gatherBatch( const std::vector<Vec>& results, E* rdi, int capacity, int* offsets )
+	{
+		size_t total = 0;
+		for( size_t i = 0; i < results.size(); i++ )
+		{
+			offsets[ i ] = (int)total;
+			total += results[ i ].size();
+			if( total > INT_MAX )
+				return DISP_E_OVERFLOW;
+		}
+		offsets[ results.size() ] = (int)total;
+
+		if( total > (size_t)capacity || nullptr == rdi )
+			return S_OK;
+
+		for( const Vec& v : results )
+		{
+			std::copy( v.begin(), v.end(), rdi );
+			rdi += v.size();
+		}
+		return S_OK;
+	}
+}
+
+HRESULT COMLIGHTCALL Processor::encodeBatch( const char* const* inputs, int count, int* tokens, int capacity, int* offsets ) const noexcept
+{
+	if( nullptr == inputs || nullptr == offsets )
+		return E_POINTER;
+	if( count < 0 || capacity < 0 )
+		return E_INVALIDARG;
+
+	std::vector<std::vector<int>> results;
+	try
+	{
+		results.resize( (size_t)count );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	auto job = [ & ]( size_t i ) -> HRESULT
+	{
+		if( nullptr == inputs[ i ] )
+			return E_POINTER;
+		Status s = proc.Encode( inputs[ i ], &results[ i ] );
+		if( s.ok() )
+			return S_OK;
+		return failedStatus( s );
+	};
+	CHECK( parallelFor( (size_t)count, job ) );
+
+	return gatherBatch( results, tokens, capacity, offsets );
+}
+
+HRESULT COMLIGHTCALL Processor::decodeBatch( const int* tokens, const int* offsets, int count, char* text, int capacity, int* textOffsets ) const noexcept
+{
+	if( nullptr == tokens || nullptr == offsets || nullptr == textOffsets )
+		return E_POINTER;
+	if( count < 0 || capacity < 0 )
+		return E_INVALIDARG;
+	for( int i = 0; i < count; i++ )
+		if( offsets[ i ] < 0 || offsets[ i ] > offsets[ i + 1 ] )
+			return E_INVALIDARG;
+
+	std::vector<std::string> results;
+	try
+	{
+		results.resize( (size_t)count );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	auto job = [ & ]( size_t i ) -> HRESULT
+	{
+		std::vector<int> ids{ tokens + offsets[ i ], tokens + offsets[ i + 1 ] };
+		Status s = proc.Decode( ids, &results[ i ] );
+		if( s.ok() )
+			return S_OK;
+		return failedStatus( s );
+	};
+	CHECK( parallelFor( (size_t)count, job ) );
+
+	return gatherBatch( results, text, capacity, textOffsets );
+}
+
+HRESULT COMLIGHTCALL Processor::createStreamingDecoder( iStreamingDecoder** pp ) noexcept
+{
+	if( nullptr == pp )
+		return E_POINTER;
+
+	ComLight::CComPtr<ComLight::Object<StreamingDecoder>> obj;
+	CHECK( ComLight::Object<StreamingDecoder>::create( obj ) );
+	obj->initialize( m_pieces );
+	obj.detach( pp );
+	return S_OK;
+}
+
+HRESULT COMLIGHTCALL Processor::setNormalizerFastPath( uint8_t enabled ) noexcept
+{
+	proc.SetNormalizerFastPath( 0 != enabled );
+	return S_OK;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../../Cgml/API/iSentencePiece.cl.h"
 #include "../../ComLightLib/comLightServer.h"
 #include "../src/sentencepiece_processor.h"
+#include "StreamingDecoder.h"
 
 namespace SentencePiece
 {
@@ -13,10 +14,15 @@ namespace SentencePiece
 		sentencepiece::SentencePieceProcessor proc;
 		std::vector<int> m_tokens;
 		std::string m_text;
+		std::shared_ptr<const PieceTable> m_pieces;
 
 		HRESULT COMLIGHTCALL encode( const char* input, const int** tokens, int& length ) noexcept override final;
 		HRESULT COMLIGHTCALL decode( const int* tokens, int count, const char** str ) noexcept override final;
 		HRESULT COMLIGHTCALL getInfo( sProcessorInfo& rdi ) const noexcept override final;
+		HRESULT COMLIGHTCALL encodeBatch( const char* const* inputs, int count, int* tokens, int capacity, int* offsets ) const noexcept override final;
+		HRESULT COMLIGHTCALL decodeBatch( const int* tokens, const int* offsets, int count, char* text, int capacity, int* textOffsets ) const noexcept override final;
+		HRESULT COMLIGHTCALL createStreamingDecoder( iStreamingDecoder** pp ) noexcept override final;
+		HRESULT COMLIGHTCALL setNormalizerFastPath( uint8_t enabled ) noexcept override final;
 
 	public:
 
@@ -0,0 +1,234 @@
+#include <assert.h>
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winerror.h>
+#include "StreamingDecoder.h"
+#include <sentencepiece_model.pb.h>
+#include "../src/model_interface.h"
+#include "../src/util.h"
+#include "third_party/absl/strings/match.h"
+#include "third_party/absl/strings/str_replace.h"
+
+extern "C"
+{
+	// See the comment in Processor.cpp
+	void logError( const char* pszFormat, ... );
+}
+
+using namespace SentencePiece;
+
+namespace
+{
+	const char kSpaceSymbol[] = "\xe2\x96\x81";
+	const char kReplacementCharacter[] = "\xef\xbf\xbd";
+	const char kDefaultUnknownSymbol[] = " \xE2\x81\x87 ";
+
+	// Count of bytes in the UTF-8 sequence which starts with the byte, or 0 if the byte can't start a sequence
+	inline size_t sequenceLength( uint8_t lead )
+	{
+		if( lead < 0x80 )
+			return 1;
+		if( lead >= 0xC2 && lead <= 0xDF )
+			return 2;
+		if( lead >= 0xE0 && lead <= 0xEF )
+			return 3;
+		if( lead >= 0xF0 && lead <= 0xF4 )
+			return 4;
+		return 0;
+	}
+
+	// True when the incomplete sequence can become a valid UTF-8 character after more bytes arrive
+	bool isValidPrefix( std::string_view bytes )
+	{
+		const uint8_t lead = (uint8_t)bytes[ 0 ];
+		const size_t len = sequenceLength( lead );
+		if( len <= bytes.size() )
+			return false;
+
+		for( size_t i = 1; i < bytes.size(); i++ )
+		{
+			const uint8_t c = (uint8_t)bytes[ i ];
+			uint8_t lo = 0x80, hi = 0xBF;
+			if( 1 == i )
+			{
+				// Reject overlong encodings, surrogates, and code points above U+10FFFF
+				switch( lead )
+				{
+				case 0xE0: lo = 0xA0; break;
+				case 0xED: hi = 0x9F; break;
+				case 0xF0: lo = 0x90; break;
+				case 0xF4: hi = 0x8F; break;
+				}
+			}
+			if( c < lo || c > hi )
+				return false;
+		}
+		return true;
+	}
+}
+
+HRESULT PieceTable::initialize( const sentencepiece::SentencePieceProcessor& proc )
+{
+	const sentencepiece::ModelProto& model = proc.model_proto();
+	const auto& normalizer = model.normalizer_spec();
+	stripLeadingSpace = normalizer.add_dummy_prefix() || normalizer.remove_extra_whitespaces();
+	removeExtraWhitespaces = normalizer.remove_extra_whitespaces();
+	if( model.trainer_spec().has_unk_surface() )
+		unknownSurface = model.trainer_spec().unk_surface();
+	else
+		unknownSurface = kDefaultUnknownSymbol;
+
+	const int count = proc.GetPieceSize();
+	try
+	{
+		pieces.resize( count );
+		for( int i = 0; i < count; i++ )
+		{
+			Piece& rdi = pieces[ i ];
+			const std::string& piece = proc.IdToPiece( i );
+			rdi.leadingSpace = false;
+			if( proc.IsControl( i ) )
+				rdi.kind = eKind::Control;
+			else if( proc.IsUnknown( i ) )
+				rdi.kind = eKind::Unknown;
+			else if( proc.IsByte( i ) )
+			{
+				const int byte = sentencepiece::PieceToByte( piece );
+				if( byte < 0 || byte > 0xFF )
+				{
+					logError( "SentencePiece error: byte piece %s is invalid", piece.c_str() );
+					return E_INVALIDARG;
+				}
+				rdi.kind = eKind::Byte;
+				rdi.surface.assign( 1, (char)byte );
+			}
+			else
+			{
+				rdi.kind = eKind::Normal;
+				rdi.leadingSpace = absl::StartsWith( piece, kSpaceSymbol );
+				rdi.surface = absl::StrReplaceAll( piece, { { kSpaceSymbol, " " } } );
+			}
+		}
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+	return S_OK;
+}
+
+void StreamingDecoder::consumeBytes( bool final )
+{
+	size_t off = 0;
+	while( off < pendingBytes.size() )
+	{
+		const std::string_view rest = std::string_view{ pendingBytes }.substr( off );
+		if( !final && isValidPrefix( rest ) )
+			break;	// Wait for more bytes
+
+		size_t consumed;
+		if( sentencepiece::string_util::IsValidDecodeUTF8( rest, &consumed ) )
+			m_text.append( rest.data(), consumed );
+		else
+		{
+			m_text += kReplacementCharacter;
+			consumed = 1;
+		}
+		off += consumed;
+	}
+	pendingBytes.erase( 0, off );
+}
+
+HRESULT StreamingDecoder::result( const char** text, int& length )
+{
+	if( !m_text.empty() )
+		emptySequence = false;
+	*text = m_text.c_str();
+	length = (int)m_text.size();
+	return S_OK;
+}
+
+HRESULT COMLIGHTCALL StreamingDecoder::push( int token, const char** text, int& length ) noexcept
+{
+	if( nullptr == text )
+		return E_POINTER;
+	*text = nullptr;
+	length = 0;
+
+	const PieceTable& pt = *table;
+	if( token < 0 || token >= (int)pt.pieces.size() )
+	{
+		logError( "SentencePiece error: Invalid id: %i", token );
+		return DISP_E_OVERFLOW;
+	}
+	const PieceTable::Piece& piece = pt.pieces[ token ];
+
+	try
+	{
+		m_text.clear();
+		if( piece.kind == PieceTable::eKind::Byte )
+		{
+			pendingBytes += piece.surface;
+			consumeBytes( false );
+			return result( text, length );
+		}
+
+		// A non-byte piece terminates the sequence of bytes
+		consumeBytes( true );
+
+		if( bosWhitespaceSeen || !( emptySequence && m_text.empty() ) )
+			bosWhitespace = false;
+		bosWhitespaceSeen = false;
+
+		switch( piece.kind )
+		{
+		case PieceTable::eKind::Control:
+			break;
+		case PieceTable::eKind::Unknown:
+			m_text += pt.unknownSurface;
+			break;
+		default:
+			std::string_view surface = piece.surface;
+			if( bosWhitespace && pt.stripLeadingSpace && piece.leadingSpace )
+			{
+				surface.remove_prefix( 1 );
+				// With remove_extra_whitespaces, the leading whitespace is stripped from all pieces until the first non-empty one
+				bosWhitespaceSeen = !pt.removeExtraWhitespaces;
+			}
+			m_text += surface;
+		}
+		return result( text, length );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT COMLIGHTCALL StreamingDecoder::flush( const char** text, int& length ) noexcept
+{
+	if( nullptr == text )
+		return E_POINTER;
+	try
+	{
+		m_text.clear();
+		consumeBytes( true );
+		return result( text, length );
+	}
+	catch( const std::bad_alloc& )
+	{
+		*text = nullptr;
+		length = 0;
+		return E_OUTOFMEMORY;
+	}
+}
+
+HRESULT COMLIGHTCALL StreamingDecoder::reset() noexcept
+{
+	pendingBytes.clear();
+	m_text.clear();
+	bosWhitespace = true;
+	bosWhitespaceSeen = false;
+	emptySequence = true;
+	return S_OK;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "../../Cgml/API/iSentencePiece.cl.h"
+#include "../../ComLightLib/comLightServer.h"
+#include "../src/sentencepiece_processor.h"
+
+namespace SentencePiece
+{
+	// Decoded surfaces of all pieces in the vocabulary, shared by the streaming decoders
+	struct PieceTable
+	{
+		enum struct eKind : uint8_t
+		{
+			Normal,
+			Control,
+			Unknown,
+			Byte,
+		};
+
+		struct Piece
+		{
+			// Text of the piece with U+2581 replaced with spaces; for byte-fallback pieces, the single byte
+			std::string surface;
+			eKind kind;
+			// True when the piece starts with U+2581
+			bool leadingSpace;
+		};
+
+		std::vector<Piece> pieces;
+		std::string unknownSurface;
+		// These flags come from the normalizer spec of the model, they control how the leading space of the output is stripped
+		bool stripLeadingSpace;
+		bool removeExtraWhitespaces;
+
+		HRESULT initialize( const sentencepiece::SentencePieceProcessor& proc );
+	};
+
+	// Implements the same algorithm as SentencePieceProcessor::Decode, incrementally.
+	// The denormalizer is not supported, the models we use don't have one.
+	class StreamingDecoder : public ComLight::ObjectRoot<iStreamingDecoder>
+	{
+		std::shared_ptr<const PieceTable> table;
+		// Trailing byte-fallback pieces which don't yet form a complete UTF-8 character
+		std::string pendingBytes;
+		// Output of the last call
+		std::string m_text;
+		// State of the leading whitespace logic, same as is_bos_ws and bos_ws_seen local variables in SentencePieceProcessor::Decode
+		bool bosWhitespace = true;
+		bool bosWhitespaceSeen = false;
+		// True while nothing has been produced for the current sequence
+		bool emptySequence = true;
+
+		void consumeBytes( bool final );
+		HRESULT result( const char** text, int& length );
+
+		HRESULT COMLIGHTCALL push( int token, const char** text, int& length ) noexcept override final;
+		HRESULT COMLIGHTCALL flush( const char** text, int& length ) noexcept override final;
+		HRESULT COMLIGHTCALL reset() noexcept override final;
+
+	public:
+
+		void initialize( const std::shared_ptr<const PieceTable>& pieces )
+		{
+			table = pieces;
+		}
+	};
+}
\ No newline at end of file
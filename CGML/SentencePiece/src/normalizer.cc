@@ -14,6 +14,8 @@
 
 #include "normalizer.h"
 
+#include <emmintrin.h>
+#include <cstring>
 #include <utility>
 #include <vector>
 
@@ -81,6 +83,10 @@ namespace sentencepiece {
 
 			RETURN_IF_ERROR( status() );
 
+			if( IsIdentity() ) {
+				return NormalizeIdentity( input, normalized, norm_to_orig );
+			}
+
 			int consumed = 0;
 
 			// Ignores heading space.
@@ -195,6 +201,108 @@ namespace sentencepiece {
 			return normalized;
 		}
 
+		bool Normalizer::IsIdentity() const {
+			return identity_fast_path_ && trie_ == nullptr && ( matcher_ == nullptr || matcher_->empty() ) &&
+				!spec_->remove_extra_whitespaces() && !treat_whitespace_as_suffix_;
+		}
+
+		util::Status Normalizer::NormalizeIdentity( absl::string_view input,
+			std::string* normalized,
+			std::vector<size_t>* norm_to_orig ) const {
+			const bool escape = spec_->escape_whitespaces();
+			const size_t length = input.size();
+
+			// Each input byte produces at most 3 output bytes, plus the dummy prefix.
+			// The SIMD loop below stores complete 16-byte vectors, the capacity covers that too.
+			normalized->resize( length * 3 + 3 );
+			norm_to_orig->resize( length * 3 + 4 );
+			char* const outBegin = &( *normalized )[ 0 ];
+			size_t* const mapBegin = norm_to_orig->data();
+			char* rdi = outBegin;
+			size_t* map = mapBegin;
+
+			// Writes U+2581 (LOWER ONE EIGHT BLOCK) when escaping whitespaces, otherwise the space
+			auto add_ws = [ & ]( size_t consumed ) {
+				if( escape ) {
+					rdi[ 0 ] = '\xe2';
+					rdi[ 1 ] = '\x96';
+					rdi[ 2 ] = '\x81';
+					rdi += 3;
+					map[ 0 ] = map[ 1 ] = map[ 2 ] = consumed;
+					map += 3;
+				}
+				else {
+					*rdi++ = ' ';
+					*map++ = consumed;
+				}
+			};
+
+			if( spec_->add_dummy_prefix() ) add_ws( 0 );
+
+			const char* const rsi = input.data();
+			const __m128i space = _mm_set1_epi8( ' ' );
+			size_t i = 0;
+			while( i < length ) {
+				if( i + 16 <= length ) {
+					// Find non-ASCII bytes, and spaces when they need escaping
+					const __m128i v = _mm_loadu_si128( ( const __m128i* )( rsi + i ) );
+					unsigned int mask = (unsigned int)_mm_movemask_epi8( v );
+					if( escape ) mask |= (unsigned int)_mm_movemask_epi8( _mm_cmpeq_epi8( v, space ) );
+
+					// Copy the complete vector, but only advance by the count of plain ASCII bytes
+					_mm_storeu_si128( ( __m128i* )rdi, v );
+					size_t plain = 16;
+					if( 0 != mask ) {
+						plain = 0;
+						while( 0 == ( mask & 1 ) ) {
+							mask >>= 1;
+							plain++;
+						}
+					}
+					for( size_t n = 0; n < plain; ++n ) map[ n ] = i + n;
+					rdi += plain;
+					map += plain;
+					i += plain;
+					if( plain == 16 ) continue;
+				}
+
+				// The next character is a space, non-ASCII, or in the incomplete vector at the end of the input
+				const char c = rsi[ i ];
+				if( c == ' ' && escape ) {
+					add_ws( i );
+					i++;
+				}
+				else if( 0 == ( c & 0x80 ) ) {
+					*rdi++ = c;
+					*map++ = i;
+					i++;
+				}
+				else {
+					size_t mblen = 0;
+					size_t produced;
+					if( string_util::IsValidDecodeUTF8( absl::string_view( rsi + i, length - i ), &mblen ) ) {
+						std::memcpy( rdi, rsi + i, mblen );
+						produced = mblen;
+					}
+					else {
+						// Same as NormalizePrefix(), malformed bytes become U+FFFD one at a time
+						mblen = 1;
+						std::memcpy( rdi, "\xEF\xBF\xBD", 3 );
+						produced = 3;
+					}
+					for( size_t n = 0; n < produced; ++n ) map[ n ] = i;
+					rdi += produced;
+					map += produced;
+					i += mblen;
+				}
+			}
+
+			*map++ = length;
+			normalized->resize( rdi - outBegin );
+			norm_to_orig->resize( map - mapBegin );
+			return util::OkStatus();
+		}
+
 		std::pair<absl::string_view, int> Normalizer::NormalizePrefix(
 			absl::string_view input ) const {
 			std::pair<absl::string_view, int> result;
@@ -46,6 +46,9 @@ class PrefixMatcher {
   // Replaces entries in `w` with `out`.
   std::string GlobalReplace(absl::string_view w, absl::string_view out) const;
 
+  // True when the dictionary is empty, and PrefixMatch never finds anything.
+  bool empty() const { return trie_ == nullptr; }
+
  private:
   std::unique_ptr<Darts::DoubleArray> trie_;
 };
@@ -93,6 +96,11 @@ class Normalizer {
   // This function is used in sentencepiece training.
   virtual std::string Normalize(absl::string_view input) const;
 
+  // Enables or disables NormalizeIdentity() for identity normalizers.
+  // Both paths produce the same output, disabling the fast one is only
+  // useful to test it against the generic implementation.
+  void SetIdentityFastPath(bool enabled) { identity_fast_path_ = enabled; }
+
   friend class Builder;
 
  private:
@@ -100,6 +108,17 @@ class Normalizer {
 
   void Init();
 
+  // True when Normalize() keeps every valid UTF-8 character unchanged,
+  // i.e. no chars map, no user-defined symbols, no whitespace removal.
+  bool IsIdentity() const;
+
+  // Faster equivalent of Normalize() for IsIdentity() normalizers.
+  // Copies runs of ASCII characters with SIMD, produces the same output
+  // and the same alignment as the generic implementation.
+  util::Status NormalizeIdentity(absl::string_view input,
+                                 std::string *normalized,
+                                 std::vector<size_t> *norm_to_orig) const;
+
   // Normalizes the prefix of |input| and returns the pair of
   // normalized prefix and length we must consume after
   // normalization.
@@ -146,6 +165,10 @@ class Normalizer {
   // "_hello" and "_world".
   const bool treat_whitespace_as_suffix_ = false;
 
+  // When false, IsIdentity() returns false and Normalize() uses the
+  // generic implementation.
+  bool identity_fast_path_ = true;
+
 #ifdef IS_BIG_ENDIAN
   // Stores the blob for TRIE encoded in big-endian.
   std::string precompiled_charsmap_buffer_;
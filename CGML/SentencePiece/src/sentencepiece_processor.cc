@@ -1090,6 +1090,10 @@ namespace sentencepiece {
 		normalizer_ = std::move( normalizer );
 	}
 
+	void SentencePieceProcessor::SetNormalizerFastPath( bool enabled ) {
+		if( normalizer_ ) normalizer_->SetIdentityFastPath( enabled );
+	}
+
 	const ModelProto& SentencePieceProcessor::model_proto() const {
 		return *model_proto_;
 	}
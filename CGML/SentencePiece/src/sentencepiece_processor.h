@@ -669,6 +669,10 @@ class SentencePieceProcessor {
   // Allows injection of a normalizer instance. `normalizer` is moved.
   void SetNormalizer(std::unique_ptr<normalizer::Normalizer> &&normalizer);
 
+  // Enables or disables the fast path of the identity normalizers.
+  // The ids are the same either way, see Normalizer::SetIdentityFastPath.
+  void SetNormalizerFastPath(bool enabled);
+
   // Returns immutable model proto. Useful to obtain extended
   // or experimental parameters encoded in model_proto.
   const ModelProto &model_proto() const;
@@ -0,0 +1,247 @@
+﻿namespace Torch;
+using Cgml;
+using System.Runtime.InteropServices;
+using System.Text;
+
+/// <summary>Element types of the tensors in GGUF files</summary>
+/// <remarks>The values match <c>ggml_type</c> enum in <c>ggml.h</c> header, the list only includes the types we can load</remarks>
+public enum eGgufTensorType: uint
+{
+	/// <summary>32-bit floats</summary>
+	F32 = 0,
+	/// <summary>IEEE half-precision floats</summary>
+	F16 = 1,
+	/// <summary>Blocks of 32 elements, FP16 scale + 4-bit weights</summary>
+	Q4_0 = 2,
+	/// <summary>Blocks of 32 elements, FP16 scale and offset + 4-bit weights</summary>
+	Q4_1 = 3,
+	/// <summary>Blocks of 32 elements, FP16 scale + 8-bit weights</summary>
+	Q8_0 = 8,
+	/// <summary>Non-standard half-precision floats</summary>
+	BF16 = 30,
+}
+
+/// <summary>Metadata of a single tensor in GGUF file</summary>
+[StructLayout( LayoutKind.Auto )]
+public readonly struct GgufTensor
+{
+	/// <summary>Element type</summary>
+	public readonly eGgufTensorType type;
+
+	/// <summary>Shape of the tensor; GGML dimensions are ordered the same way as ours, i.e. X is the row length</summary>
+	public readonly TensorShape shape;
+
+	/// <summary>Offset of the payload, in bytes, relative to the start of the file</summary>
+	public readonly long offset;
+
+	internal GgufTensor( eGgufTensorType type, in TensorShape shape, long offset )
+	{
+		this.type = type;
+		this.shape = shape;
+		this.offset = offset;
+	}
+
+	/// <summary>False for the element types we can't load, like k-quants</summary>
+	/// <remarks>The header parser keeps these tensors, the loader rejects them when they're loaded</remarks>
+	public bool isSupported => Enum.IsDefined( type );
+
+	/// <summary>Length of the payload in bytes</summary>
+	public int length
+	{
+		get
+		{
+			long elts = shape.countElements();
+			long cb = type switch
+			{
+				eGgufTensorType.F32 => elts * 4,
+				eGgufTensorType.F16 or eGgufTensorType.BF16 => elts * 2,
+				eGgufTensorType.Q4_0 => elts / 32 * 18,
+				eGgufTensorType.Q4_1 => elts / 32 * 20,
+				eGgufTensorType.Q8_0 => elts / 32 * 34,
+				_ => throw new NotSupportedException( $"Unsupported GGUF type {(uint)type}" )
+			};
+			return checked((int)cb);
+		}
+	}
+
+	/// <summary>For block-quantized tensors, the corresponding native type. Otherwise null.</summary>
+	public eGgmlType? quantized => type switch
+	{
+		eGgufTensorType.Q4_0 => eGgmlType.Q4_0,
+		eGgufTensorType.Q4_1 => eGgmlType.Q4_1,
+		eGgufTensorType.Q8_0 => eGgmlType.Q8_0,
+		_ => null
+	};
+
+	/// <summary>For uncompressed tensors, type of the elements</summary>
+	public eDataType dataType => type switch
+	{
+		eGgufTensorType.F32 => eDataType.FP32,
+		eGgufTensorType.F16 => eDataType.FP16,
+		eGgufTensorType.BF16 => eDataType.BF16,
+		// Quantized tensors are decoded into FP16
+		eGgufTensorType.Q4_0 or eGgufTensorType.Q4_1 or eGgufTensorType.Q8_0 => eDataType.FP16,
+		_ => throw new NotSupportedException( $"Unsupported GGUF type {(uint)type}" )
+	};
+
+	/// <summary>A string for debugger</summary>
+	public override string ToString() => $"{type} {shape.size}, offset {offset}";
+}
+
+/// <summary>Parsed header of a GGUF file, produced by llama.cpp</summary>
+/// <seealso href="https://github.com/ggerganov/ggml/blob/master/docs/gguf.md" />
+public sealed class Gguf
+{
+	/// <summary>File extension of the format</summary>
+	public const string extension = ".gguf";
+
+	/// <summary>Key/value metadata.<br/>
+	/// Values are integers, floating point numbers, <c>bool</c>, <c>string</c>, or <c>object[]</c> for arrays.</summary>
+	public readonly Dictionary<string, object> metadata = new Dictionary<string, object>();
+
+	/// <summary>Tensors, sorted by payload offset</summary>
+	public readonly List<KeyValuePair<string, GgufTensor>> tensors = new List<KeyValuePair<string, GgufTensor>>();
+
+	const uint magic = 0x46554747;  // "GGUF"
+	const uint defaultAlignment = 32;
+
+	enum eValueType: uint
+	{
+		UInt8 = 0,
+		Int8 = 1,
+		UInt16 = 2,
+		Int16 = 3,
+		UInt32 = 4,
+		Int32 = 5,
+		Float32 = 6,
+		Bool = 7,
+		String = 8,
+		Array = 9,
+		UInt64 = 10,
+		Int64 = 11,
+		Float64 = 12,
+	}
+
+	static string readString( BinaryReader reader )
+	{
+		ulong len = reader.ReadUInt64();
+		if( len > int.MaxValue )
+			throw new ArgumentException( "GGUF string is too long" );
+		byte[] bytes = reader.ReadBytes( (int)len );
+		if( bytes.Length != (int)len )
+			throw new EndOfStreamException();
+		return Encoding.UTF8.GetString( bytes );
+	}
+
+	static object readValue( BinaryReader reader, eValueType vt )
+	{
+		switch( vt )
+		{
+			case eValueType.UInt8: return reader.ReadByte();
+			case eValueType.Int8: return reader.ReadSByte();
+			case eValueType.UInt16: return reader.ReadUInt16();
+			case eValueType.Int16: return reader.ReadInt16();
+			case eValueType.UInt32: return reader.ReadUInt32();
+			case eValueType.Int32: return reader.ReadInt32();
+			case eValueType.Float32: return reader.ReadSingle();
+			case eValueType.Bool: return reader.ReadByte() != 0;
+			case eValueType.String: return readString( reader );
+			case eValueType.UInt64: return reader.ReadUInt64();
+			case eValueType.Int64: return reader.ReadInt64();
+			case eValueType.Float64: return reader.ReadDouble();
+			case eValueType.Array:
+				{
+					eValueType et = (eValueType)reader.ReadUInt32();
+					ulong count = reader.ReadUInt64();
+					if( count > int.MaxValue )
+						throw new ArgumentException( "GGUF array is too long" );
+					object[] arr = new object[ count ];
+					for( int i = 0; i < arr.Length; i++ )
+						arr[ i ] = readValue( reader, et );
+					return arr;
+				}
+		}
+		throw new ArgumentException( $"Unknown GGUF value type {(uint)vt}" );
+	}
+
+	static TensorShape readShape( BinaryReader reader )
+	{
+		uint dims = reader.ReadUInt32();
+		if( dims == 0 || dims > 4 )
+			throw new NotImplementedException( $"The tensor has {dims} dimensions, the supported range is [ 1 .. 4 ]" );
+
+		Span<int> size = stackalloc int[ 4 ] { 1, 1, 1, 1 };
+		for( int i = 0; i < dims; i++ )
+		{
+			ulong ne = reader.ReadUInt64();
+			if( ne == 0 || ne > int.MaxValue )
+				throw new ArgumentException( $"Unsupported tensor dimension {ne}" );
+			size[ i ] = (int)ne;
+		}
+		return new TensorShape( new Int128( size[ 0 ], size[ 1 ], size[ 2 ], size[ 3 ] ) );
+	}
+
+	/// <summary>Parse the header of the file</summary>
+	public Gguf( Stream stream )
+	{
+		using var reader = new BinaryReader( stream, Encoding.UTF8, true );
+		if( reader.ReadUInt32() != magic )
+			throw new ArgumentException( "The file is not in GGUF format" );
+		uint version = reader.ReadUInt32();
+		if( version < 2 )
+			throw new NotSupportedException( $"GGUF version {version} is not supported" );
+
+		ulong countTensors = reader.ReadUInt64();
+		ulong countValues = reader.ReadUInt64();
+
+		for( ulong i = 0; i < countValues; i++ )
+		{
+			string key = readString( reader );
+			eValueType vt = (eValueType)reader.ReadUInt32();
+			metadata[ key ] = readValue( reader, vt );
+		}
+
+		uint alignment = defaultAlignment;
+		if( metadata.TryGetValue( "general.alignment", out object? a ) && a is uint ua )
+			alignment = ua;
+		if( 0 == alignment || 0 != ( alignment & ( alignment - 1 ) ) )
+			throw new ArgumentException( $"GGUF alignment {alignment} is not a power of 2" );
+
+		var pending = new List<(string, eGgufTensorType, TensorShape, ulong)>();
+		for( ulong i = 0; i < countTensors; i++ )
+		{
+			string name = readString( reader );
+			TensorShape shape = readShape( reader );
+			eGgufTensorType type = (eGgufTensorType)reader.ReadUInt32();
+			ulong off = reader.ReadUInt64();
+			pending.Add( (name, type, shape, off) );
+		}
+
+		// The payload starts at the next aligned offset after the header
+		long payload = stream.Position;
+		payload = ( payload + alignment - 1 ) / alignment * alignment;
+
+		// The loader passes raw pointers into the mapped file to the native code, verify all tensors are within the file
+		long fileLength = stream.Length;
+		if( payload > fileLength )
+			throw new EndOfStreamException( "GGUF file is truncated" );
+		foreach( var (name, type, shape, off) in pending )
+		{
+			if( off > (ulong)( fileLength - payload ) )
+				throw new ArgumentException( $"GGUF tensor \"{name}\" starts after the end of the file" );
+			GgufTensor tensor = new GgufTensor( type, shape, payload + (long)off );
+			// Payload length of unsupported types is unknown, the loader rejects these tensors
+			if( tensor.isSupported && tensor.length > fileLength - tensor.offset )
+				throw new ArgumentException( $"GGUF tensor \"{name}\" ends after the end of the file" );
+			tensors.Add( new KeyValuePair<string, GgufTensor>( name, tensor ) );
+		}
+		tensors.Sort( ( a, b ) => a.Value.offset.CompareTo( b.Value.offset ) );
+	}
+
+	/// <summary>Parse the header of the file</summary>
+	public static Gguf readHeader( string path )
+	{
+		using var stream = File.OpenRead( path );
+		return new Gguf( stream );
+	}
+}
\ No newline at end of file
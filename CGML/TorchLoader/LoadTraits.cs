@@ -11,6 +11,10 @@ public abstract class LoadTraits
 	/// <summary>Override this method to specify load transformation for the tensor in the model</summary>
 	public virtual eLoadTransform tensorLoadTransform( eDataType storedType, string key ) => eLoadTransform.None;
 
+	/// <summary>llama.cpp permutes rows of Q and K matrices when converting models into GGUF, to use the interleaved rotary embedding.<br/>
+	/// Override this method to return count of attention heads in these tensors, and the GGUF loader will restore the original order of the rows.</summary>
+	public virtual int ggufPermutedHeads( string key ) => 0;
+
 	/// <summary>Merge action to combine tensors from different ZIP archives</summary>
 	/// <remarks>Llama-13B model contains 2 of them, Llama-30B model contains 4</remarks>
 	public enum eMergeTactic: byte
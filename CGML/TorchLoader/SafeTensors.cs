@@ -0,0 +1,141 @@
+﻿namespace Torch;
+using Cgml;
+using System.Buffers.Binary;
+using System.Runtime.InteropServices;
+using System.Text.Json;
+
+/// <summary>Metadata of a single tensor in <c>*.safetensors</c> file</summary>
+[StructLayout( LayoutKind.Auto )]
+public readonly struct SafeTensor
+{
+	/// <summary>Type of the tensor elements</summary>
+	public readonly eDataType dataType;
+
+	/// <summary>Shape of the tensor</summary>
+	public readonly TensorShape shape;
+
+	/// <summary>Offset of the payload, in bytes, relative to the start of the file</summary>
+	public readonly long offset;
+
+	/// <summary>Length of the payload in bytes</summary>
+	public readonly int length;
+
+	internal SafeTensor( eDataType dataType, in TensorShape shape, long offset, int length )
+	{
+		this.dataType = dataType;
+		this.shape = shape;
+		this.offset = offset;
+		this.length = length;
+	}
+
+	/// <summary>A string for debugger</summary>
+	public override string ToString() => $"{dataType} {shape.size}, {length} bytes at offset {offset}";
+}
+
+/// <summary>Parser for the header of <c>*.safetensors</c> files</summary>
+/// <seealso href="https://github.com/huggingface/safetensors#format" />
+public static class SafeTensors
+{
+	/// <summary>Name of the index file for multi-part models</summary>
+	public const string indexFileName = "model.safetensors.index.json";
+
+	/// <summary>File extension of the format</summary>
+	public const string extension = ".safetensors";
+
+	/// <summary>The header is a JSON; the format specification says it's limited to 100MB</summary>
+	const long maxHeaderLength = 100 * 1024 * 1024;
+
+	static eDataType parseDataType( string dtype )
+	{
+		switch( dtype )
+		{
+			case "F16":
+				return eDataType.FP16;
+			case "F32":
+				return eDataType.FP32;
+			case "BF16":
+				return eDataType.BF16;
+			case "U32":
+				return eDataType.U32;
+			default:
+				throw new NotSupportedException( $"safetensors data type \"{dtype}\" is not supported" );
+		}
+	}
+
+	/// <summary>Safetensors shapes are dense row major, with the outermost dimension first</summary>
+	static TensorShape parseShape( JsonElement shape )
+	{
+		int len = shape.GetArrayLength();
+		if( len > 4 )
+			throw new NotImplementedException( $"The tensor has {len} dimensions, the maximum supported is 4" );
+
+		Span<int> size = stackalloc int[ 4 ] { 1, 1, 1, 1 };
+		int i = len - 1;
+		foreach( JsonElement e in shape.EnumerateArray() )
+		{
+			int dim = e.GetInt32();
+			if( dim <= 0 )
+				throw new ArgumentException( "Empty tensors are not supported" );
+			size[ i-- ] = dim;
+		}
+		return new TensorShape( new Int128( size[ 0 ], size[ 1 ], size[ 2 ], size[ 3 ] ) );
+	}
+
+	/// <summary>Parse the header of the file</summary>
+	/// <remarks>The tensors are sorted by payload offset, so the file is accessed sequentially when loaded in that order</remarks>
+	public static List<KeyValuePair<string, SafeTensor>> readHeader( Stream stream )
+	{
+		Span<byte> prefix = stackalloc byte[ 8 ];
+		stream.ReadExactly( prefix );
+		long headerLength = BinaryPrimitives.ReadInt64LittleEndian( prefix );
+		if( headerLength <= 0 || headerLength > maxHeaderLength )
+			throw new ArgumentException( $"Invalid safetensors header length {headerLength}" );
+
+		byte[] json = new byte[ headerLength ];
+		stream.ReadExactly( json );
+
+		long payloadOffset = 8 + headerLength;
+		long fileLength = stream.CanSeek ? stream.Length : long.MaxValue;
+
+		using JsonDocument doc = JsonDocument.Parse( json );
+		var res = new List<KeyValuePair<string, SafeTensor>>();
+		foreach( JsonProperty prop in doc.RootElement.EnumerateObject() )
+		{
+			if( prop.Name == "__metadata__" )
+				continue;
+
+			JsonElement e = prop.Value;
+			eDataType dt = parseDataType( e.GetProperty( "dtype" ).GetString() ?? "" );
+			TensorShape shape = parseShape( e.GetProperty( "shape" ) );
+
+			JsonElement offsets = e.GetProperty( "data_offsets" );
+			if( offsets.GetArrayLength() != 2 )
+				throw new ArgumentException( $"Invalid data offsets for tensor \"{prop.Name}\"" );
+			long begin = offsets[ 0 ].GetInt64();
+			long end = offsets[ 1 ].GetInt64();
+
+			long cb = end - begin;
+			long expected = (long)shape.countElements() * dt.elementSize();
+			if( cb != expected )
+				throw new ArgumentException( $"Tensor \"{prop.Name}\" has {cb} bytes of payload, expected {expected}" );
+			if( cb > int.MaxValue )
+				throw new ArgumentException( $"Tensor \"{prop.Name}\" is too large" );
+
+			begin += payloadOffset;
+			if( begin < payloadOffset || begin + cb > fileLength )
+				throw new ArgumentException( $"Tensor \"{prop.Name}\" is outside of the file" );
+
+			res.Add( new KeyValuePair<string, SafeTensor>( prop.Name, new SafeTensor( dt, shape, begin, (int)cb ) ) );
+		}
+
+		res.Sort( ( a, b ) => a.Value.offset.CompareTo( b.Value.offset ) );
+		return res;
+	}
+
+	/// <summary>Parse the header of the file</summary>
+	public static List<KeyValuePair<string, SafeTensor>> readHeader( string path )
+	{
+		using var stream = File.OpenRead( path );
+		return readHeader( stream );
+	}
+}
\ No newline at end of file
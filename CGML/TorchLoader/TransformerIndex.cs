@@ -31,11 +31,16 @@ public sealed class TransformerIndex
 	internal string directory { get; private set; }
 
 	/// <summary>Try to deserialize index file stored in the directory</summary>
+	/// <remarks>When <c>pytorch_model.bin.index.json</c> is missing, the method tries <c>model.safetensors.index.json</c> instead</remarks>
 	public static TransformerIndex? tryLoad( string directory )
 	{
 		string jsonPath = Path.Combine( directory, indexFileName );
 		if( !File.Exists( jsonPath ) )
-			return null;
+		{
+			jsonPath = Path.Combine( directory, SafeTensors.indexFileName );
+			if( !File.Exists( jsonPath ) )
+				return null;
+		}
 
 		using var stream = File.OpenRead( jsonPath );
 		TransformerIndex? res = JsonSerializer.Deserialize<TransformerIndex>( stream );
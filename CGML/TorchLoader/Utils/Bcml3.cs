@@ -126,4 +126,9 @@ public static class Bcml3
 
 		Debug.Assert( bc3.IsEmpty );
 	}
+
+	/// <summary>Reshape matrix into BCML3, using AVX2 code in the native library</summary>
+	/// <remarks>Produces the same output as the managed version, and processes the panels in parallel</remarks>
+	public static void reshape( iDevice device, Span<uint> bc3, MatrixView<uint> qweight, MatrixView<float> scales, MatrixView<uint> qzeros ) =>
+		device.reshapeBcml3( bc3, qweight, scales, qzeros );
 }
\ No newline at end of file
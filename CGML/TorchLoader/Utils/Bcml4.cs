@@ -142,4 +142,9 @@ public static class Bcml4
 
 		Debug.Assert( bc4.IsEmpty );
 	}
+
+	/// <summary>Reshape matrix into BCML4, using AVX2 code in the native library</summary>
+	/// <remarks>Produces the same output as the managed version, and processes the panels in parallel</remarks>
+	public static void reshape( iDevice device, Span<uint> bc4, MatrixView<uint> qweight, MatrixView<ushort> scales, MatrixView<uint> qzeros ) =>
+		device.reshapeBcml4( bc4, qweight, scales, qzeros );
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+﻿namespace Torch;
+using System.Collections.Concurrent;
+
+/// <summary>A fixed count of large buffers, shared by the threads of the pipelined loaders</summary>
+/// <remarks>When all buffers are in use, the readers wait for the upload thread to release one.<br/>
+/// This limits RAM use when the disk is faster than the GPU uploads.</remarks>
+sealed class BufferPool: IDisposable
+{
+	public sealed class Buffer
+	{
+		LargeBuffer buffer;
+
+		/// <summary>Count of bytes in the buffer</summary>
+		public int length { get; private set; }
+
+		/// <summary>Grow the buffer if needed, and return writeable span of the specified length</summary>
+		public Span<byte> resize( int length )
+		{
+			Span<byte> span = buffer.resize( length );
+			this.length = length;
+			return span;
+		}
+
+		/// <summary>Create a read-only stream over a slice of the buffer</summary>
+		public UnmanagedMemoryStream readStream( int offset, int length )
+		{
+			if( offset < 0 || offset + length > this.length )
+				throw new ArgumentOutOfRangeException();
+			return buffer.readStream( offset, length );
+		}
+
+		/// <summary>Pointer to a slice of the buffer, for the APIs which consume the payload in place</summary>
+		public IntPtr pointer( int offset, int length )
+		{
+			if( offset < 0 || offset + length > this.length )
+				throw new ArgumentOutOfRangeException();
+			return buffer.pointer( offset, length );
+		}
+
+		internal void free() => buffer.Dispose();
+	}
+
+	readonly Buffer[] all;
+	readonly BlockingCollection<Buffer> available;
+
+	public BufferPool( int count )
+	{
+		all = new Buffer[ count ];
+		available = new BlockingCollection<Buffer>( new ConcurrentQueue<Buffer>(), count );
+		for( int i = 0; i < count; i++ )
+		{
+			all[ i ] = new Buffer();
+			available.Add( all[ i ] );
+		}
+	}
+
+	/// <summary>Get a buffer from the pool, wait for one if all of them are in use</summary>
+	public Buffer rent( CancellationToken cancel ) =>
+		available.Take( cancel );
+
+	/// <summary>Return the buffer to the pool</summary>
+	public void release( Buffer buffer ) =>
+		available.Add( buffer );
+
+	public void Dispose()
+	{
+		available.Dispose();
+		foreach( Buffer b in all )
+			b.free();
+	}
+}
\ No newline at end of file
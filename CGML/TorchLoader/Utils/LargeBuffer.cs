@@ -43,16 +43,29 @@ struct LargeBuffer: IDisposable
 		capacity = 0;
 	}
 
-	public UnmanagedMemoryStream readStream( int length )
+	/// <summary>Pointer to a slice of the buffer, valid until the next resize or dispose</summary>
+	public IntPtr pointer( int offset, int length )
 	{
 		if( data == IntPtr.Zero )
 			throw new ArgumentException( "The buffer has no data" );
-		if( length <= 0 || length > capacity )
+		if( offset < 0 || length <= 0 || offset + length > capacity )
+			throw new ArgumentOutOfRangeException();
+		return data + offset;
+	}
+
+	public UnmanagedMemoryStream readStream( int length ) =>
+		readStream( 0, length );
+
+	public UnmanagedMemoryStream readStream( int offset, int length )
+	{
+		if( data == IntPtr.Zero )
+			throw new ArgumentException( "The buffer has no data" );
+		if( offset < 0 || length <= 0 || offset + length > capacity )
 			throw new ArgumentOutOfRangeException();
 
 		unsafe
 		{
-			byte* pointer = (byte*)data;
+			byte* pointer = (byte*)data + offset;
 			return new UnmanagedMemoryStream( pointer, length, length, FileAccess.Read );
 		}
 	}
@@ -3,7 +3,7 @@ using Cgml;
 using System.IO.Compression;
 using eMergeTactic = LoadTraits.eMergeTactic;
 
-sealed class LoaderImpl: iWeightsLoader
+sealed partial class LoaderImpl: iWeightsLoader
 {
 	readonly iDevice device;
 	readonly LoadTraits traits;
@@ -75,133 +75,12 @@ sealed class LoaderImpl: iWeightsLoader
 		return true;
 	}
 
-	/// <summary>When all tensors on the list are duplicates, load one of them,
-	/// set multiple output dictionary entries into the same object, and log warning about it.</summary>
-	bool tryLoadDupes( Stream stream, long entryLength, List<PendingTensor> list )
-	{
-		if( isDuplicateTensors( entryLength, list ) )
-		{
-			PendingTensor pt = list[ 0 ];
-			loadTensor( stream, pt.tensor, pt.key, pt.payloadBytes );
-			iTensor tensor = tensors[ pt.key ];
-			for( int i = 1; i < list.Count; i++ )
-				tensors.Add( list[ i ].key, tensor );
-
-			// Log a warning message
-			string str = string.Join( ", ", list.Select( pt => pt.key ) );
-			Logger.Warning( $"Detected duplicate tensors: {str}" );
-			return true;
-		}
-		return false;
-	}
-
 	static int tensorSliceEnd( in PendingTensor pt )
 	{
 		int elts = pt.tensor.offset + pt.tensor.shape.countElements();
 		return elts * pt.tensor.storage.dataType.elementSize();
 	}
 
-	/// <summary>Advance the stream forward by the specified count of bytes</summary>
-	static void skipBytes( Stream stream, int count )
-	{
-		if( count < 0 )
-			throw new ArgumentOutOfRangeException();
-		if( 0 == count )
-			return;
-
-		if( stream.CanSeek )
-		{
-			stream.Seek( count, SeekOrigin.Current );
-			return;
-		}
-
-		// Seek anyway, by reading and then discarding bytes from the stream
-		const int maxBufferSize = 1024 * 16;
-		byte[] buffer = new byte[ Math.Min( maxBufferSize, count ) ]; // You can adjust the buffer size as needed
-		while( count > 0 )
-		{
-			int requested = Math.Min( buffer.Length, count );
-			int received = stream.Read( buffer, 0, requested );
-			if( 0 == received )
-				throw new EndOfStreamException();
-			count -= received;
-		}
-	}
-
-	/// <summary>Load tensor[s] from a ZIP entry which has paddings around or between the payloads of the tensors</summary>
-	/// <remarks>Implemented for <c>model.norm.weight</c> tensor inside <c>Mistral-7B-Instruct-v0.2/pytorch_model-00003-of-00003.bin</c> ZIP file.<br/>
-	/// That tensor has 8kb of data in 500MB ZIP entry, without other tensors in the entry.</remarks>
-	void loadPadded( Stream stream, List<PendingTensor> list, ZipArchiveEntry entry, string zipName )
-	{
-		eDataType dt = list[ 0 ].tensor.storage.dataType;
-		int cbElement = dt.elementSize();
-		for( int i = 1; i < list.Count; i++ )
-		{
-			PendingTensor curr = list[ i ];
-			if( curr.tensor.storage.dataType != dt )
-				throw new ArgumentException( "A single ZIP entry contains tensors of different data types. This is not supported" );
-
-			PendingTensor prev = list[ i - 1 ];
-			int prevEnd = tensorSliceEnd( prev );
-			int currBegin = cbElement * curr.tensor.offset;
-			if( prevEnd > currBegin )
-				throw new ArgumentException( "Overlapped tensors in a single ZIP entry" );
-		}
-
-		long entryLength = entry.Length;
-		{
-			PendingTensor last = list[ list.Count - 1 ];
-			int lastEnd = tensorSliceEnd( last );
-			if( lastEnd > entryLength )
-				throw new ArgumentException( $"ZIP entry is {entryLength} bytes, metadata says the last tensor in that entry ends at offset {lastEnd}" );
-		}
-
-		// Things are good so far, load these tensors
-		int off = 0;
-		foreach( PendingTensor pt in list )
-		{
-			int begin = cbElement * pt.tensor.offset;
-			if( begin < off )
-				throw new ApplicationException();
-
-			if( begin > off )
-			{
-				skipBytes( stream, begin - off );
-				off = begin;
-			}
-
-			int payloadBytes = pt.payloadBytes;
-			loadTensor( stream, pt.tensor, pt.key, payloadBytes );
-			off += payloadBytes;
-		}
-
-		string wasted = Cgml.MiscUtils.printMemoryUse( entryLength - list.Sum( pt => pt.payloadBytes ) );
-		string tensors = string.Join( ", ", list.Select( pt => pt.key ) );
-		Logger.Warning( $"{wasted} unused data in {zipName}/{entry.FullName}: {tensors}" );
-	}
-
-	void loadTensors( ZipArchiveEntry entry, LoadMap map, string zipName )
-	{
-		string name = entry.Name;
-		if( !map.TryGetValue( name, out var list ) )
-			throw new ArgumentException( $"ZIP entry \"{entry.FullName}\" doesn't correspond to any tensor" );
-		map.Remove( name );
-
-		int cb = list.Sum( pt => pt.payloadBytes );
-		using Stream stream = entry.Open();
-		if( cb == entry.Length )
-		{
-			foreach( PendingTensor pt in list )
-				loadTensor( stream, pt.tensor, pt.key, pt.payloadBytes );
-			return;
-		}
-
-		if( tryLoadDupes( stream, entry.Length, list ) )
-			return;
-
-		loadPadded( stream, list, entry, zipName );
-	}
-
 	static IEnumerable<(ZipArchive, string)> metadataSource( ZipArchives zip, string[] subdirs )
 	{
 		for( int i = 0; i < zip.length; i++ )
@@ -213,27 +92,7 @@ sealed class LoaderImpl: iWeightsLoader
 
 	void loadSingle( string path, bool waitForCompressor )
 	{
-		using Stream zipStream = File.OpenRead( path );
-		using ZipArchive zip = new ZipArchive( zipStream, ZipArchiveMode.Read );
-
-		string subdir = Path.GetFileNameWithoutExtension( path );
-		Dictionary<string, Tensor> metadata = MetadataLoader.load( zip, $"{subdir}/data.pkl" );
-		subdir = $"{subdir}/data/";
-
-		LoadMap ordered = makeLoadMap( metadata );
-
-		foreach( ZipArchiveEntry entry in zip.Entries )
-		{
-			string fullName = entry.FullName;
-			fullName = fullName.Replace( '\\', '/' );
-			if( !fullName.StartsWith( subdir ) )
-				continue;
-
-			loadTensors( entry, ordered, Path.GetFileName( path ) );
-		}
-
-		if( ordered.Count > 0 )
-			throw new ApplicationException( "Some tensors were mentioned in the metadata, but the weights were not found in the ZIP" );
+		loadPipelined( new string[ 1 ] { path } );
 
 		if( waitForCompressor )
 			device.waitForWeightsCompressor();
@@ -383,19 +242,6 @@ sealed class LoaderImpl: iWeightsLoader
 		device.waitForWeightsCompressor();
 	}
 
-	void loadTensor( Stream stream, Tensor tensor, string key, int byteWidth )
-	{
-		if( tensors.ContainsKey( key ) )
-			throw new ApplicationException( "Already loaded" );
-		sTensorDesc desc;
-		desc.shape = tensor.shape;
-		desc.dataType = tensor.storage.dataType;
-		desc.usage = eBufferUse.Immutable;
-		desc.layout = traits.tensorVramLayout( key );
-		eLoadTransform tform = traits.tensorLoadTransform( tensor.storage.dataType, key );
-		tensors[ key ] = device.loadImmutableTensor( ref desc, stream, byteWidth, tform );
-	}
-
 	void loadMergedTensor( Tensor[] tensors, string key, ReadOnlySpan<byte> payload, eMergeTactic merge )
 	{
 		if( this.tensors.ContainsKey( key ) )
@@ -449,8 +295,18 @@ sealed class LoaderImpl: iWeightsLoader
 	{
 		try
 		{
+			List<string> archives = new List<string>();
 			foreach( string path in index.listDataFiles() )
-				loadSingle( path, false );
+			{
+				if( isSafeTensors( path ) )
+					loadSafeTensors( path, false );
+				else
+					archives.Add( path );
+			}
+
+			// All pickled shards are read concurrently, by a single pipeline
+			if( archives.Count > 0 )
+				loadPipelined( archives );
 		}
 		catch
 		{
@@ -0,0 +1,82 @@
+﻿namespace Torch;
+using Cgml;
+
+sealed partial class LoaderImpl
+{
+	/// <summary>Reject unsupported types, and un-permute Q and K rows into the buffer</summary>
+	/// <remarks>The payloads of other tensors are uploaded straight from the mapped pages, read them in advance</remarks>
+	unsafe IntPtr prepareGgufTensor( IntPtr mapping, string key, in GgufTensor gt, BufferPool.Buffer buffer )
+	{
+		if( !gt.isSupported )
+			throw new NotSupportedException( $"Tensor \"{key}\" has unsupported GGUF type {(uint)gt.type}" );
+
+		byte* rsi = (byte*)mapping + gt.offset;
+		int length = gt.length;
+
+		int heads = traits.ggufPermutedHeads( key );
+		if( heads <= 0 )
+		{
+			prefault( rsi, length );
+			return (IntPtr)rsi;
+		}
+
+		fixed( byte* unpermuted = buffer.resize( length ) )
+			unpermuteRows( unpermuted, rsi, gt.shape.size.y, length, heads, key );
+		return buffer.pointer( 0, length );
+	}
+
+	/// <summary>Undo the permutation applied to Q and K matrices by llama.cpp conversion script</summary>
+	/// <remarks>The script reshapes rows of each head into [ 2, headDim / 2 ] matrix, and transposes that matrix.<br/>
+	/// Quantized blocks never cross rows, so the rows are moved as opaque bytes.</remarks>
+	static unsafe void unpermuteRows( byte* rdi, byte* rsi, int rows, int length, int heads, string key )
+	{
+		if( 0 != rows % ( heads * 2 ) || 0 != length % rows )
+			throw new ArgumentException( $"Tensor \"{key}\" with {rows} rows can't be split into {heads} heads" );
+
+		int rowBytes = length / rows;
+		int headRows = rows / heads;
+		int half = headRows / 2;
+		for( int h = 0; h < heads; h++ )
+		{
+			int head = h * headRows;
+			for( int r = 0; r < headRows; r++ )
+			{
+				// Output row [ s, j ] comes from the source row [ j, s ]
+				int source = head + ( r % half ) * 2 + r / half;
+				Buffer.MemoryCopy( rsi + (long)source * rowBytes, rdi + (long)( head + r ) * rowBytes, rowBytes, rowBytes );
+			}
+		}
+	}
+
+	unsafe iTensor loadGgufTensor( IntPtr payload, string key, in GgufTensor gt )
+	{
+		sTensorDesc desc;
+		desc.shape = gt.shape;
+		desc.dataType = gt.dataType;
+		desc.usage = eBufferUse.Immutable;
+		desc.layout = traits.tensorVramLayout( key );
+		int length = gt.length;
+
+		eGgmlType? quantized = gt.quantized;
+		if( quantized.HasValue )
+		{
+			// 8-bit blocks are quantized again into BCML1 by the weights compressor,
+			// 4-bit blocks are reshaped into BCML1 panels on this thread, or decompressed into dense FP16
+			return device.uploadQuantizedTensor( ref desc, quantized.Value, payload, length );
+		}
+
+		eLoadTransform tform = traits.tensorLoadTransform( desc.dataType, key );
+		if( desc.layout != eTensorLayout.Dense || tform == eLoadTransform.None )
+			return device.uploadImmutableTensor( ref desc, payload, length );
+
+		using var stream = new UnmanagedMemoryStream( (byte*)payload, length, length, FileAccess.Read );
+		return device.loadImmutableTensor( ref desc, stream, length, tform );
+	}
+
+	void iWeightsLoader.loadGguf( string path )
+	{
+		Gguf gguf = Gguf.readHeader( path );
+		loadMapped( path, gguf.tensors, prepareGgufTensor, loadGgufTensor );
+		device.waitForWeightsCompressor();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+﻿namespace Torch;
+using Cgml;
+using System.Collections.Concurrent;
+using System.IO.MemoryMappedFiles;
+using System.Runtime.ExceptionServices;
+
+sealed partial class LoaderImpl
+{
+	/// <summary>Count of tensors prepared in parallel; each of them may need a temporary buffer as large as the tensor.<br/>
+	/// Too many of them gonna waste RAM without making the import any faster.</summary>
+	static int maxParallelTensors => Math.Clamp( Environment.ProcessorCount, 1, 8 );
+
+	/// <summary>Get the payload of a tensor ready for upload</summary>
+	/// <remarks>Called on the thread pool, with the pointer to the start of the file.<br/>
+	/// Returns pointer to the payload, either in the mapped file, or in the buffer when the payload needs to be rearranged.</remarks>
+	delegate IntPtr pfnPrepareMapped<T>( IntPtr mapping, string key, in T tensor, BufferPool.Buffer buffer );
+
+	/// <summary>Create the tensor in VRAM from the prepared payload</summary>
+	/// <remarks>Called on a single thread, the D3D device is created with <c>D3D11_CREATE_DEVICE_SINGLETHREADED</c> flag</remarks>
+	delegate iTensor pfnUploadMapped<T>( IntPtr payload, string key, in T tensor );
+
+	/// <summary>Prepared payload of the tensor at the specified index in the list</summary>
+	readonly struct MappedPayload
+	{
+		public readonly int index;
+		public readonly IntPtr payload;
+		public readonly BufferPool.Buffer buffer;
+
+		public MappedPayload( int index, IntPtr payload, BufferPool.Buffer buffer )
+		{
+			this.index = index;
+			this.payload = payload;
+			this.buffer = buffer;
+		}
+	}
+
+	/// <summary>Read a byte from every page of the payload, so the upload doesn't wait for the disk</summary>
+	static unsafe void prefault( byte* rsi, long length )
+	{
+		for( long i = 0; i < length; i += Environment.SystemPageSize )
+			Volatile.Read( ref rsi[ i ] );
+	}
+
+	/// <summary>Prepare the tensors on the thread pool, and upload them on the calling thread</summary>
+	/// <remarks>The buffer pool limits count of tensors in flight: one per preparing thread, and one more being uploaded.</remarks>
+	static void uploadMapped<T>( IntPtr mapping, List<KeyValuePair<string, T>> list, pfnPrepareMapped<T> prepare, pfnUploadMapped<T> upload, iTensor?[] loaded )
+	{
+		int workers = maxParallelTensors;
+		using var pool = new BufferPool( workers + 1 );
+		using var queue = new BlockingCollection<MappedPayload>();
+		using var cts = new CancellationTokenSource();
+		CancellationToken cancel = cts.Token;
+
+		Task producer = Task.Run( () =>
+		{
+			try
+			{
+				ParallelOptions po = new ParallelOptions { MaxDegreeOfParallelism = workers, CancellationToken = cancel };
+				Parallel.For( 0, list.Count, po, i =>
+				{
+					BufferPool.Buffer buffer = pool.rent( cancel );
+					try
+					{
+						var kvp = list[ i ];
+						IntPtr payload = prepare( mapping, kvp.Key, kvp.Value, buffer );
+						queue.Add( new MappedPayload( i, payload, buffer ), cancel );
+					}
+					catch
+					{
+						pool.release( buffer );
+						throw;
+					}
+				} );
+			}
+			finally
+			{
+				queue.CompleteAdding();
+			}
+		} );
+
+		List<Exception> errors = new List<Exception>();
+		try
+		{
+			foreach( MappedPayload mp in queue.GetConsumingEnumerable() )
+			{
+				try
+				{
+					var kvp = list[ mp.index ];
+					loaded[ mp.index ] = upload( mp.payload, kvp.Key, kvp.Value );
+				}
+				finally
+				{
+					pool.release( mp.buffer );
+				}
+			}
+		}
+		catch( Exception ex )
+		{
+			errors.Add( ex );
+			cts.Cancel();
+		}
+
+		try
+		{
+			producer.Wait();
+		}
+		catch( AggregateException ex )
+		{
+			// Cancellations are consequences of the upload failure, don't report them
+			errors.AddRange( ex.Flatten().InnerExceptions.Where( e => e is not OperationCanceledException ) );
+		}
+
+		if( 1 == errors.Count )
+			ExceptionDispatchInfo.Throw( errors[ 0 ] );
+		if( errors.Count > 1 )
+			throw new AggregateException( errors );
+	}
+
+	/// <summary>Memory map the file, prepare the tensors in parallel, and upload them on the calling thread</summary>
+	void loadMapped<T>( string path, List<KeyValuePair<string, T>> list, pfnPrepareMapped<T> prepare, pfnUploadMapped<T> upload )
+	{
+		foreach( var kvp in list )
+			if( tensors.ContainsKey( kvp.Key ) )
+				throw new ApplicationException( $"Tensor \"{kvp.Key}\" is already loaded" );
+
+		using var file = MemoryMappedFile.CreateFromFile( path, FileMode.Open, null, 0, MemoryMappedFileAccess.Read );
+		using var view = file.CreateViewAccessor( 0, 0, MemoryMappedFileAccess.Read );
+		var handle = view.SafeMemoryMappedViewHandle;
+
+		iTensor?[] loaded = new iTensor?[ list.Count ];
+		unsafe
+		{
+			byte* mapping = null;
+			handle.AcquirePointer( ref mapping );
+			try
+			{
+				uploadMapped( (IntPtr)( mapping + view.PointerOffset ), list, prepare, upload, loaded );
+			}
+			catch
+			{
+				foreach( iTensor? t in loaded )
+					t?.Dispose();
+				throw;
+			}
+			finally
+			{
+				handle.ReleasePointer();
+			}
+		}
+
+		for( int i = 0; i < list.Count; i++ )
+			tensors.Add( list[ i ].Key, loaded[ i ]! );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+﻿namespace Torch;
+using Cgml;
+using System.Collections.Concurrent;
+using System.IO.Compression;
+using System.Runtime.ExceptionServices;
+
+sealed partial class LoaderImpl
+{
+	/// <summary>Payload of a ZIP entry in system memory, with the tensors it contains</summary>
+	sealed class LoadedEntry
+	{
+		/// <summary>ZIP file name and entry name, for log messages</summary>
+		public readonly string name;
+		public readonly long entryLength;
+		public readonly List<PendingTensor> list;
+		public readonly BufferPool.Buffer buffer;
+
+		public LoadedEntry( string name, long entryLength, List<PendingTensor> list, BufferPool.Buffer buffer )
+		{
+			this.name = name;
+			this.entryLength = entryLength;
+			this.list = list;
+			this.buffer = buffer;
+		}
+	}
+
+	/// <summary>Reader thread: unpickle the metadata, then read payload entries of the ZIP into pooled buffers</summary>
+	/// <remarks>Entries are read up to the end of the last tensor, unused data after that is skipped</remarks>
+	void readArchive( string path, BufferPool pool, BlockingCollection<LoadedEntry> queue, CancellationToken cancel )
+	{
+		using Stream zipStream = File.OpenRead( path );
+		using ZipArchive zip = new ZipArchive( zipStream, ZipArchiveMode.Read );
+
+		string subdir = Path.GetFileNameWithoutExtension( path );
+		Dictionary<string, Tensor> metadata = MetadataLoader.load( zip, $"{subdir}/data.pkl" );
+		subdir = $"{subdir}/data/";
+
+		LoadMap ordered = makeLoadMap( metadata );
+		string zipName = Path.GetFileName( path );
+
+		foreach( ZipArchiveEntry entry in zip.Entries )
+		{
+			string fullName = entry.FullName;
+			fullName = fullName.Replace( '\\', '/' );
+			if( !fullName.StartsWith( subdir ) )
+				continue;
+
+			string name = entry.Name;
+			if( !ordered.TryGetValue( name, out var list ) )
+				throw new ArgumentException( $"ZIP entry \"{entry.FullName}\" doesn't correspond to any tensor" );
+			ordered.Remove( name );
+
+			int cb = (int)Math.Min( entry.Length, list.Max( pt => tensorSliceEnd( pt ) ) );
+			BufferPool.Buffer buffer = pool.rent( cancel );
+			try
+			{
+				using( Stream stream = entry.Open() )
+					stream.ReadExactly( buffer.resize( cb ) );
+				queue.Add( new LoadedEntry( $"{zipName}/{entry.FullName}", entry.Length, list, buffer ), cancel );
+			}
+			catch
+			{
+				pool.release( buffer );
+				throw;
+			}
+		}
+
+		if( ordered.Count > 0 )
+			throw new ApplicationException( "Some tensors were mentioned in the metadata, but the weights were not found in the ZIP" );
+	}
+
+	/// <summary>Add the tensor to the output dictionary, with one or more keys</summary>
+	void addTensor( iTensor tensor, params string[] keys )
+	{
+		lock( tensors )
+		{
+			string? dupe = keys.FirstOrDefault( tensors.ContainsKey );
+			if( null == dupe )
+			{
+				foreach( string key in keys )
+					tensors.Add( key, tensor );
+				return;
+			}
+			tensor.Dispose();
+			throw new ApplicationException( $"Tensor \"{dupe}\" is already loaded" );
+		}
+	}
+
+	/// <summary>Create immutable tensor in VRAM from a slice of the buffer</summary>
+	/// <remarks>The native side consumes the pooled buffer in place, without making another copy of the payload in system memory</remarks>
+	iTensor uploadTensor( BufferPool.Buffer buffer, int offset, in PendingTensor pt )
+	{
+		sTensorDesc desc;
+		desc.shape = pt.tensor.shape;
+		desc.dataType = pt.tensor.storage.dataType;
+		desc.usage = eBufferUse.Immutable;
+		desc.layout = traits.tensorVramLayout( pt.key );
+		eLoadTransform tform = traits.tensorLoadTransform( desc.dataType, pt.key );
+
+		int length = pt.payloadBytes;
+		// Compressed tensors don't support load transforms, same as iDevice.loadImmutableTensor
+		if( desc.layout != eTensorLayout.Dense || tform == eLoadTransform.None )
+			return device.uploadImmutableTensor( ref desc, buffer.pointer( offset, length ), length );
+
+		// The transforms read the stream in chunks, converting them straight into the output buffer
+		using var stream = buffer.readStream( offset, length );
+		return device.loadImmutableTensor( ref desc, stream, length, tform );
+	}
+
+	/// <summary>Load tensor[s] from a ZIP entry which has paddings around or between the payloads of the tensors</summary>
+	/// <remarks>Implemented for <c>model.norm.weight</c> tensor inside <c>Mistral-7B-Instruct-v0.2/pytorch_model-00003-of-00003.bin</c> ZIP file.<br/>
+	/// That tensor has 8kb of data in 500MB ZIP entry, without other tensors in the entry.</remarks>
+	void uploadPadded( LoadedEntry entry )
+	{
+		List<PendingTensor> list = entry.list;
+		eDataType dt = list[ 0 ].tensor.storage.dataType;
+		int cbElement = dt.elementSize();
+		for( int i = 1; i < list.Count; i++ )
+		{
+			PendingTensor curr = list[ i ];
+			if( curr.tensor.storage.dataType != dt )
+				throw new ArgumentException( "A single ZIP entry contains tensors of different data types. This is not supported" );
+
+			PendingTensor prev = list[ i - 1 ];
+			int prevEnd = tensorSliceEnd( prev );
+			int currBegin = cbElement * curr.tensor.offset;
+			if( prevEnd > currBegin )
+				throw new ArgumentException( "Overlapped tensors in a single ZIP entry" );
+		}
+
+		long entryLength = entry.entryLength;
+		{
+			PendingTensor last = list[ list.Count - 1 ];
+			int lastEnd = tensorSliceEnd( last );
+			if( lastEnd > entryLength )
+				throw new ArgumentException( $"ZIP entry is {entryLength} bytes, metadata says the last tensor in that entry ends at offset {lastEnd}" );
+		}
+
+		// Things are good so far, load these tensors
+		foreach( PendingTensor pt in list )
+			addTensor( uploadTensor( entry.buffer, cbElement * pt.tensor.offset, pt ), pt.key );
+
+		string wasted = Cgml.MiscUtils.printMemoryUse( entryLength - list.Sum( pt => pt.payloadBytes ) );
+		string tensors = string.Join( ", ", list.Select( pt => pt.key ) );
+		Logger.Warning( $"{wasted} unused data in {entry.name}: {tensors}" );
+	}
+
+	void uploadEntry( LoadedEntry entry )
+	{
+		List<PendingTensor> list = entry.list;
+		int cb = list.Sum( pt => pt.payloadBytes );
+		if( cb == entry.entryLength )
+		{
+			int off = 0;
+			foreach( PendingTensor pt in list )
+			{
+				addTensor( uploadTensor( entry.buffer, off, pt ), pt.key );
+				off += pt.payloadBytes;
+			}
+			return;
+		}
+
+		if( isDuplicateTensors( entry.entryLength, list ) )
+		{
+			// Load one of them, set multiple output dictionary entries into the same object, and log warning about it
+			iTensor tensor = uploadTensor( entry.buffer, 0, list[ 0 ] );
+			addTensor( tensor, list.Select( pt => pt.key ).ToArray() );
+
+			string str = string.Join( ", ", list.Select( pt => pt.key ) );
+			Logger.Warning( $"Detected duplicate tensors: {str}" );
+			return;
+		}
+
+		uploadPadded( entry );
+	}
+
+	/// <summary>Upload thread: consume entries from the queue, and return the buffers to the pool</summary>
+	void uploadEntries( BufferPool pool, BlockingCollection<LoadedEntry> queue, CancellationToken cancel )
+	{
+		foreach( LoadedEntry entry in queue.GetConsumingEnumerable( cancel ) )
+		{
+			try
+			{
+				uploadEntry( entry );
+			}
+			finally
+			{
+				pool.release( entry.buffer );
+			}
+		}
+	}
+
+	/// <summary>Load pickled ZIP archives with a pipeline: a reader thread per archive, and a single upload thread</summary>
+	/// <remarks>The readers decompress ZIP entries in parallel. The D3D device is created with <c>D3D11_CREATE_DEVICE_SINGLETHREADED</c> flag,
+	/// all device calls are made by the upload thread.<br/>
+	/// The buffer pool limits count of entries in flight: one per reader, up to <see cref="maxParallelTensors" />, and one more being uploaded.<br/>
+	/// When all buffers are in use, the readers wait for the uploads.<br/>
+	/// Unpickling the metadata of one archive overlaps with reading and uploading tensors of the others.</remarks>
+	void loadPipelined( IReadOnlyList<string> paths )
+	{
+		using var pool = new BufferPool( Math.Min( paths.Count, maxParallelTensors ) + 1 );
+		using var queue = new BlockingCollection<LoadedEntry>();
+		using var cts = new CancellationTokenSource();
+		CancellationToken cancel = cts.Token;
+
+		// Run the action on a dedicated thread; when it fails, cancel the rest of the pipeline
+		Task start( Action act ) => Task.Factory.StartNew( () =>
+		{
+			try
+			{
+				act();
+			}
+			catch
+			{
+				cts.Cancel();
+				throw;
+			}
+		}, CancellationToken.None, TaskCreationOptions.LongRunning, TaskScheduler.Default );
+
+		Task[] readers = paths.Select( p => start( () => readArchive( p, pool, queue, cancel ) ) ).ToArray();
+		Task uploader = start( () => uploadEntries( pool, queue, cancel ) );
+
+		try
+		{
+			Task.WaitAll( readers );
+		}
+		catch( AggregateException ) { }
+		queue.CompleteAdding();
+		try
+		{
+			uploader.Wait();
+		}
+		catch( AggregateException ) { }
+
+		// Cancellations are consequences of the other failures, don't report them
+		List<Exception> errors = readers.Append( uploader )
+			.Where( t => t.IsFaulted )
+			.SelectMany( t => t.Exception!.InnerExceptions )
+			.Where( e => e is not OperationCanceledException )
+			.ToList();
+		if( 1 == errors.Count )
+			ExceptionDispatchInfo.Throw( errors[ 0 ] );
+		if( errors.Count > 1 )
+			throw new AggregateException( errors );
+	}
+}
\ No newline at end of file
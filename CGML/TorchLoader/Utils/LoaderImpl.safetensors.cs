@@ -0,0 +1,48 @@
+﻿namespace Torch;
+using Cgml;
+
+sealed partial class LoaderImpl
+{
+	static bool isSafeTensors( string path ) =>
+		path.EndsWith( SafeTensors.extension, StringComparison.OrdinalIgnoreCase );
+
+	/// <summary>Safetensors payloads are uploaded straight from the mapped pages, read them in advance</summary>
+	static unsafe IntPtr prepareSafeTensor( IntPtr mapping, string key, in SafeTensor st, BufferPool.Buffer buffer )
+	{
+		byte* rsi = (byte*)mapping + st.offset;
+		prefault( rsi, st.length );
+		return (IntPtr)rsi;
+	}
+
+	unsafe iTensor loadSafeTensor( IntPtr payload, string key, in SafeTensor st )
+	{
+		sTensorDesc desc;
+		desc.shape = st.shape;
+		desc.dataType = st.dataType;
+		desc.usage = eBufferUse.Immutable;
+		desc.layout = traits.tensorVramLayout( key );
+		eLoadTransform tform = traits.tensorLoadTransform( st.dataType, key );
+
+		// Compressed tensors don't support load transforms, same as iDevice.loadImmutableTensor
+		if( desc.layout != eTensorLayout.Dense || tform == eLoadTransform.None )
+		{
+			// Create the buffer in VRAM straight from the mapped pages
+			return device.uploadImmutableTensor( ref desc, payload, st.length );
+		}
+
+		using var stream = new UnmanagedMemoryStream( (byte*)payload, st.length, st.length, FileAccess.Read );
+		return device.loadImmutableTensor( ref desc, stream, st.length, tform );
+	}
+
+	void loadSafeTensors( string path, bool waitForCompressor )
+	{
+		List<KeyValuePair<string, SafeTensor>> list = SafeTensors.readHeader( path );
+		loadMapped( path, list, prepareSafeTensor, loadSafeTensor );
+
+		if( waitForCompressor )
+			device.waitForWeightsCompressor();
+	}
+
+	void iWeightsLoader.loadSafeTensors( string path ) =>
+		loadSafeTensors( path, true );
+}
\ No newline at end of file
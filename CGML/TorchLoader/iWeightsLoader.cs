@@ -13,6 +13,17 @@ public interface iWeightsLoader: IDisposable
 	/// <summary>Merge tensors from multiple ZIP archives</summary>
 	void loadMultipart( string[] sources );
 
+	/// <summary>Load tensors from a single <c>*.safetensors</c> file</summary>
+	/// <remarks>The file is memory mapped, and the tensors are converted in parallel</remarks>
+	void loadSafeTensors( string path );
+
+	/// <summary>Load tensors from a GGUF file produced by llama.cpp</summary>
+	/// <remarks>Q4_0 and Q4_1 tensors loaded into <see cref="eTensorLayout.BCML1" /> layout are repacked without quantizing them again.<br/>
+	/// Tensor names are the ones from the GGUF file, e.g. <c>blk.0.attn_q.weight</c>.<br/>
+	/// Rows of Q and K matrices are restored into the original order when <see cref="LoadTraits.ggufPermutedHeads" /> returns a positive number.</remarks>
+	void loadGguf( string path );
+
 	/// <summary>Load all tensors listed in the index file</summary>
+	/// <remarks>The index may reference either pickled ZIP archives, or <c>*.safetensors</c> files</remarks>
 	void loadTransformer( TransformerIndex index );
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 using Mistral;
 using MistralChat.ViewModels;
 using System.Diagnostics;
+using System.Text;
 
 /// <summary>Base class for both generator implementations</summary>
 abstract class Generator: ChatClient
@@ -13,22 +14,31 @@ The assistant gives helpful, detailed, and polite answers to the user's question
 
 	protected volatile bool shouldCancel = false;
 
-	public override string? tryMakeResponse( string text )
+	/// <summary>Find the marker in the new characters of the text, return -1 if not found</summary>
+	/// <remarks>The marker may start a few characters before, when it's split between tokens</remarks>
+	static int findMarker( StringBuilder text, int newText, string marker )
+	{
+		int start = Math.Max( 0, newText - ( marker.Length - 1 ) );
+		int idx = text.ToString( start, text.Length - start ).IndexOf( marker, StringComparison.OrdinalIgnoreCase );
+		return ( idx < 0 ) ? -1 : start + idx;
+	}
+
+	public override string? tryMakeResponse( StringBuilder text, int newText )
 	{
 		if( shouldCancel )
-			return text;
+			return text.ToString();
 
-		int idx = text.IndexOf( "USER:", StringComparison.OrdinalIgnoreCase );
+		int idx = findMarker( text, newText, "USER:" );
 		if( idx > 0 )
-			return text.Substring( 0, idx ).Trim();
+			return text.ToString( 0, idx ).Trim();
 
 		// It seems sometimes the model uses "</s>" to mark end of string.
 		// It doesn’t always encode it as the EOS token.
-		idx = text.IndexOf( "</s>", StringComparison.OrdinalIgnoreCase );
+		idx = findMarker( text, newText, "</s>" );
 		if( idx > 0 )
-			return text.Substring( 0, idx ).Trim();
+			return text.ToString( 0, idx ).Trim();
 
-		m_pending.setText( text );
+		m_pending.setText( text.ToString() );
 		return null;
 	}
 
@@ -4,31 +4,42 @@ using System.Text;
 
 /// <summary>Utility class to generate chat prompts for Mistral</summary>
 /// <seealso href="https://www.promptingguide.ai/models/mistral-7b#chat-template-for-mistral-7b-instruct" />
+/// <remarks>Segments which don’t change between requests, i.e. the initial prompt and the old messages, are only tokenized once.</remarks>
 sealed class PromptBuilder
 {
 	readonly StringBuilder sb = new StringBuilder();
 	readonly List<int> tokens = new List<int>();
+	readonly TokenCache cache = new TokenCache();
 
-	/// <summary>Encode a prompt with a single message</summary>
-	public IReadOnlyList<int> single( iTokenizer tokenizer, string text, string? initialPrompt = null )
+	/// <summary>Append tokens of the <c>[INST]</c> block with the message</summary>
+	/// <remarks>The initial prompt is a separate segment, the space between the prompt and the text becomes the dummy prefix of the text.</remarks>
+	void instruction( iTokenizer tokenizer, string text, string? initialPrompt, bool immutable )
 	{
 		sb.Clear();
-		sb.Append( "[INST]" );
 		if( !string.IsNullOrWhiteSpace( initialPrompt ) )
-		{
-			sb.Append( initialPrompt );
-			sb.Append( ' ' );
-		}
+			cache.encode( tokens, tokenizer, "[INST]" + initialPrompt );
+		else
+			sb.Append( "[INST]" );
 		sb.Append( text );
 		sb.Append( "[/INST]" );
 
+		if( immutable )
+			cache.encode( tokens, tokenizer, sb.ToString() );
+		else
+			tokenizer.encode( tokens, sb.ToString() );
+	}
+
+	/// <summary>Encode a prompt with a single message</summary>
+	public IReadOnlyList<int> single( iTokenizer tokenizer, string text, string? initialPrompt = null )
+	{
 		tokens.Clear();
-		tokenizer.encode( tokens, sb.ToString() );
+		instruction( tokenizer, text, initialPrompt, false );
 		return tokens;
 	}
 
 	/// <summary>Encode prompt with conversation history, and one last message</summary>
-	/// <remarks>The history parameter is a sequence of [ user, bot ] string tuples.</remarks>
+	/// <remarks>The history parameter is a sequence of [ user, bot ] string tuples.<br/>
+	/// Each message of the history is a separate segment, encoded the same way as when it was the last message.</remarks>
 	public IReadOnlyList<int> complete( iTokenizer tokenizer, IEnumerable<(string, string)> history, string last, string? initialPrompt = null )
 	{
 		if( !history.Any() )
@@ -37,32 +48,16 @@ sealed class PromptBuilder
 		tokens.Clear();
 		tokens.Add( tokenizer.idBOS );
 
-		sb.Clear();
 		foreach( (string user, string bot) in history )
 		{
-			sb.Append( "[INST]" );
-
-			if( !string.IsNullOrWhiteSpace( initialPrompt ) )
-			{
-				sb.Append( initialPrompt );
-				sb.Append( ' ' );
-				initialPrompt = null;
-			}
-
-			sb.Append( user );
-			sb.Append( "[/INST]" );
-			sb.Append( bot );
+			instruction( tokenizer, user, initialPrompt, true );
+			initialPrompt = null;
+			cache.encode( tokens, tokenizer, bot );
 		}
-		tokenizer.encode( tokens, sb.ToString() );
 
 		tokens.Add( tokenizer.idEOS );
 
-		sb.Clear();
-		sb.Append( "[INST]" );
-		sb.Append( last );
-		sb.Append( "[/INST]" );
-		tokenizer.encode( tokens, sb.ToString() );
-
+		instruction( tokenizer, last, null, false );
 		return tokens;
 	}
 }
\ No newline at end of file
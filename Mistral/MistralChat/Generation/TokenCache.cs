@@ -0,0 +1,67 @@
+﻿namespace MistralChat;
+using Mistral;
+
+/// <summary>Memoizes tokens of immutable prompt segments, like the system prompt and the old messages of the conversation</summary>
+/// <remarks>SentencePiece splits text on whitespace before merging the pieces,
+/// so when the segments are separated by spaces, concatenated tokens of the segments are equal to the tokens of the concatenated text.</remarks>
+sealed class TokenCache
+{
+	/// <summary>When the cache grows above this count of segments, least recently used half of them is evicted</summary>
+	const int capacity = 256;
+
+	sealed class Entry
+	{
+		public readonly int[] tokens;
+		public long lastUsed;
+
+		public Entry( int[] tokens, long lastUsed )
+		{
+			this.tokens = tokens;
+			this.lastUsed = lastUsed;
+		}
+	}
+
+	readonly Dictionary<string, Entry> dict = new Dictionary<string, Entry>();
+	readonly List<int> buffer = new List<int>();
+	iTokenizer? tokenizer;
+	long timestamp = 0;
+
+	void evict()
+	{
+		long threshold = dict.Values
+			.Select( e => e.lastUsed )
+			.OrderBy( t => t )
+			.ElementAt( dict.Count / 2 );
+
+		foreach( var kvp in dict.Where( kvp => kvp.Value.lastUsed < threshold ).ToList() )
+			dict.Remove( kvp.Key );
+	}
+
+	/// <summary>Append tokens of the segment to the list, encoding the segment only when it's not in the cache</summary>
+	public void encode( List<int> tokens, iTokenizer tokenizer, string segment )
+	{
+		if( !ReferenceEquals( tokenizer, this.tokenizer ) )
+		{
+			// Different model was loaded, the cached tokens are no longer valid
+			dict.Clear();
+			this.tokenizer = tokenizer;
+		}
+
+		timestamp++;
+		if( dict.TryGetValue( segment, out Entry? e ) )
+		{
+			e.lastUsed = timestamp;
+			tokens.AddRange( e.tokens );
+			return;
+		}
+
+		buffer.Clear();
+		tokenizer.encode( buffer, segment );
+		int[] arr = buffer.ToArray();
+		tokens.AddRange( arr );
+
+		dict.Add( segment, new Entry( arr, timestamp ) );
+		if( dict.Count > capacity )
+			evict();
+	}
+}
\ No newline at end of file
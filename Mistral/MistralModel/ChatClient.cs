@@ -1,12 +1,15 @@
 ﻿namespace Mistral;
+using System.Text;
 
 /// <summary>Client for an interactive chat session</summary>
 public abstract class ChatClient
 {
-	/// <summary>Test whether the string has a stop marker.<br/>
+	/// <summary>Test whether the text has a stop marker.<br/>
 	/// If it has, return chat response.<br/>
 	/// Otherwise, return null and the model will generate and then decode moar tokens</summary>
-	public virtual string? tryMakeResponse( string text ) => null;
+	/// <param name="text">Complete text decoded so far</param>
+	/// <param name="newText">Offset of the characters decoded from the last token; the characters before were tested by the previous calls</param>
+	public virtual string? tryMakeResponse( StringBuilder text, int newText ) => null;
 
 	/// <summary>Maximum count of response tokens to generate</summary>
 	public virtual int maxResponseTokens() => 512;
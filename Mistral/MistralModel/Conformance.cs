@@ -0,0 +1,164 @@
+﻿namespace Mistral;
+using Cgml;
+using Mistral.Model;
+
+/// <summary>Result of <see cref="Conformance.compare" /></summary>
+public sealed class ConformanceReport
+{
+	/// <summary>Difference of a single named intermediate tensor</summary>
+	public readonly struct Entry
+	{
+		/// <summary>Index of the layer, -1 for the tensors outside of the layers</summary>
+		public readonly int layer;
+		/// <summary>Name of the tensor, like <c>03-xq</c></summary>
+		public readonly string name;
+		/// <summary>Shape of the tensor</summary>
+		public readonly string shape;
+		/// <summary>Difference between the two models, null if the tensors couldn't be compared</summary>
+		public readonly TensorsDiff? diff;
+
+		internal Entry( int layer, string name, string shape, TensorsDiff? diff )
+		{
+			this.layer = layer;
+			this.name = name;
+			this.shape = shape;
+			this.diff = diff;
+		}
+	}
+
+	/// <summary>All compared tensors, in the order of the computations</summary>
+	public readonly Entry[] entries;
+
+	/// <summary>Count of tokens in the prompt</summary>
+	public readonly int tokens;
+
+	/// <summary>Fraction of prompt positions where both models predict the same next token</summary>
+	public readonly double top1Agreement;
+
+	internal ConformanceReport( Entry[] entries, int tokens, double top1Agreement )
+	{
+		this.entries = entries;
+		this.tokens = tokens;
+		this.top1Agreement = top1Agreement;
+	}
+
+	/// <summary>Maximum absolute difference across all tensors</summary>
+	public float maxAbsDiff => entries
+		.Where( e => e.diff.HasValue )
+		.Select( e => e.diff!.Value.maxAbsDiff )
+		.DefaultIfEmpty( 0 )
+		.Max();
+
+	static string formatLine( string what, IEnumerable<Entry> group )
+	{
+		Entry[] arr = group.Where( e => e.diff.HasValue ).ToArray();
+		if( arr.Length == 0 )
+			return $"{what}\tno comparable tensors";
+		Entry worst = arr.MaxBy( e => e.diff!.Value.maxAbsDiff );
+		float rms = arr.Max( e => e.diff!.Value.rms );
+		return $"{what}\tmaxAbsDiff {worst.diff!.Value.maxAbsDiff} in {worst.name}, max RMS {rms}";
+	}
+
+	/// <summary>Per-layer summary of the errors, one line per layer</summary>
+	public IEnumerable<string> formatted()
+	{
+		yield return $"Prompt {tokens} tokens, top-1 agreement {top1Agreement * 100:0.##}%";
+		foreach( var g in entries.GroupBy( e => e.layer ).OrderBy( g => g.Key ) )
+		{
+			if( g.Key < 0 )
+			{
+				foreach( Entry e in g )
+					yield return formatLine( e.name, new Entry[ 1 ] { e } );
+			}
+			else
+				yield return formatLine( $"Layer {g.Key}", g );
+		}
+	}
+}
+
+/// <summary>Runs the same model on two backends, and compares the intermediate tensors</summary>
+/// <remarks>The two models must have the same architecture and tokenizer.<br/>
+/// Examples: the same CGML file loaded on a GPU and on the "Microsoft Basic Render Driver" software adapter, or FP16 and BCML1 versions of the same weights.</remarks>
+public static class Conformance
+{
+	/// <summary>Index of the largest element in every row of the logits</summary>
+	static int[] argmaxRows( in TensorData logits )
+	{
+		if( logits.desc.dataType != eDataType.FP16 )
+			throw new NotImplementedException();
+		ushort[] data = (ushort[])logits.data;
+		TensorShape shape = logits.desc.shape;
+		int width = shape.size.x;
+		int[] res = new int[ shape.size.y ];
+		for( int y = 0; y < res.Length; y++ )
+		{
+			ReadOnlySpan<ushort> row = data.AsSpan( y * shape.stride.y, width );
+			int idx = 0;
+			float max = float.NegativeInfinity;
+			for( int x = 0; x < width; x++ )
+			{
+				float f = (float)BitConverter.UInt16BitsToHalf( row[ x ] );
+				if( f > max )
+				{
+					max = f;
+					idx = x;
+				}
+			}
+			res[ y ] = idx;
+		}
+		return res;
+	}
+
+	/// <summary>Run pre-fill of a synthetic prompt on both models, and compare all named intermediate tensors</summary>
+	/// <remarks>The method resets the state of both models</remarks>
+	public static ConformanceReport compare( iModel reference, iModel test, int promptLength = 64 )
+	{
+		Model.Model a = (Model.Model)reference;
+		Model.Model b = (Model.Model)test;
+		int[] tokens = a.benchmarkPrompt( promptLength );
+
+		List<TensorCapture.Entry> ca = a.captureIntermediates( tokens ).tensors;
+		List<TensorCapture.Entry> cb = b.captureIntermediates( tokens ).tensors;
+		if( ca.Count != cb.Count )
+			throw new ArgumentException( "The models have different architecture" );
+
+		var entries = new ConformanceReport.Entry[ ca.Count ];
+		double top1 = 0;
+		for( int i = 0; i < ca.Count; i++ )
+		{
+			TensorCapture.Entry ea = ca[ i ];
+			TensorCapture.Entry eb = cb[ i ];
+			if( ea.layer != eb.layer || ea.name != eb.name )
+				throw new ArgumentException( "The models have different architecture" );
+
+			TensorsDiff? diff = null;
+			try
+			{
+				diff = ea.data.diff( eb.data );
+			}
+			catch( Exception ex )
+			{
+				Logger.Warning( $"Unable to compare {ea.name} of layer {ea.layer}: {ex.Message}" );
+			}
+			entries[ i ] = new ConformanceReport.Entry( ea.layer, ea.name, ea.data.desc.shape.description(), diff );
+
+			if( ea.name == "16-logits" )
+			{
+				int[] ta = argmaxRows( ea.data );
+				int[] tb = argmaxRows( eb.data );
+				top1 = (double)ta.Zip( tb ).Count( p => p.First == p.Second ) / ta.Length;
+			}
+		}
+		return new ConformanceReport( entries, tokens.Length, top1 );
+	}
+
+	/// <summary>Verify the replays of recorded command lists produce the same results as direct calls</summary>
+	/// <remarks>The method records a few operations of the first layer, patches constants and dispatch sizes of the list, replays it, and repeats the same computations directly.<br/>
+	/// The method resets the state of the model.</remarks>
+	/// <returns>Maximum absolute difference, zero when the replay is equivalent</returns>
+	public static float checkReplay( iModel model, int promptLength = 64 )
+	{
+		Model.Model m = (Model.Model)model;
+		return m.checkReplay( m.benchmarkPrompt( promptLength ) );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+﻿namespace Mistral;
+
+/// <summary>Timings of a single generation, measured by <see cref="iModel.benchmark" /></summary>
+public sealed class GenerationTimings
+{
+	/// <summary>Count of tokens in the prompt</summary>
+	public readonly int promptTokens;
+
+	/// <summary>Time from the start of the pre-fill until the first generated token is in system memory</summary>
+	public readonly TimeSpan timeToFirstToken;
+
+	/// <summary>Latency of every subsequent generated token</summary>
+	public readonly TimeSpan[] tokenLatencies;
+
+	internal GenerationTimings( int promptTokens, TimeSpan timeToFirstToken, TimeSpan[] tokenLatencies )
+	{
+		this.promptTokens = promptTokens;
+		this.timeToFirstToken = timeToFirstToken;
+		this.tokenLatencies = tokenLatencies;
+	}
+
+	/// <summary>Total time spent generating tokens after the first one</summary>
+	public TimeSpan decodeTime => TimeSpan.FromTicks( tokenLatencies.Sum( t => t.Ticks ) );
+
+	/// <summary>Pre-fill throughput, the first token is included</summary>
+	public double prefillTokensPerSecond => promptTokens / timeToFirstToken.TotalSeconds;
+
+	/// <summary>Decode throughput, or null when only the first token was generated</summary>
+	public double? decodeTokensPerSecond
+	{
+		get
+		{
+			double seconds = decodeTime.TotalSeconds;
+			if( tokenLatencies.Length == 0 || seconds <= 0 )
+				return null;
+			return tokenLatencies.Length / seconds;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+﻿namespace Mistral;
+
+/// <summary>Measured performance of a compute shader, within a single operation of the model</summary>
+/// <seealso cref="iModel.benchmarkKernels" />
+public sealed class KernelTimings
+{
+	/// <summary>Name of the operation, like "wq" or "attention"</summary>
+	public readonly string operation;
+
+	/// <summary>Count of tokens in the input</summary>
+	public readonly int length;
+
+	/// <summary>Name of the compute shader</summary>
+	public readonly string shader;
+
+	/// <summary>Count of the measured calls</summary>
+	/// <remarks>Large matrix products on slow GPUs are split into batches of dispatches, every batch is a separate measure</remarks>
+	public readonly long calls;
+
+	/// <summary>Average GPU time of a single measured call, in nanoseconds</summary>
+	public readonly double nanoseconds;
+
+	/// <summary>50%, 90% and 99% percentiles of the measured times</summary>
+	public readonly TimeSpan[] percentiles;
+
+	/// <summary>Memory traffic and arithmetic of a single measured call, declared from the tensor shapes</summary>
+	public readonly double bytes, flops;
+
+	internal KernelTimings( string operation, int length, string shader, long calls, double nanoseconds, TimeSpan[] percentiles, double bytes, double flops )
+	{
+		this.operation = operation;
+		this.length = length;
+		this.shader = shader;
+		this.calls = calls;
+		this.nanoseconds = nanoseconds;
+		this.percentiles = percentiles;
+		this.bytes = bytes;
+		this.flops = flops;
+	}
+
+	/// <summary>Achieved memory bandwidth; bytes per nanosecond is the same as GB/s</summary>
+	public double gigabytesPerSecond => bytes / nanoseconds;
+
+	/// <summary>Achieved arithmetic throughput</summary>
+	public double gigaflops => flops / nanoseconds;
+
+	/// <summary>A string for debugger</summary>
+	public override string ToString() =>
+		$"{operation} [{length}] {shader}: {nanoseconds:0} ns, {gigabytesPerSecond:0.#} GB/s, {gigaflops:0.#} GFLOP/s";
+}
\ No newline at end of file
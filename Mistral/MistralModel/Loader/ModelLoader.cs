@@ -4,7 +4,7 @@ using System.Reflection;
 
 /// <summary>Public functions to load and save Mistral models</summary>
 /// <remarks>This library implements custom proprietary <c>*.cgml</c> format for these models.<br/>
-/// It can also import the original PyTorch format.</remarks>
+/// It can also import the original PyTorch format, and GGUF files of llama.cpp.</remarks>
 public static partial class ModelLoader
 {
 	/// <summary>Enumerate graphics adapters on this computer, and return their names.</summary>
@@ -40,10 +40,13 @@ public static partial class ModelLoader
 	}
 
 	/// <summary>Load model in CGML format</summary>
+	/// <remarks>Files with <c>*.gguf</c> extension are imported with <see cref="importGguf" /> method instead</remarks>
 	public static iModel load( string path, sDeviceParams deviceParams, Action<double>? pfnProgress = null )
 	{
 		if( !File.Exists( path ) )
 			throw new FileNotFoundException();
+		if( path.EndsWith( Torch.Gguf.extension, StringComparison.OrdinalIgnoreCase ) )
+			return importGguf( path, deviceParams );
 
 		Func<Device, iModel> pfn = delegate ( Device dev )
 		{
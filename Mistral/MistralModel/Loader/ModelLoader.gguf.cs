@@ -0,0 +1,149 @@
+﻿namespace Mistral;
+using Cgml;
+using Mistral.Model;
+using Torch;
+
+public static partial class ModelLoader
+{
+	static object ggufValue( Gguf gguf, string key ) =>
+		gguf.metadata.TryGetValue( key, out object? v ) ? v : throw new ArgumentException( $"GGUF metadata value \"{key}\" is missing" );
+
+	static int ggufInt( Gguf gguf, string key ) =>
+		Convert.ToInt32( ggufValue( gguf, key ) );
+
+	static float ggufFloat( Gguf gguf, string key, float defaultValue )
+	{
+		if( gguf.metadata.TryGetValue( key, out object? v ) )
+			return Convert.ToSingle( v );
+		return defaultValue;
+	}
+
+	/// <summary>Convert GGUF metadata into the legacy <c>params.json</c> class</summary>
+	static ParamsJson ggufParams( Gguf gguf )
+	{
+		string arch = (string)ggufValue( gguf, "general.architecture" );
+		if( arch != "llama" )
+			throw new NotSupportedException( $"GGUF architecture \"{arch}\" is not supported" );
+
+		ParamsJson res = new ParamsJson
+		{
+			dim = ggufInt( gguf, "llama.embedding_length" ),
+			n_layers = ggufInt( gguf, "llama.block_count" ),
+			hidden_dim = ggufInt( gguf, "llama.feed_forward_length" ),
+			n_heads = ggufInt( gguf, "llama.attention.head_count" ),
+			n_kv_heads = ggufInt( gguf, "llama.attention.head_count_kv" ),
+			norm_eps = ggufFloat( gguf, "llama.attention.layer_norm_rms_epsilon", 1e-5f ),
+			vocab_size = ( (object[])ggufValue( gguf, "tokenizer.ggml.tokens" ) ).Length,
+			ropeTheta = ggufFloat( gguf, "llama.rope.freq_base", 10000.0f ),
+			// The loader restores the order of Q and K rows changed by llama.cpp, the model then uses the rotary embedding of the Hugging Face version
+			modelVersion = eModelVersion.Instruct02,
+		};
+		res.head_dim = res.dim / res.n_heads;
+		// GGUF doesn't keep the sliding window; same default as config.json
+		res.sliding_window = 4096;
+		return res;
+	}
+
+	/// <summary>Make <c>tokenizer.model</c> from the vocabulary in GGUF metadata</summary>
+	static byte[] ggufTokenizer( Gguf gguf )
+	{
+		string model = (string)ggufValue( gguf, "tokenizer.ggml.model" );
+		if( model != "llama" )
+			throw new NotSupportedException( $"GGUF tokenizer \"{model}\" is not supported, only SentencePiece is" );
+
+		string[] pieces = ( (object[])ggufValue( gguf, "tokenizer.ggml.tokens" ) ).Cast<string>().ToArray();
+		float[] scores = ( (object[])ggufValue( gguf, "tokenizer.ggml.scores" ) ).Select( v => Convert.ToSingle( v ) ).ToArray();
+		int[] types = ( (object[])ggufValue( gguf, "tokenizer.ggml.token_type" ) ).Select( v => Convert.ToInt32( v ) ).ToArray();
+		int unk = gguf.metadata.ContainsKey( "tokenizer.ggml.unknown_token_id" ) ? ggufInt( gguf, "tokenizer.ggml.unknown_token_id" ) : 0;
+		int bos = ggufInt( gguf, "tokenizer.ggml.bos_token_id" );
+		int eos = ggufInt( gguf, "tokenizer.ggml.eos_token_id" );
+		return SentencePieceWriter.write( pieces, scores, types, unk, bos, eos );
+	}
+
+	/// <summary>Produce another dictionary with tensor key names translated from GGUF into the original version 0.1</summary>
+	static Dictionary<string, iTensor> renameTensorsGguf( IReadOnlyDictionary<string, iTensor> dict )
+	{
+		Dictionary<string, iTensor> result = new Dictionary<string, iTensor>( dict.Count );
+
+		Dictionary<string, string> globals = new Dictionary<string, string>( 3 )
+		{
+			{ "token_embd.weight", "tok_embeddings.weight" },
+			{ "output.weight", "output.weight" },
+			{ "output_norm.weight", "norm.weight" },
+		};
+
+		Dictionary<string, string> layer = new Dictionary<string, string>( 9 )
+		{
+			{ "attn_norm.weight", "attention_norm.weight" },
+			{ "ffn_norm.weight", "ffn_norm.weight" },
+
+			{ "attn_q.weight", "attention.wq.weight" },
+			{ "attn_k.weight", "attention.wk.weight" },
+			{ "attn_v.weight", "attention.wv.weight" },
+			{ "attn_output.weight", "attention.wo.weight" },
+
+			{ "ffn_gate.weight", "feed_forward.w1.weight" },
+			{ "ffn_up.weight", "feed_forward.w3.weight" },
+			{ "ffn_down.weight", "feed_forward.w2.weight" },
+		};
+
+		foreach( var kvp in dict )
+		{
+			string key = kvp.Key;
+			string? renamed;
+			if( key.StartsWith( "blk." ) )
+			{
+				string[] fields = key.Split( '.', 3 );
+				if( !layer.TryGetValue( fields[ 2 ], out renamed ) )
+					throw new ArgumentException( $"Unexpected GGUF tensor \"{key}\"" );
+				renamed = $"layers.{fields[ 1 ]}.{renamed}";
+			}
+			else if( !globals.TryGetValue( key, out renamed ) )
+				throw new ArgumentException( $"Unexpected GGUF tensor \"{key}\"" );
+
+			result.Add( renamed, kvp.Value );
+		}
+
+		return result;
+	}
+
+	/// <summary>Import model from a GGUF file produced by llama.cpp</summary>
+	/// <remarks>The vocabulary is in the metadata of the file, no other files are needed.<br/>
+	/// Q4_0 and Q4_1 tensors are repacked into <see cref="eTensorLayout.BCML1" /> without quantizing them again.</remarks>
+	public static iModel importGguf( string path, sDeviceParams deviceParams, eTensorLayout compression = eTensorLayout.BCML1 )
+	{
+		if( !File.Exists( path ) )
+			throw new FileNotFoundException();
+
+		Gguf gguf = Gguf.readHeader( path );
+		ParamsJson json = ggufParams( gguf );
+		byte[] vocab = ggufTokenizer( gguf );
+
+		iModel impl( Device dev )
+		{
+			Tokenizer tokenizer;
+			using( var stm = new MemoryStream( vocab, false ) )
+				tokenizer = new Tokenizer( dev, stm, vocab.Length );
+
+			try
+			{
+				LoadTraits traits = new LoadTraits( compression, json.n_heads, json.n_kv_heads );
+				using iWeightsLoader loader = TensorLoader.createLoader( dev.device, traits );
+				loader.loadGguf( path );
+
+				Dictionary<string, iTensor> renamedTensors = renameTensorsGguf( loader.tensors );
+				iModel result = new Model.Model( dev, json, tokenizer, renamedTensors );
+
+				// Clear the dictionary stored in the loader, otherwise they all gonna be disposed
+				loader.tensors.Clear();
+				return result;
+			}
+			catch
+			{
+				tokenizer.Dispose();
+				throw;
+			}
+		}
+		return loadImpl( impl, deviceParams );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+﻿namespace Mistral;
+using Cgml;
+using Mistral.Model;
+using System.Text.Json;
+using Torch;
+
+public static partial class ModelLoader
+{
+	/// <summary>Create a randomly initialized model in VRAM</summary>
+	public static iModel createSynthetic( SyntheticModel sm, sDeviceParams deviceParams, eTensorLayout compression = eTensorLayout.Dense )
+	{
+		sm.validate();
+
+		iModel impl( Device dev )
+		{
+			byte[] vocab = SentencePieceWriter.write( sm.vocabSize );
+			Tokenizer tokenizer;
+			using( var stm = new MemoryStream( vocab, false ) )
+				tokenizer = new Tokenizer( dev, stm, vocab.Length );
+
+			Dictionary<string, iTensor> tensors = new Dictionary<string, iTensor>();
+			try
+			{
+				LoadTraits traits = new LoadTraits( compression );
+				int index = 0;
+				foreach( var ti in sm.tensors() )
+				{
+					sTensorDesc desc = new sTensorDesc()
+					{
+						shape = TensorShape.rowMajor( ti.width, ti.height ),
+						dataType = eDataType.FP16,
+						usage = eBufferUse.Immutable,
+						layout = traits.tensorVramLayout( ti.key ),
+					};
+					byte[] data = sm.makeWeights( index++, ti );
+					using var stream = new MemoryStream( data, false );
+					tensors.Add( ti.key, dev.device.loadImmutableTensor( ref desc, stream, data.Length ) );
+				}
+				dev.device.waitForWeightsCompressor();
+
+				Logger.Debug( "Created synthetic model, {0} tensors", tensors.Count );
+				return new Model.Model( dev, sm.makeParams(), tokenizer, tensors );
+			}
+			catch
+			{
+				foreach( iTensor t in tensors.Values )
+					t.Dispose();
+				tokenizer.Dispose();
+				throw;
+			}
+		}
+		return loadImpl( impl, deviceParams );
+	}
+
+	/// <summary>Create a randomly initialized model, and save in CGML format</summary>
+	public static void writeSyntheticCgml( SyntheticModel sm, string cgml, sDeviceParams deviceParams, eTensorLayout compression = eTensorLayout.Dense, Action<double>? pfnProgress = null )
+	{
+		using iModel model = createSynthetic( sm, deviceParams, compression );
+		( (Model.Model)model ).save( cgml, SentencePieceWriter.write( sm.vocabSize ), pfnProgress );
+	}
+
+	static void writeConfigJson( SyntheticModel sm, string path )
+	{
+		using var stream = File.Create( path );
+		using var writer = new Utf8JsonWriter( stream, new JsonWriterOptions { Indented = true } );
+		ParamsJson p = sm.makeParams();
+		writer.WriteStartObject();
+		writer.WriteStartArray( "architectures" );
+		writer.WriteStringValue( "MistralForCausalLM" );
+		writer.WriteEndArray();
+		writer.WriteNumber( "bos_token_id", 1 );
+		writer.WriteNumber( "eos_token_id", 2 );
+		writer.WriteString( "hidden_act", "silu" );
+		writer.WriteNumber( "hidden_size", p.dim );
+		writer.WriteNumber( "intermediate_size", p.hidden_dim );
+		writer.WriteNumber( "max_position_embeddings", p.sliding_window );
+		writer.WriteString( "model_type", "mistral" );
+		writer.WriteNumber( "num_attention_heads", p.n_heads );
+		writer.WriteNumber( "num_hidden_layers", p.n_layers );
+		writer.WriteNumber( "num_key_value_heads", p.n_kv_heads );
+		writer.WriteNumber( "rms_norm_eps", p.norm_eps );
+		writer.WriteNumber( "rope_theta", p.ropeTheta );
+		writer.WriteNumber( "sliding_window", p.sliding_window );
+		writer.WriteBoolean( "tie_word_embeddings", false );
+		writer.WriteString( "torch_dtype", "bfloat16" );
+		writer.WriteNumber( "vocab_size", p.vocab_size );
+		writer.WriteEndObject();
+	}
+
+	/// <summary>Write all tensors into a single <c>*.safetensors</c> file, return total size of the payload</summary>
+	static long writeSafeTensors( SyntheticModel sm, string path, Action<double>? pfnProgress )
+	{
+		var list = sm.tensors().ToList();
+
+		// The header is a JSON with shapes and offsets of all tensors
+		byte[] header;
+		long payload = 0;
+		using( var ms = new MemoryStream() )
+		{
+			using( var writer = new Utf8JsonWriter( ms ) )
+			{
+				writer.WriteStartObject();
+				foreach( var ti in list )
+				{
+					long cb = (long)ti.width * ti.height * 2;
+					writer.WriteStartObject( ti.hfKey );
+					writer.WriteString( "dtype", "BF16" );
+					writer.WriteStartArray( "shape" );
+					if( ti.height > 1 )
+						writer.WriteNumberValue( ti.height );
+					writer.WriteNumberValue( ti.width );
+					writer.WriteEndArray();
+					writer.WriteStartArray( "data_offsets" );
+					writer.WriteNumberValue( payload );
+					writer.WriteNumberValue( payload + cb );
+					writer.WriteEndArray();
+					writer.WriteEndObject();
+					payload += cb;
+				}
+				writer.WriteEndObject();
+			}
+			// Pad the header with spaces, so the payload is aligned by 8 bytes
+			while( 0 != ms.Length % 8 )
+				ms.WriteByte( (byte)' ' );
+			header = ms.ToArray();
+		}
+
+		using var stream = File.Create( path );
+		stream.Write( BitConverter.GetBytes( (long)header.Length ) );
+		stream.Write( header );
+		for( int i = 0; i < list.Count; i++ )
+		{
+			stream.Write( sm.makeWeights( i, list[ i ], true ) );
+			pfnProgress?.Invoke( (double)( i + 1 ) / list.Count );
+		}
+		return payload;
+	}
+
+	/// <summary>Create a randomly initialized model, and save it in Hugging Face format of Mistral-7B-Instruct-v0.2</summary>
+	/// <remarks>The method doesn't need a GPU. It creates <c>config.json</c>, <c>tokenizer.model</c>,
+	/// <c>model.safetensors</c> and the index in the directory. Same as the published model, the weights are BF16.<br/>
+	/// To load the model, pass the directory to <see cref="importTorch" />.</remarks>
+	public static void writeSyntheticTorch( SyntheticModel sm, string directory, Action<double>? pfnProgress = null )
+	{
+		sm.validate();
+		Directory.CreateDirectory( directory );
+
+		File.WriteAllBytes( Path.Combine( directory, "tokenizer.model" ), SentencePieceWriter.write( sm.vocabSize ) );
+		writeConfigJson( sm, Path.Combine( directory, "config.json" ) );
+
+		const string weights = "model" + SafeTensors.extension;
+		long totalSize = writeSafeTensors( sm, Path.Combine( directory, weights ), pfnProgress );
+
+		using var stream = File.Create( Path.Combine( directory, SafeTensors.indexFileName ) );
+		using var writer = new Utf8JsonWriter( stream, new JsonWriterOptions { Indented = true } );
+		writer.WriteStartObject();
+		writer.WriteStartObject( "metadata" );
+		writer.WriteNumber( "total_size", totalSize );
+		writer.WriteEndObject();
+		writer.WriteStartObject( "weight_map" );
+		foreach( var ti in sm.tensors() )
+			writer.WriteString( ti.hfKey, weights );
+		writer.WriteEndObject();
+		writer.WriteEndObject();
+
+		Logger.Info( "Saved synthetic model: {0}", directory );
+	}
+}
\ No newline at end of file
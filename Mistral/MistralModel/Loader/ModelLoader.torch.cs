@@ -11,10 +11,14 @@ public static partial class ModelLoader
 	sealed class LoadTraits: Torch.LoadTraits
 	{
 		readonly eTensorLayout blockCompression;
+		// Count of query and key/value heads, only used when loading GGUF files
+		readonly int heads, kvHeads;
 
-		public LoadTraits( eTensorLayout codec = eTensorLayout.Dense )
+		public LoadTraits( eTensorLayout codec = eTensorLayout.Dense, int heads = 0, int kvHeads = 0 )
 		{
 			blockCompression = codec;
+			this.heads = heads;
+			this.kvHeads = kvHeads;
 		}
 
 		readonly string[] compressedTensors = new string[]
@@ -36,6 +40,15 @@ public static partial class ModelLoader
 			".self_attn.k_proj.weight",
 			".self_attn.v_proj.weight",
 			".self_attn.o_proj.weight",
+
+			// GGUF names
+			".ffn_gate.weight",
+			".ffn_down.weight",
+			".ffn_up.weight",
+			".attn_k.weight",
+			".attn_output.weight",
+			".attn_q.weight",
+			".attn_v.weight",
 		};
 
 		public override eTensorLayout tensorVramLayout( string key )
@@ -46,8 +59,28 @@ public static partial class ModelLoader
 			return eTensorLayout.Dense;
 		}
 
-		public override eLoadTransform tensorLoadTransform( eDataType storedType, string key ) =>
-			eLoadTransform.Fp16MakeIeee;
+#pragma warning disable CS0162 // Unreachable code detected, due to bfloat16 constant
+		public override eLoadTransform tensorLoadTransform( eDataType storedType, string key )
+		{
+			if( Context.bfloat16 )
+				return storedType == eDataType.FP32 ? eLoadTransform.Fp32DowncastBf16 : eLoadTransform.None;
+
+			// Weights of the normalization layers are tiny and sensitive to precision, keep them in FP32.
+			// The shaders read them through typed views, which convert FP32 as well as FP16.
+			if( key.EndsWith( "norm.weight" ) )
+				return eLoadTransform.Fp16Upcast;
+			return storedType == eDataType.FP32 ? eLoadTransform.Fp32DowncastIeee : eLoadTransform.Fp16MakeIeee;
+		}
+#pragma warning restore CS0162
+
+		public override int ggufPermutedHeads( string key )
+		{
+			if( key.EndsWith( ".attn_q.weight" ) )
+				return heads;
+			if( key.EndsWith( ".attn_k.weight" ) )
+				return kvHeads;
+			return 0;
+		}
 	}
 
 	static void dbgSummarizeTensors( IReadOnlyDictionary<string, iTensor> dict )
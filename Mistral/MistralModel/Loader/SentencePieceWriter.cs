@@ -0,0 +1,160 @@
+﻿namespace Mistral;
+using System.Text;
+
+/// <summary>Produces <c>tokenizer.model</c> files for synthetic models, in the protocol buffers format of the SentencePiece library</summary>
+/// <remarks>The layout of the vocabulary matches Mistral: <c>&lt;unk&gt;</c>, <c>&lt;s&gt;</c> and <c>&lt;/s&gt;</c>, then 256 byte fallback pieces, then regular BPE pieces.<br/>
+/// Field numbers are defined in <c>sentencepiece_model.proto</c>.</remarks>
+static class SentencePieceWriter
+{
+	// Values of ModelProto.SentencePiece.Type enum
+	const int typeNormal = 1;
+	const int typeUnknown = 2;
+	const int typeControl = 3;
+	const int typeByte = 6;
+
+	const int modelTypeBpe = 2;
+
+	/// <summary>Count of special pieces: 3 control tokens and 256 bytes</summary>
+	public const int specialPieces = 3 + 256;
+
+	/// <summary>Characters of the regular pieces; "▁" is the SentencePiece escape of the space character</summary>
+	const string alphabet = "▁abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.,!?'-:;()";
+
+	/// <summary>Minimal writer of protocol buffers messages</summary>
+	sealed class ProtoWriter
+	{
+		public readonly MemoryStream stream = new MemoryStream();
+
+		void varint( ulong v )
+		{
+			while( v >= 0x80 )
+			{
+				stream.WriteByte( unchecked((byte)( v | 0x80 )) );
+				v >>= 7;
+			}
+			stream.WriteByte( (byte)v );
+		}
+
+		void tag( int field, int wireType ) =>
+			varint( (ulong)( ( field << 3 ) | wireType ) );
+
+		public void integer( int field, long v )
+		{
+			tag( field, 0 );
+			// Negative numbers take 10 bytes, protobuf encodes them as 64-bit two's complement
+			varint( unchecked((ulong)v) );
+		}
+
+		public void boolean( int field, bool v ) =>
+			integer( field, v ? 1 : 0 );
+
+		public void fp32( int field, float v )
+		{
+			tag( field, 5 );
+			Span<byte> bytes = stackalloc byte[ 4 ];
+			BitConverter.TryWriteBytes( bytes, v );
+			stream.Write( bytes );
+		}
+
+		public void bytes( int field, ReadOnlySpan<byte> v )
+		{
+			tag( field, 2 );
+			varint( (ulong)v.Length );
+			stream.Write( v );
+		}
+
+		public void str( int field, string v ) =>
+			bytes( field, Encoding.UTF8.GetBytes( v ) );
+
+		public void message( int field, ProtoWriter v ) =>
+			bytes( field, v.stream.ToArray() );
+	}
+
+	static ProtoWriter piece( string text, float score, int type )
+	{
+		ProtoWriter pw = new ProtoWriter();
+		pw.str( 1, text );
+		pw.fp32( 2, score );
+		pw.integer( 3, type );
+		return pw;
+	}
+
+	/// <summary>Enumerate regular pieces, shortest first, so all prefixes of every piece are in the vocabulary</summary>
+	static IEnumerable<string> regularPieces()
+	{
+		List<string> prev = new List<string>() { "" };
+		while( true )
+		{
+			List<string> next = new List<string>( prev.Count * alphabet.Length );
+			foreach( string p in prev )
+				foreach( char c in alphabet )
+				{
+					string s = p + c;
+					next.Add( s );
+					yield return s;
+				}
+			prev = next;
+		}
+	}
+
+	/// <summary>Make a vocabulary of the specified size</summary>
+	public static byte[] write( int vocabSize )
+	{
+		if( vocabSize <= specialPieces )
+			throw new ArgumentOutOfRangeException( nameof( vocabSize ), $"The vocabulary needs more than {specialPieces} tokens" );
+
+		ProtoWriter model = new ProtoWriter();
+		model.message( 1, piece( "<unk>", 0, typeUnknown ) );
+		model.message( 1, piece( "<s>", 0, typeControl ) );
+		model.message( 1, piece( "</s>", 0, typeControl ) );
+		for( int i = 0; i < 256; i++ )
+			model.message( 1, piece( $"<0x{i:X2}>", 0, typeByte ) );
+
+		int score = 0;
+		foreach( string s in regularPieces().Take( vocabSize - specialPieces ) )
+			model.message( 1, piece( s, --score, typeNormal ) );
+
+		writeSpecs( model, vocabSize, true, 0, 1, 2 );
+		return model.stream.ToArray();
+	}
+
+	/// <summary>Make a vocabulary from the supplied pieces</summary>
+	/// <remarks>GGUF files store the vocabulary of SentencePiece models in <c>tokenizer.ggml.*</c> metadata values,
+	/// the values of <c>tokenizer.ggml.token_type</c> are the same as SentencePiece piece types.</remarks>
+	public static byte[] write( IReadOnlyList<string> pieces, IReadOnlyList<float> scores, IReadOnlyList<int> types, int unk, int bos, int eos )
+	{
+		if( pieces.Count != scores.Count || pieces.Count != types.Count )
+			throw new ArgumentException( "Count of pieces, scores and types must be equal" );
+
+		ProtoWriter model = new ProtoWriter();
+		bool byteFallback = false;
+		for( int i = 0; i < pieces.Count; i++ )
+		{
+			model.message( 1, piece( pieces[ i ], scores[ i ], types[ i ] ) );
+			byteFallback |= types[ i ] == typeByte;
+		}
+
+		writeSpecs( model, pieces.Count, byteFallback, unk, bos, eos );
+		return model.stream.ToArray();
+	}
+
+	static void writeSpecs( ProtoWriter model, int vocabSize, bool byteFallback, int unk, int bos, int eos )
+	{
+		ProtoWriter trainer = new ProtoWriter();
+		trainer.integer( 3, modelTypeBpe );
+		trainer.integer( 4, vocabSize );
+		trainer.boolean( 35, byteFallback );
+		trainer.integer( 40, unk );
+		trainer.integer( 41, bos );
+		trainer.integer( 42, eos );
+		trainer.integer( 43, -1 );  // pad_id
+		model.message( 2, trainer );
+
+		ProtoWriter normalizer = new ProtoWriter();
+		normalizer.str( 1, "identity" );
+		normalizer.boolean( 3, true );  // add_dummy_prefix
+		normalizer.boolean( 4, false ); // remove_extra_whitespaces
+		normalizer.boolean( 5, true );  // escape_whitespaces
+		model.message( 3, normalizer );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+﻿namespace Mistral;
+using Cgml;
+using Mistral.Model;
+using System.Runtime.InteropServices;
+
+/// <summary>Hyper-parameters of a randomly initialized model with Mistral architecture</summary>
+/// <remarks>Synthetic models generate garbage text, but they run the same compute shaders as the real ones.<br/>
+/// Use them to test and benchmark loading, compression, inference and state backups without downloading the real weights.</remarks>
+public sealed record class SyntheticModel
+{
+	/// <summary>Length of the embedding vectors</summary>
+	/// <remarks>The head size <c>dim / heads</c> must be 128, the rotary embedding shader of the v0.2 model only supports that size</remarks>
+	public int dim { get; init; } = 512;
+	/// <summary>Count of transformer layers</summary>
+	public int layers { get; init; } = 2;
+	/// <summary>Count of attention heads</summary>
+	public int heads { get; init; } = 4;
+	/// <summary>Count of key/value heads, must be a divisor of <see cref="heads" /></summary>
+	public int kvHeads { get; init; } = 1;
+	/// <summary>Width of the hidden layer in the feed-forward network</summary>
+	public int hiddenDim { get; init; } = 1536;
+	/// <summary>Count of tokens in the vocabulary, including 259 special ones</summary>
+	public int vocabSize { get; init; } = 1024;
+	/// <summary>Size of the attention window, also length of the KV cache</summary>
+	public int slidingWindow { get; init; } = 512;
+	/// <summary>Seed of the random number generator, the weights are deterministic</summary>
+	public int seed { get; init; } = 0;
+
+	/// <summary>Same dimensions as the Mistral-7B model</summary>
+	public static SyntheticModel mistral7B => new SyntheticModel
+	{
+		dim = 4096,
+		layers = 32,
+		heads = 32,
+		kvHeads = 8,
+		hiddenDim = 14336,
+		vocabSize = 32000,
+		slidingWindow = 4096,
+	};
+
+	const float normEpsilon = 1e-5f;
+	const float ropeTheta = 1000000.0f;
+	/// <summary>Head size supported by <c>rotaryEmbedding2.hlsl</c> shader</summary>
+	const int requiredHeadDim = 128;
+
+	internal int headDim => dim / heads;
+
+	internal void validate()
+	{
+		if( dim <= 0 || layers <= 0 || heads <= 0 || kvHeads <= 0 || hiddenDim <= 0 || slidingWindow <= 0 )
+			throw new ArgumentOutOfRangeException( null, "Synthetic model dimensions must be positive" );
+		if( 0 != dim % heads || 0 != heads % kvHeads )
+			throw new ArgumentException( "dim must be a multiple of heads, and heads must be a multiple of kvHeads" );
+		if( headDim != requiredHeadDim )
+			throw new ArgumentException( $"The head size dim / heads must be {requiredHeadDim}, got {headDim}" );
+		// BCML1 compression needs complete blocks of 32 elements in every row of the weights
+		if( 0 != hiddenDim % 32 )
+			throw new ArgumentException( "hiddenDim must be a multiple of 32" );
+		if( vocabSize <= SentencePieceWriter.specialPieces )
+			throw new ArgumentOutOfRangeException( nameof( vocabSize ), $"The vocabulary needs more than {SentencePieceWriter.specialPieces} tokens" );
+	}
+
+	internal ParamsJson makeParams() => new ParamsJson
+	{
+		dim = dim,
+		n_layers = layers,
+		head_dim = headDim,
+		hidden_dim = hiddenDim,
+		n_heads = heads,
+		n_kv_heads = kvHeads,
+		norm_eps = normEpsilon,
+		sliding_window = slidingWindow,
+		vocab_size = vocabSize,
+		ropeTheta = ropeTheta,
+		modelVersion = eModelVersion.Instruct02,
+	};
+
+	/// <summary>A tensor of the synthetic model</summary>
+	/// <param name="key">Name in CGML and the original PyTorch model</param>
+	/// <param name="hfKey">Name in the version 0.2 of the model, published in Hugging Face format</param>
+	/// <param name="width">Row length, i.e. count of input features for the weight matrices</param>
+	/// <param name="height">Count of rows</param>
+	internal readonly record struct TensorInfo( string key, string hfKey, int width, int height );
+
+	/// <summary>Enumerate the tensors of the model</summary>
+	internal IEnumerable<TensorInfo> tensors()
+	{
+		int kvDim = headDim * kvHeads;
+		yield return new TensorInfo( "tok_embeddings.weight", "model.embed_tokens.weight", dim, vocabSize );
+		for( int i = 0; i < layers; i++ )
+		{
+			string l = $"layers.{i}.";
+			string hf = $"model.layers.{i}.";
+			yield return new TensorInfo( l + "attention.wq.weight", hf + "self_attn.q_proj.weight", dim, dim );
+			yield return new TensorInfo( l + "attention.wk.weight", hf + "self_attn.k_proj.weight", dim, kvDim );
+			yield return new TensorInfo( l + "attention.wv.weight", hf + "self_attn.v_proj.weight", dim, kvDim );
+			yield return new TensorInfo( l + "attention.wo.weight", hf + "self_attn.o_proj.weight", dim, dim );
+			yield return new TensorInfo( l + "feed_forward.w1.weight", hf + "mlp.gate_proj.weight", dim, hiddenDim );
+			yield return new TensorInfo( l + "feed_forward.w2.weight", hf + "mlp.down_proj.weight", hiddenDim, dim );
+			yield return new TensorInfo( l + "feed_forward.w3.weight", hf + "mlp.up_proj.weight", dim, hiddenDim );
+			yield return new TensorInfo( l + "attention_norm.weight", hf + "input_layernorm.weight", dim, 1 );
+			yield return new TensorInfo( l + "ffn_norm.weight", hf + "post_attention_layernorm.weight", dim, 1 );
+		}
+		yield return new TensorInfo( "norm.weight", "model.norm.weight", dim, 1 );
+		yield return new TensorInfo( "output.weight", "lm_head.weight", dim, vocabSize );
+	}
+
+	/// <summary>Elements are generated in blocks, every block uses an independent random generator</summary>
+	const int blockSize = 1 << 16;
+
+	static ulong splitMix64( ulong x )
+	{
+		unchecked
+		{
+			x += 0x9E3779B97F4A7C15ul;
+			x = ( x ^ ( x >> 30 ) ) * 0xBF58476D1CE4E5B9ul;
+			x = ( x ^ ( x >> 27 ) ) * 0x94D049BB133111EBul;
+			return x ^ ( x >> 31 );
+		}
+	}
+
+	/// <summary>Round FP32 number to BF16, to nearest even</summary>
+	static ushort makeBf16( float f )
+	{
+		uint bits = BitConverter.SingleToUInt32Bits( f );
+		bits += 0x7FFFu + ( ( bits >> 16 ) & 1 );
+		return (ushort)( bits >> 16 );
+	}
+
+	static ushort makeElement( float f, bool bf16 ) =>
+		bf16 ? makeBf16( f ) : BitConverter.HalfToUInt16Bits( (Half)f );
+
+	/// <summary>Produce FP16 or BF16 payload of the tensor</summary>
+	/// <remarks>Norm weights are 1.0, other tensors are uniformly distributed with standard deviation 1/sqrt(width).<br/>
+	/// The output only depends on the seed and the index of the tensor, the blocks are generated in parallel.</remarks>
+	internal byte[] makeWeights( int index, in TensorInfo ti, bool bf16 = false )
+	{
+		int length = checked(ti.width * ti.height);
+		byte[] result = new byte[ length * 2 ];
+		if( ti.height == 1 )
+		{
+			MemoryMarshal.Cast<byte, ushort>( result ).Fill( makeElement( 1.0f, bf16 ) );
+			return result;
+		}
+
+		// Uniform distribution in [ -a, +a ] interval has variance a² / 3
+		float amplitude = MathF.Sqrt( 3.0f / ti.width );
+		ulong tensorSeed = splitMix64( unchecked((ulong)seed << 32 | (uint)index) );
+		int blocks = ( length + blockSize - 1 ) / blockSize;
+		Parallel.For( 0, blocks, block =>
+		{
+			Span<ushort> span = MemoryMarshal.Cast<byte, ushort>( result.AsSpan() );
+			int begin = block * blockSize;
+			span = span.Slice( begin, Math.Min( blockSize, length - begin ) );
+
+			// xorshift64* generator
+			ulong state = splitMix64( tensorSeed ^ (ulong)block ) | 1;
+			for( int i = 0; i < span.Length; i++ )
+			{
+				state ^= state >> 12;
+				state ^= state << 25;
+				state ^= state >> 27;
+				ulong bits = unchecked(state * 0x2545F4914F6CDD1Dul);
+				// 24 random bits mapped into [ -1 .. +1 )
+				float f = (int)( bits >> 40 ) * ( 2.0f / ( 1 << 24 ) ) - 1.0f;
+				span[ i ] = makeElement( f * amplitude, bf16 );
+			}
+		} );
+		return result;
+	}
+}
\ No newline at end of file
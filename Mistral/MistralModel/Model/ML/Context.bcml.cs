@@ -70,4 +70,33 @@ partial struct Context
 		int groupsX = ( res.size.x + THREADS - 1 ) / THREADS;
 		context.dispatch( groupsX, a.size.y, a.size.z );
 	}
+
+	/// <summary>Fused gate and up projections of the feed-forward network, for BCML1 compressed matrices</summary>
+	[SkipLocalsInit]
+	void columnProductSwiGLUCompressed( Tensor res, Tensor a, iTensor w1, iTensor w3, in sTensorDesc bDesc )
+	{
+		Debug.Assert( bDesc.stride.x == 0 );
+		Debug.Assert( bDesc.layout == eTensorLayout.BCML1 );
+
+		Span<IntPtr> span = stackalloc IntPtr[ 4 ];
+		span[ 0 ] = ( (RuntimeClass)res.native ).nativePointer;
+		span[ 1 ] = ( (RuntimeClass)a.native ).nativePointer;
+		span[ 2 ] = ( (RuntimeClass)w1 ).nativePointer;
+		span[ 3 ] = ( (RuntimeClass)w3 ).nativePointer;
+		context.bindTensors( ref span.GetPinnableReference(), 1, 3 );
+
+		var cb = new RowMatProductCb
+		{
+			rowLength = a.size.x,
+			rowsCount = res.size.x,
+			arg0Strides = new uint2( a.stride.y, a.stride.z ),
+			resultStrides = new uint2( res.stride.y, res.stride.z ),
+			matrixStride = bDesc.stride.y,
+		};
+		context.bindShader( (ushort)eShader.rowMatSwiGLUBc1, ref cb );
+
+		const int THREADS = 256;
+		int groupsX = ( res.size.x + THREADS - 1 ) / THREADS;
+		context.dispatch( groupsX, a.size.y, a.size.z );
+	}
 }
\ No newline at end of file
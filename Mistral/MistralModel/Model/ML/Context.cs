@@ -8,7 +8,7 @@ using System.Runtime.InteropServices;
 [StructLayout( LayoutKind.Auto )]
 partial struct Context
 {
-	const bool bfloat16 = false;
+	internal const bool bfloat16 = false;
 	const eDataType defaultDataType = bfloat16 ? eDataType.BF16 : eDataType.FP16;
 
 	public readonly TemporaryTensors temp;
@@ -16,16 +16,21 @@ partial struct Context
 	readonly iDevice device;
 	public readonly Parameters parameters;
 	readonly bool isFastGpu;
+	readonly KernelWork work;
+	/// <summary>When not null, the named intermediate tensors are downloaded there</summary>
+	public readonly TensorCapture? capture;
 	public eModelVersion modelVersion => parameters.modelVersion;
 
 	/// <summary>Create the structure</summary>
-	public Context( in Device dev, TemporaryTensors temp, Parameters parameters, PerformanceParams perfParams )
+	public Context( in Device dev, TemporaryTensors temp, Parameters parameters, PerformanceParams perfParams, KernelWork work, TensorCapture? capture = null )
 	{
 		this.temp = temp;
 		context = dev.context;
 		device = dev.device;
 		this.parameters = parameters;
 		isFastGpu = perfParams.isFastGpu;
+		this.work = work;
+		this.capture = capture;
 
 #if DEBUG
 		if( null != pathPythonDumps && Directory.Exists( pathPythonDumps ) )
@@ -47,6 +52,43 @@ partial struct Context
 	Tensor fp16( ref Tensor? cache, int x, int y = 1, int z = 1, int w = 1 ) =>
 		fp16( ref cache, new Int128( x, y, z, w ) );
 
+	/// <summary>Declare memory traffic and arithmetic of the dispatch, for the roofline report</summary>
+	void addWork( eShader shader, long bytesRead, long bytesWritten, long flops = 0 ) =>
+		work.add( (ushort)shader, bytesRead, bytesWritten, flops );
+
+	static long tensorBytes( Tensor t ) =>
+		(long)t.shape.countElements() * t.dataType.elementSize();
+
+	static long weightBytes( in sTensorDesc desc )
+	{
+		long elts = desc.shape.countElements();
+		switch( desc.layout )
+		{
+			case eTensorLayout.Dense:
+				return elts * desc.dataType.elementSize();
+			case eTensorLayout.BCML1:
+				// 5 integers per block of 32 weights
+				return elts / 32 * 20;
+		}
+		throw new NotImplementedException();
+	}
+
+	/// <summary>Declare the work of [ x, y, z ] * [ x, r ] = [ r, y, z ] product, optionally with multiple matrices</summary>
+	void addProductWork( eShader shader, Tensor res, Tensor a, in sTensorDesc weights, int matrices = 1 )
+	{
+		long flops = 2L * a.size.x * res.shape.countElements() * matrices;
+		addWork( shader, tensorBytes( a ) + weightBytes( weights ) * matrices, tensorBytes( res ), flops );
+	}
+
+	/// <summary>Declare the work of a dispatch which computes <c>groups</c> of <c>totalGroups</c> slices of the [ x, y, z ] * [ x, r ] = [ r, y, z ] product</summary>
+	/// <remarks>Every such dispatch reads complete rows of the input, and the corresponding slice of the matrix</remarks>
+	void addProductWork( eShader shader, Tensor res, Tensor a, in sTensorDesc weights, int groups, int totalGroups )
+	{
+		long flops = 2L * a.size.x * res.shape.countElements() * groups / totalGroups;
+		long bytesRead = tensorBytes( a ) + weightBytes( weights ) * groups / totalGroups;
+		addWork( shader, bytesRead, tensorBytes( res ) * groups / totalGroups, flops );
+	}
+
 	/// <summary>An approximate equivalent of <c>ggml_get_rows</c></summary>
 	public Tensor getRows( iTensor source, iTensor rows, int start, int end, ref Tensor? cached )
 	{
@@ -68,6 +110,7 @@ partial struct Context
 		res = fp16( ref cached, emb.shape.size.x, outputWidth, r.shape.size.y );
 		context.getRows( cb, res.native, source, rows );
 		context.dispatch( outputWidth, r.shape.size.y );
+		addWork( eShader.getRows, tensorBytes( res ) + (long)outputWidth * r.shape.size.y * 4, tensorBytes( res ) );
 
 		return res;
 	}
@@ -89,6 +132,14 @@ partial struct Context
 #endif
 	}
 
+	void addRmsNormWork( eShader shader, Tensor tensor )
+	{
+		// Square and accumulate, then scale by the norm and by the weights
+		long bytes = tensorBytes( tensor );
+		long cbWeights = (long)tensor.size.x * tensor.dataType.elementSize();
+		addWork( shader, bytes + cbWeights, bytes, 4L * tensor.shape.countElements() );
+	}
+
 	/// <summary>Compute RMSNorm in place</summary>
 	public void rmsNorm( Tensor tensor, iTensor weights )
 	{
@@ -102,6 +153,7 @@ partial struct Context
 		};
 		context.rmsNorm( cb, tensor.native, weights );
 		dispatchRows( tensor.size );
+		addRmsNormWork( eShader.rmsNorm, tensor );
 	}
 
 	/// <summary>Compute RMSnorm, writing into a temporary tensor</summary>
@@ -118,6 +170,7 @@ partial struct Context
 		};
 		context.rmsNorm2( cb, res.native, tensor.native, weights );
 		dispatchRows( tensor.size );
+		addRmsNormWork( eShader.rmsNorm2, tensor );
 		return res;
 	}
 
@@ -139,7 +192,7 @@ partial struct Context
 		context.dispatch( groupsX, a.size.y, a.size.z );
 	}
 
-	void rowMatProductFixed( Tensor res, Tensor a, iTensor b )
+	void rowMatProductFixed( Tensor res, Tensor a, iTensor b, in sTensorDesc bDesc )
 	{
 		var cb = new ConstantBuffers.rowMatProductFixed
 		{
@@ -157,6 +210,7 @@ partial struct Context
 		if( isFastGpu || ( a.size.y == 1 && a.size.z == 1 ) )
 		{
 			context.dispatch( groupsX, 1, 1 );
+			addProductWork( eShader.rowMatProductFixed, res, a, bDesc );
 		}
 		else
 		{
@@ -172,6 +226,8 @@ partial struct Context
 					context.bindShader( (ushort)eShader.rowMatProductFixed, ref cb );
 				}
 				context.dispatch( len, 1, 1 );
+				// The profiler measures every bindShader call separately, declare the work of this batch
+				addProductWork( eShader.rowMatProductFixed, res, a, bDesc, len, groupsX );
 			}
 		}
 	}
@@ -181,12 +237,20 @@ partial struct Context
 		if( bDesc.layout == eTensorLayout.Dense )
 		{
 			if( a.size.x == 4096 )
-				rowMatProductFixed( res, a, b );
+			{
+				rowMatProductFixed( res, a, b, bDesc );
+			}
 			else
+			{
 				columnProductDense( res, a, b );
+				addProductWork( eShader.rowMatProduct, res, a, bDesc );
+			}
 		}
 		else
+		{
 			columnProductCompressed( res, a, b, bDesc );
+			addProductWork( eShader.rowMatProductBc1, res, a, bDesc );
+		}
 	}
 
 	/// <summary>Multiply rows of the tensor by a matrix, i.e. [ x, y, z ] * [ x, r ] = [ r, y, z ]</summary>
@@ -201,6 +265,59 @@ partial struct Context
 		return res;
 	}
 
+	/// <summary>Compute silu( a * w1 ) * ( a * w3 ), the gate and up projections of the SwiGLU feed-forward network</summary>
+	/// <remarks>When possible, both products and the activation are computed by a single compute shader,
+	/// which reads the input rows once, and doesn't write the intermediate products to VRAM.</remarks>
+	public Tensor columnProductSwiGLU( Tensor a, iTensor w1, iTensor w3, ref Tensor? cached, ref Tensor? upCache )
+	{
+		var gateDesc = w1.getDesc();
+		var upDesc = w3.getDesc();
+		if( gateDesc.size.x != a.size.x || gateDesc.size != upDesc.size || gateDesc.layout != upDesc.layout )
+			throw new ArgumentException();
+
+		if( gateDesc.layout == eTensorLayout.Dense )
+		{
+			// For rows of length 4096, including the single row of the decode, rowMatProductFixed shader is faster than the fused one.
+			// The fused shader uses the same algorithm as rowMatProduct.hlsl, it only replaces that slower shader.
+			if( a.size.x != 4096 )
+			{
+				Tensor res = fp16( ref cached, gateDesc.size.y, a.size.y, a.size.z );
+				columnProductSwiGLUDense( res, a, w1, w3 );
+				addProductWork( eShader.rowMatProductSwiGLU, res, a, gateDesc, 2 );
+				return res;
+			}
+		}
+		else if( gateDesc.layout == eTensorLayout.BCML1 && !bfloat16 )
+		{
+			Tensor res = fp16( ref cached, gateDesc.size.y, a.size.y, a.size.z );
+			columnProductSwiGLUCompressed( res, a, w1, w3, gateDesc );
+			addProductWork( eShader.rowMatSwiGLUBc1, res, a, gateDesc, 2 );
+			return res;
+		}
+
+		// Fallback to 2 separate products followed by the activation
+		Tensor gate = columnProduct( a, w1, ref cached );
+		Tensor up = columnProduct( a, w3, ref upCache );
+		SiLU( gate, up );
+		return gate;
+	}
+
+	void columnProductSwiGLUDense( Tensor res, Tensor a, iTensor w1, iTensor w3 )
+	{
+		var cb = new ConstantBuffers.rowMatProductSwiGLU
+		{
+			rowLength = (uint)a.size.x,
+			rowsCount = (uint)res.size.x,
+			arg0Strides = new uint2( a.stride.y, a.stride.z ),
+			resultStrides = new uint2( res.stride.y, res.stride.z ),
+		};
+		context.rowMatProductSwiGLU( cb, res.native, a.native, w1, w3 );
+
+		const int THREADS = 512;
+		int groupsX = ( res.size.x + THREADS - 1 ) / THREADS;
+		context.dispatch( groupsX, a.size.y, a.size.z );
+	}
+
 	public Tensor columnProductStaging( Tensor a, iTensor b, ref Tensor? cached )
 	{
 		var bDesc = b.getDesc();
@@ -221,6 +338,10 @@ partial struct Context
 		return cached;
 	}
 
+	// Every pair of elements is rotated with 4 multiplications and 2 additions
+	void addRotaryWork( eShader shader, Tensor t ) =>
+		addWork( shader, tensorBytes( t ), tensorBytes( t ), 3L * t.shape.countElements() );
+
 	public void rotaryEmbedding( Tensor xq, Tensor xk, int columnOffset, float minusHalfDimMul, float theta = 10000.0f )
 	{
 		var cb = new ConstantBuffers.rotaryEmbedding
@@ -233,11 +354,13 @@ partial struct Context
 		};
 		context.rotaryEmbedding( cb, xq.native );
 		dispatchRows( xq.size );
+		addRotaryWork( eShader.rotaryEmbedding, xq );
 
 		cb.size = xk.size;
 		cb.stride = xk.stride;
 		context.rotaryEmbedding( cb, xk.native );
 		dispatchRows( xk.size );
+		addRotaryWork( eShader.rotaryEmbedding, xk );
 	}
 
 	public void rotaryEmbedding2( Tensor xq, Tensor xk, int columnOffset, float minusHalfDimMul, float theta )
@@ -255,10 +378,12 @@ partial struct Context
 		};
 		context.rotaryEmbedding2( cb, xq.native );
 		dispatchRows( xq.size );
+		addRotaryWork( eShader.rotaryEmbedding2, xq );
 
 		cb.stride = xk.stride.yzw;
 		context.rotaryEmbedding2( cb, xk.native );
 		dispatchRows( xk.size );
+		addRotaryWork( eShader.rotaryEmbedding2, xk );
 	}
 
 	/// <summary>Create a dense row-major tensor filled with zeros</summary>
@@ -275,7 +400,7 @@ partial struct Context
 		cache ??= new Tensor( device );
 		cache.create( desc );
 
-		context.writeDenseZeros( cache.native, desc.shape.size );
+		context.writeDenseZeros( cache.native, desc.shape.size, work );
 		return cache;
 	}
 
@@ -318,6 +443,15 @@ partial struct Context
 		};
 		context.attentionCacheUpdate( cb, cache.native, t.native );
 		context.dispatch( threadGroups, t.size.w );
+		long copiedBytes = (long)threadGroups * t.size.w * cb.rowLength * t.dataType.elementSize();
+		addWork( eShader.attentionCacheUpdate, copiedBytes, copiedBytes );
+	}
+
+	void addMulMatWork( eShader shader, Tensor res, in TensorShape aShape, in TensorShape bShape )
+	{
+		const int cbElement = 2;
+		long bytesRead = ( (long)aShape.countElements() + bShape.countElements() ) * cbElement;
+		addWork( shader, bytesRead, tensorBytes( res ), 2L * aShape.size.x * res.shape.countElements() );
 	}
 
 	public Tensor mulMat( iTensor a, iTensor b,
@@ -347,6 +481,7 @@ partial struct Context
 		int y = ( res.size.y + TILE_SIZE - 1 ) / TILE_SIZE;
 		int z = res.size.z * res.size.w;
 		context.dispatch( x, y, z );
+		addMulMatWork( eShader.mulMatTiled, res, aShape, bShape );
 
 		return res;
 	}
@@ -381,6 +516,7 @@ partial struct Context
 		int y = ( res.size.y + TILE_SIZE - 1 ) / TILE_SIZE;
 		int z = res.size.z * res.size.w;
 		context.dispatch( x, y, z );
+		addMulMatWork( eShader.mulMatTiledRepeatZ, res, aShape, bShape );
 
 		return res;
 	}
@@ -419,8 +555,15 @@ partial struct Context
 
 		context.applyMask( cb, t.native );
 		dispatchRows( t.size );
+		// Approximately half of every square slice is masked
+		long maskedBytes = (long)mask.size * mask.size / 2 * t.size.z * t.size.w * t.dataType.elementSize();
+		addWork( eShader.applyMask, 0, maskedBytes );
 	}
 
+	// Maximum, subtract and exponent, sum, normalize
+	void addSoftMaxWork( eShader shader, Tensor t ) =>
+		addWork( shader, tensorBytes( t ), tensorBytes( t ), 5L * t.shape.countElements() );
+
 	/// <summary>torch.nn.Softmax, on the X dimension of the tensor</summary>
 	/// <seealso href="https://pytorch.org/docs/stable/generated/torch.nn.Softmax.html" />
 	public void softMax( Tensor t )
@@ -435,6 +578,7 @@ partial struct Context
 		};
 		context.softMax( cb, t.native );
 		dispatchRows( t.size );
+		addSoftMaxWork( eShader.softMax, t );
 	}
 
 	/// <summary>Compute the logarithm of the softmax function.</summary>
@@ -451,6 +595,7 @@ partial struct Context
 		};
 		context.logSoftMax( cb, t.native );
 		dispatchRows( t.size );
+		addSoftMaxWork( eShader.logSoftMax, t );
 	}
 
 	public Tensor copyTranspose( Tensor t, in TensorShape shape, ref Tensor? cache )
@@ -467,6 +612,7 @@ partial struct Context
 		context.copyTranspose( cb, cache.native, t.native );
 
 		dispatchRows( shape.size );
+		addWork( eShader.copyTranspose, tensorBytes( cache ), tensorBytes( cache ) );
 		return cache;
 	}
 
@@ -483,6 +629,7 @@ partial struct Context
 		};
 		context.addInPlace( cb, a.native, b.native );
 		dispatchRows( a.size );
+		addWork( eShader.addInPlace, tensorBytes( a ) * 2, tensorBytes( a ), a.shape.countElements() );
 	}
 
 	/// <summary>a = silu(a) * b, in-place</summary>
@@ -499,6 +646,7 @@ partial struct Context
 		};
 		context.silu( cb, a.native, b.native );
 		dispatchRows( a.size );
+		addWork( eShader.silu, tensorBytes( a ) * 2, tensorBytes( a ), 5L * a.shape.countElements() );
 	}
 
 	void softMaxFinal( Tensor logits, float temperature )
@@ -514,6 +662,7 @@ partial struct Context
 		};
 		context.softMaxFinal( cb, logits.native );
 		dispatchRows( logits.size );
+		addSoftMaxWork( eShader.softMaxFinal, logits );
 	}
 
 	Tensor makeUintTensor( ref Tensor? cached, int x, int y = 1, eBufferUse usage = eBufferUse.ReadWrite )
@@ -531,6 +680,10 @@ partial struct Context
 		return res;
 	}
 
+	// Histogram of the values in the counters tensor, then prefix sums to select the sampled element
+	void addSamplingWork( eShader shader, Tensor logits, Tensor counters, Tensor res ) =>
+		addWork( shader, tensorBytes( logits ) + tensorBytes( counters ), tensorBytes( counters ) + tensorBytes( res ), 2L * logits.shape.countElements() );
+
 	public Tensor sampleTopP( Tensor logits, SamplingParams samplingParams, Random rand )
 	{
 		softMaxFinal( logits, samplingParams.temperature );
@@ -557,6 +710,7 @@ partial struct Context
 		};
 		context.sampleTopP( cb, temp.native, res.native, logits.native );
 		context.dispatch( size.y );
+		addSamplingWork( eShader.sampleTopP, logits, temp, res );
 		return res;
 	}
 
@@ -578,6 +732,8 @@ partial struct Context
 		};
 		context.sampleAll( cb, res.native, probs.native );
 		context.dispatch( 1 );
+		// Prefix sum of the probabilities
+		addWork( eShader.sampleAll, tensorBytes( probs ), tensorBytes( res ), probs.shape.countElements() );
 		return res;
 	}
 
@@ -598,6 +754,7 @@ partial struct Context
 		};
 		context.sampleTopK( cb, temp.native, res.native, logits.native );
 		context.dispatch( 1 );
+		addSamplingWork( eShader.sampleTopK, logits, temp, res );
 
 		return res;
 	}
@@ -618,6 +775,8 @@ partial struct Context
 		};
 		context.sampleMax( cb, res.native, logits.native );
 		context.dispatch( size.y );
+		// 1 comparison per element
+		addWork( eShader.sampleMax, tensorBytes( logits ), tensorBytes( res ), logits.shape.countElements() );
 		return res;
 	}
 
@@ -647,6 +806,8 @@ partial struct Context
 		};
 		context.replaceResultColumn( cb, tokens, nextTokens.native, mask );
 		context.dispatch( 1 );
+		// Reads the new tokens and the mask, writes a column of the tokens
+		addWork( eShader.replaceResultColumn, 8L * height, 4L * height );
 	}
 
 	public ProfilerBlock profilerBlock( eProfilerBlock id ) =>
@@ -671,6 +832,8 @@ partial struct Context
 		};
 		context.copyLastRow( cb, t.native );
 		context.dispatch( 1, t.size.z, t.size.w );
+		long rowBytes = (long)t.size.x * t.size.z * t.size.w * t.dataType.elementSize();
+		addWork( eShader.copyLastRow, rowBytes, rowBytes );
 
 		var shape = t.shape.trim( 1, 1 );
 		return copyTranspose( t, shape, ref cache );
@@ -688,6 +851,7 @@ partial struct Context
 		var cb = shape.unrotateConstants( res.shape );
 		context.unrotate( cb, res.native, t.native );
 		dispatchRows( res.size );
+		addWork( eShader.unrotate, tensorBytes( res ), tensorBytes( res ) );
 		return res;
 	}
 
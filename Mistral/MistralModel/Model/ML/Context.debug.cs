@@ -11,27 +11,29 @@ partial struct Context
 	public string? prefix;
 #endif
 
-#if DEBUG
+	/// <summary>Save the named intermediate tensor into the capture, if any.<br/>
+	/// In debug builds, also compare with the tensor dumped from the Python version of the model.</summary>
 	public void dbgCompareTensor( iTensor tensor, string zip )
 	{
+		capture?.add( context, tensor, zip );
+#if DEBUG
 		if( null == dumps )
 			return;
-		TensorData data = context.downloadTensor( tensor );
 		if( null != prefix )
 			zip = $"{prefix}-{zip}";
 
 		string path = Path.Combine( dumps, Path.ChangeExtension( zip, ".zip" ) );
+		if( !File.Exists( path ) )
+			return;
+		TensorData data = context.downloadTensor( tensor );
 		TensorData test = Torch.TensorLoader.load( path );
 		TensorsDiff diff = data.diff( test );
 		Logger.Debug( @"{0}: {1}, {2}", zip, data.desc.shape.description(), diff );
+#endif
 	}
 
 	public void dbgCompareTensor( Tensor tensor, string zip ) =>
 		dbgCompareTensor( tensor.native, zip );
-#else
-	public void dbgCompareTensor( iTensor tensor, string zip ) { }
-	public void dbgCompareTensor( Tensor tensor, string zip ) { }
-#endif
 
 #if DEBUG
 	readonly struct TopKTemp
@@ -0,0 +1,104 @@
+﻿namespace Mistral.Model;
+
+/// <summary>Temporary tensors used by a single layer of the model</summary>
+enum eLayerTemp: byte
+{
+	norm,
+	xq, xk, xv,
+	attnKey, attnVal,
+	scores,
+	attnTemp1, attnTemp2, attnOut,
+	ff1, ff2,
+}
+
+/// <summary>Liveness analysis of the per-layer temporary tensors</summary>
+/// <remarks>Temporaries with disjoint lifetimes are assigned to the same slot, and share the GPU buffer.<br/>
+/// The aliasing is done for complete buffers, as opposed to offsets in a single arena, because D3D11 tracks read/write hazards per resource:
+/// binding a UAV of the buffer unbinds all SRVs of the same buffer, even when the ranges don't overlap.</remarks>
+static class LayerLiveness
+{
+	/// <summary>Temporaries accessed by the compute shaders dispatched for one layer, in the order of execution</summary>
+	/// <remarks>Must be kept in sync with <c>forward</c> methods of <see cref="TransformerBlock" />, <see cref="Attention" /> and <see cref="FeedForward" /> classes.</remarks>
+	static readonly eLayerTemp[][] dataflow = new eLayerTemp[][]
+	{
+		// attention_norm
+		new[] { eLayerTemp.norm },
+		// wq, wk, wv
+		new[] { eLayerTemp.xq, eLayerTemp.norm },
+		new[] { eLayerTemp.xk, eLayerTemp.norm },
+		new[] { eLayerTemp.xv, eLayerTemp.norm },
+		// Rotary embedding, in place
+		new[] { eLayerTemp.xq, eLayerTemp.xk },
+		// Store into the caches
+		new[] { eLayerTemp.xk },
+		new[] { eLayerTemp.xv },
+		// Load from both caches
+		new[] { eLayerTemp.attnKey },
+		new[] { eLayerTemp.attnVal },
+		// Attention scores; mask and softmax are in place
+		new[] { eLayerTemp.scores, eLayerTemp.attnKey, eLayerTemp.xq },
+		new[] { eLayerTemp.scores },
+		// Scores * values, transpose, wo
+		new[] { eLayerTemp.attnTemp1, eLayerTemp.attnVal, eLayerTemp.scores },
+		new[] { eLayerTemp.attnTemp2, eLayerTemp.attnTemp1 },
+		new[] { eLayerTemp.attnOut, eLayerTemp.attnTemp2 },
+		// Residual connection, then ffn_norm
+		new[] { eLayerTemp.attnOut },
+		new[] { eLayerTemp.norm },
+		// w1, w3, SiLU, w2; when the first 3 are fused, ff2 is only written by the w2 product, the table covers both versions
+		new[] { eLayerTemp.ff1, eLayerTemp.norm },
+		new[] { eLayerTemp.ff2, eLayerTemp.norm },
+		new[] { eLayerTemp.ff1, eLayerTemp.ff2 },
+		new[] { eLayerTemp.ff2, eLayerTemp.ff1 },
+		// Residual connection
+		new[] { eLayerTemp.ff2 },
+	};
+
+	static readonly byte[] slots;
+
+	/// <summary>Count of distinct tensors needed for all per-layer temporaries</summary>
+	public static readonly int countSlots;
+
+	/// <summary>Index of the slot assigned to the temporary</summary>
+	public static int slot( eLayerTemp t ) => slots[ (int)t ];
+
+	static LayerLiveness()
+	{
+		int count = Enum.GetValues<eLayerTemp>().Length;
+		int[] first = new int[ count ];
+		int[] last = new int[ count ];
+		Array.Fill( first, -1 );
+
+		for( int i = 0; i < dataflow.Length; i++ )
+		{
+			foreach( eLayerTemp t in dataflow[ i ] )
+			{
+				if( first[ (int)t ] < 0 )
+					first[ (int)t ] = i;
+				last[ (int)t ] = i;
+			}
+		}
+
+		// Greedy interval partitioning, ordered by the first use.
+		// A slot can be reused when the previous tenant is no longer accessed by the shader which writes the new one,
+		// this is why the comparison is strict: inputs and outputs of the same dispatch must be different buffers.
+		slots = new byte[ count ];
+		List<int> slotEnd = new List<int>();
+		foreach( int i in Enumerable.Range( 0, count ).OrderBy( i => first[ i ] ) )
+		{
+			if( first[ i ] < 0 )
+				throw new ApplicationException( $"Temporary tensor {(eLayerTemp)i} is missing from the dataflow" );
+
+			int s = slotEnd.FindIndex( end => end < first[ i ] );
+			if( s < 0 )
+			{
+				s = slotEnd.Count;
+				slotEnd.Add( last[ i ] );
+			}
+			else
+				slotEnd[ s ] = last[ i ];
+			slots[ i ] = (byte)s;
+		}
+		countSlots = slotEnd.Count;
+	}
+}
\ No newline at end of file
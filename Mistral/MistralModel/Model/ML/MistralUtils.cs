@@ -5,7 +5,8 @@ using System.Diagnostics;
 static class MistralUtils
 {
 	/// <summary>Fill the complete tensor with zero elements</summary>
-	public static void writeDenseZeros( this iContext context, iTensor tensor, in Int128 size )
+	/// <remarks>When <c>work</c> is not null, the method declares the written bytes there</remarks>
+	public static void writeDenseZeros( this iContext context, iTensor tensor, in Int128 size, KernelWork? work = null )
 	{
 		int length = size.horizontalProduct();
 		const int VALS_PER_GROUP = 0x10000;
@@ -17,6 +18,7 @@ static class MistralUtils
 		};
 		context.memsetFloat( cb, tensor );
 		context.dispatch( groups );
+		work?.add( (ushort)eShader.memsetFloat, 0, (long)length * tensor.getDesc().dataType.elementSize(), 0 );
 	}
 
 	// Split [ 0 .. total - 1 ] interval into slices, so that every slice does not exceed maxBatch
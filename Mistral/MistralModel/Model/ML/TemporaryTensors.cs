@@ -4,16 +4,26 @@ using Cgml;
 sealed class TemporaryTensors: TensorPool
 {
 	// === Per-layer temporaries ===
+	// These temporaries alias each other, see LayerLiveness class for the assignment
+	readonly Tensor?[] layerSlots = new Tensor?[ LayerLiveness.countSlots ];
+
+	ref Tensor? layerTemp( eLayerTemp t ) => ref layerSlots[ LayerLiveness.slot( t ) ];
 
 	// Attention temporaries
-	public Tensor? norm;
-	public Tensor? xq, xk, xv;
-	public Tensor? scores;
-	public Tensor? attnTemp1, attnTemp2, attnOut;
-	public Tensor? attnKey, attnVal;
+	public ref Tensor? norm => ref layerTemp( eLayerTemp.norm );
+	public ref Tensor? xq => ref layerTemp( eLayerTemp.xq );
+	public ref Tensor? xk => ref layerTemp( eLayerTemp.xk );
+	public ref Tensor? xv => ref layerTemp( eLayerTemp.xv );
+	public ref Tensor? scores => ref layerTemp( eLayerTemp.scores );
+	public ref Tensor? attnTemp1 => ref layerTemp( eLayerTemp.attnTemp1 );
+	public ref Tensor? attnTemp2 => ref layerTemp( eLayerTemp.attnTemp2 );
+	public ref Tensor? attnOut => ref layerTemp( eLayerTemp.attnOut );
+	public ref Tensor? attnKey => ref layerTemp( eLayerTemp.attnKey );
+	public ref Tensor? attnVal => ref layerTemp( eLayerTemp.attnVal );
 
 	// Feed Forward temporaries
-	public Tensor? ff1, ff2;
+	public ref Tensor? ff1 => ref layerTemp( eLayerTemp.ff1 );
+	public ref Tensor? ff2 => ref layerTemp( eLayerTemp.ff2 );
 
 	// === Global temporaries ===
 	public Tensor? inpL;
@@ -23,4 +33,7 @@ sealed class TemporaryTensors: TensorPool
 #if DEBUG
 	public Tensor? dbgRowMajor;
 #endif
+
+	protected override IEnumerable<Tensor?> listTensors() =>
+		base.listTensors().Concat( layerSlots );
 }
\ No newline at end of file
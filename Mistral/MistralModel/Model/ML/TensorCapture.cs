@@ -0,0 +1,19 @@
+﻿namespace Mistral.Model;
+using Cgml;
+
+/// <summary>Collects named intermediate tensors of the model, downloading them into system memory</summary>
+/// <remarks>The names are the same as passed to <see cref="Context.dbgCompareTensor(iTensor, string)" />, like <c>03-xq</c> or <c>11-scores</c></remarks>
+sealed class TensorCapture
+{
+	/// <summary>A single downloaded tensor</summary>
+	public readonly record struct Entry( int layer, string name, TensorData data );
+
+	/// <summary>Index of the current layer, -1 outside of the layers</summary>
+	public int layer = -1;
+
+	/// <summary>Captured tensors, in the order of the computations</summary>
+	public readonly List<Entry> tensors = new List<Entry>();
+
+	public void add( iContext context, iTensor tensor, string name ) =>
+		tensors.Add( new Entry( layer, name, context.downloadTensor( tensor ) ) );
+}
\ No newline at end of file
@@ -8,6 +8,7 @@ enum eProfilerBlock: ushort
 	MakeToken = 3,
 	Layer = 4,
 	BackupRestoreState = 5,
+	KernelBenchmark = 6,
 }
 
 static class FormatExt
@@ -32,4 +33,19 @@ static class FormatExt
 	{
 		return arr.formatted( blockName, shaderName );
 	}
+
+	public static IEnumerable<string> formatted( this ProfilerPercentiles[]? arr, float[] percentiles )
+	{
+		return arr.formatted( percentiles, blockName, shaderName );
+	}
+
+	public static IEnumerable<string> formattedRoofline( this ProfilerResult[]? arr, KernelWork work, double peakBandwidth, double peakGflops )
+	{
+		return arr.formattedRoofline( work, shaderName, peakBandwidth, peakGflops );
+	}
+
+	public static void writeChromeTrace( this ProfilerEvent[]? arr, Stream stream )
+	{
+		arr.writeChromeTrace( stream, blockName, shaderName );
+	}
 }
\ No newline at end of file
@@ -0,0 +1,94 @@
+﻿namespace Mistral.Model;
+using Cgml;
+using System.Diagnostics;
+using System.Runtime.Intrinsics;
+
+sealed partial class Model: iModel
+{
+	const string benchmarkText = "The quick brown fox jumps over the lazy dog. ";
+
+	/// <summary>Make a deterministic prompt of the specified length, BOS followed by tokens of the repeated sentence</summary>
+	internal int[] benchmarkPrompt( int length )
+	{
+		int[] bos = tokenizer.encode( benchmarkText, true, false );
+		int[] sentence = tokenizer.encode( benchmarkText, false, false );
+		int[] res = new int[ length ];
+		res[ 0 ] = bos[ 0 ];
+		for( int i = 1; i < length; i++ )
+			res[ i ] = sentence[ ( i - 1 ) % sentence.Length ];
+		return res;
+	}
+
+	GenerationTimings iModel.benchmark( int promptLength, int generateLength )
+	{
+		if( promptLength < 1 )
+			throw new ArgumentOutOfRangeException( nameof( promptLength ) );
+		if( generateLength < 1 )
+			throw new ArgumentOutOfRangeException( nameof( generateLength ) );
+
+		Context ctx = transformer.context( dev, performanceParams, kernelWork );
+		using var rootBlock = ctx.profilerBlock( eProfilerBlock.Generate );
+
+		// Reset the KV caches, every measure starts from the same state
+		transformer.prepareCaches( ctx );
+		cacheMetadata = new RotatingCacheMetadata( ctx.parameters.slidingWindow );
+		firstGenerate = false;
+		int[] prompt = benchmarkPrompt( promptLength );
+
+		// The value is not needed, the download only makes sure the token has arrived to system memory
+		pfnReadTensor<int> pfnRead = delegate ( ReadOnlySpan<int> source )
+		{
+			Debug.Assert( source.Length == 1 );
+		};
+
+		Stopwatch sw = Stopwatch.StartNew();
+		input = createInputTensor( prompt );
+
+		Tensor logprobs;
+		using( var block = ctx.profilerBlock( eProfilerBlock.PreFill ) )
+		{
+			cacheMetadata.begin( promptLength );
+			logprobs = transformer.preFill( ref ctx, input, cacheMetadata, promptLength );
+			cacheMetadata.end( promptLength );
+			logprobs = ctx.trimToLastRow( logprobs, ref ctx.temp.logProbsTrimmed );
+			if( transformer.modelVersion == eModelVersion.Original )
+				ctx.logSoftMax( logprobs );
+		}
+
+		// Greedy sampling, and EOS doesn't stop the generation: the count of generated tokens is always the same
+		TimeSpan[] latencies = new TimeSpan[ generateLength - 1 ];
+		TimeSpan ttft;
+		using( var block = ctx.profilerBlock( eProfilerBlock.MakeToken ) )
+		{
+			Tensor token = ctx.sampleMax( logprobs );
+			dev.context.download( token.native, pfnRead );
+			ttft = sw.Elapsed;
+
+			TimeSpan prev = ttft;
+			for( int i = 0; i < latencies.Length; i++ )
+			{
+				cacheMetadata.begin();
+				logprobs = transformer.computeNext( ref ctx, token, cacheMetadata, i );
+				cacheMetadata.end();
+				if( transformer.modelVersion == eModelVersion.Original )
+					ctx.logSoftMax( logprobs );
+
+				token = ctx.sampleMax( logprobs );
+				dev.context.download( token.native, pfnRead );
+
+				TimeSpan now = sw.Elapsed;
+				latencies[ i ] = now - prev;
+				prev = now;
+			}
+		}
+		return new GenerationTimings( promptLength, ttft, latencies );
+	}
+
+	Dictionary<string, Vector128<long>> iModel.memoryUse()
+	{
+		var dict = new Dictionary<string, Vector128<long>>();
+		transformer.getMemoryUse( dict );
+		dict.addTensorMemory( input );
+		return dict;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+﻿namespace Mistral.Model;
+using Cgml;
+
+sealed partial class Model: iModel
+{
+	/// <summary>Run pre-fill of the prompt, and download all named intermediate tensors</summary>
+	/// <remarks>The method resets the state of the model</remarks>
+	internal TensorCapture captureIntermediates( int[] tokens )
+	{
+		TensorCapture capture = new TensorCapture();
+		Context ctx = transformer.context( dev, performanceParams, kernelWork, capture );
+		using var rootBlock = ctx.profilerBlock( eProfilerBlock.PreFill );
+
+		transformer.prepareCaches( ctx );
+		cacheMetadata = new RotatingCacheMetadata( ctx.parameters.slidingWindow );
+		firstGenerate = false;
+		input = createInputTensor( tokens );
+
+		cacheMetadata.begin( tokens.Length );
+		transformer.preFill( ref ctx, input, cacheMetadata, tokens.Length );
+		cacheMetadata.end( tokens.Length );
+
+		// Leave the model in the initial state
+		transformer.prepareCaches( ctx );
+		cacheMetadata = new RotatingCacheMetadata( ctx.parameters.slidingWindow );
+		return capture;
+	}
+
+	/// <summary>Compare a replayed command list, with patched constants and dispatch sizes, against the direct calls</summary>
+	/// <remarks>The method resets the state of the model</remarks>
+	internal float checkReplay( int[] tokens )
+	{
+		Context ctx = transformer.context( dev, performanceParams, kernelWork );
+		using var rootBlock = ctx.profilerBlock( eProfilerBlock.PreFill );
+
+		input = createInputTensor( tokens );
+		float res = transformer.checkReplay( ctx, dev.context, input, tokens.Length );
+
+		// Leave the model in the initial state
+		transformer.prepareCaches( ctx );
+		cacheMetadata = new RotatingCacheMetadata( ctx.parameters.slidingWindow );
+		firstGenerate = false;
+		return res;
+	}
+}
\ No newline at end of file
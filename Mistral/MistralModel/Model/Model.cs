@@ -4,6 +4,8 @@ using System;
 using System.Diagnostics;
 using System.IO.Compression;
 using System.Runtime.InteropServices;
+using System.Text;
+using SentencePiece;
 
 sealed partial class Model: iModel
 {
@@ -131,7 +133,7 @@ sealed partial class Model: iModel
 
 	string iModel.generate( string prompt, int maxTokens )
 	{
-		Context ctx = transformer.context( dev, performanceParams );
+		Context ctx = transformer.context( dev, performanceParams, kernelWork );
 		using var rootBlock = ctx.profilerBlock( eProfilerBlock.Generate );
 		transformer.prepareCaches( ctx );
 #if DEBUG
@@ -231,7 +233,7 @@ sealed partial class Model: iModel
 
 	string iModel.generate( IReadOnlyList<int> tokens, ChatClient client )
 	{
-		Context ctx = transformer.context( dev, performanceParams );
+		Context ctx = transformer.context( dev, performanceParams, kernelWork );
 		using var rootBlock = ctx.profilerBlock( eProfilerBlock.Generate );
 		if( firstGenerate )
 		{
@@ -266,7 +268,9 @@ sealed partial class Model: iModel
 				generated.Add( source[ 0 ] );
 			};
 
-			string result = "";
+			// Decode the tokens as they arrive, instead of decoding the complete sequence after every token
+			using iStreamingDecoder decoder = tokenizer.createStreamingDecoder();
+			StringBuilder text = new StringBuilder();
 			for( int i = 0; i < maxTokens; i++ )
 			{
 				Tensor token = makeToken( ctx, logprobs );
@@ -274,18 +278,25 @@ sealed partial class Model: iModel
 				dev.context.download( token.native, pfnRead );
 
 				int generatedCount = generated.Count;
-				bool eos = generated[ generated.Count - 1 ] == tokenizer.idEOS;
+				int lastToken = generated[ generated.Count - 1 ];
+				int newText = text.Length;
+				bool eos = lastToken == tokenizer.idEOS;
 				if( eos )
+				{
 					generated.RemoveAt( generated.Count - 1 );
+					text.Append( decoder.flush() );
+				}
+				else
+					text.Append( decoder.push( lastToken ) );
 
-				result = tokenizer.decode( CollectionsMarshal.AsSpan( generated ) );
 				if( eos )
 				{
 					client.complete( generatedCount );
-					return result;
+					return text.ToString();
 				}
 
-				string? res = client.tryMakeResponse( result );
+				// Only the new characters are tested for stop markers, the string is built once when the generation ends
+				string? res = client.tryMakeResponse( text, newText );
 				if( null != res )
 				{
 					client.complete( generatedCount );
@@ -299,7 +310,8 @@ sealed partial class Model: iModel
 				if( transformer.modelVersion == eModelVersion.Original )
 					ctx.logSoftMax( logprobs );
 			}
-			return result;
+			text.Append( decoder.flush() );
+			return text.ToString();
 		}
 	}
 }
\ No newline at end of file
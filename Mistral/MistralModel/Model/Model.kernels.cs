@@ -0,0 +1,56 @@
+﻿namespace Mistral.Model;
+using Cgml;
+
+sealed partial class Model: iModel
+{
+	KernelTimings[] iModel.benchmarkKernels( int length, int iterations )
+	{
+		if( length < 1 || length > transformer.parameters.slidingWindow )
+			throw new ArgumentOutOfRangeException( nameof( length ) );
+		if( iterations < 1 )
+			throw new ArgumentOutOfRangeException( nameof( iterations ) );
+
+		Context ctx = transformer.context( dev, performanceParams, kernelWork );
+		using( var block = ctx.profilerBlock( eProfilerBlock.KernelBenchmark ) )
+			transformer.prepareCaches( ctx );
+		input = createInputTensor( benchmarkPrompt( length ) );
+
+		List<KernelTimings> result = new List<KernelTimings>();
+		void measure( string name, Action act )
+		{
+			// The first call creates the temporary tensors, it is not measured
+			using( var block = ctx.profilerBlock( eProfilerBlock.KernelBenchmark ) )
+				act();
+			dev.context.profilerGetPercentiles( reportedPercentiles, true );
+			kernelWork.reset();
+
+			// Every iteration is a top-level profiler block, which waits for the GPU timestamps
+			for( int i = 0; i < iterations; i++ )
+			{
+				using var block = ctx.profilerBlock( eProfilerBlock.KernelBenchmark );
+				act();
+			}
+
+			ProfilerPercentiles[]? arr = dev.context.profilerGetPercentiles( reportedPercentiles, true );
+			if( null == arr )
+				return;
+			foreach( ProfilerPercentiles pp in arr )
+			{
+				ProfilerResult res = pp.measure;
+				if( res.what != eProfilerMeasure.Shader || res.result.count <= 0 )
+					continue;
+				kernelWork.average( res.id, out double bytes, out double flops );
+				double ns = res.result.total.Ticks * 100.0 / res.result.count;
+				result.Add( new KernelTimings( name, length, ( (eShader)res.id ).ToString(), res.result.count, ns, pp.percentiles, bytes, flops ) );
+			}
+		}
+		transformer.benchmarkKernels( ctx, input, length, measure );
+
+		// The benchmark has trashed the KV caches, reset the state
+		using( var block = ctx.profilerBlock( eProfilerBlock.KernelBenchmark ) )
+			transformer.prepareCaches( ctx );
+		cacheMetadata = new RotatingCacheMetadata( ctx.parameters.slidingWindow );
+		firstGenerate = false;
+		return result.ToArray();
+	}
+}
\ No newline at end of file
@@ -46,6 +46,32 @@ sealed partial class Model: iModel
 	IEnumerable<string> iModel.profilerMeasures() =>
 		dev.context.profilerGetData().formatted();
 
+	static readonly float[] reportedPercentiles = new float[ 3 ] { 50, 90, 99 };
+
+	IEnumerable<string> iModel.profilerPercentiles( bool reset ) =>
+		dev.context.profilerGetPercentiles( reportedPercentiles, reset ).formatted( reportedPercentiles );
+
+	// Work declared by the compute shader dispatches, for the roofline report
+	readonly KernelWork kernelWork = new KernelWork();
+
+	IEnumerable<string> iModel.profilerRoofline( double peakBandwidth, double peakGflops ) =>
+		dev.context.profilerGetData().formattedRoofline( kernelWork, peakBandwidth, peakGflops );
+
+	void iModel.profilerCaptureTimeline( int capacity )
+	{
+		if( capacity < 0 )
+			throw new ArgumentOutOfRangeException( nameof( capacity ) );
+		dev.context.profilerCaptureTimeline( (uint)capacity );
+	}
+
+	void iModel.profilerSaveTimeline( string path )
+	{
+		ProfilerEvent[]? arr = dev.context.profilerGetTimeline();
+		using var stream = File.Create( path );
+		arr.writeChromeTrace( stream );
+		Logger.Info( "Saved profiler timeline: {0}", path );
+	}
+
 	ProfilerData? iModel.profilerData()
 	{
 		ProfilerResult[]? arr = dev.context.profilerGetData();
@@ -58,13 +84,28 @@ sealed partial class Model: iModel
 
 	const string vocabEntry = "tokenizer.model";
 
-	public void save( string path, string vocab, Action<double>? pfnProgress )
+	public void save( string path, string vocab, Action<double>? pfnProgress ) =>
+		save( path, zip => zip.CreateEntryFromFile( vocab, vocabEntry, CompressionLevel.SmallestSize ), pfnProgress );
+
+	/// <summary>Save the model, with the tokenizer supplied as a blob of bytes in memory</summary>
+	public void save( string path, byte[] vocab, Action<double>? pfnProgress )
+	{
+		void writeVocab( ZipArchive zip )
+		{
+			ZipArchiveEntry e = zip.CreateEntry( vocabEntry, CompressionLevel.SmallestSize );
+			using var stream = e.Open();
+			stream.Write( vocab );
+		}
+		save( path, writeVocab, pfnProgress );
+	}
+
+	void save( string path, Action<ZipArchive> writeVocab, Action<double>? pfnProgress )
 	{
 		Logger.Debug( "Saving CGML model.." );
 		using var zipFile = File.Create( path );
 		using var zip = new ZipArchive( zipFile, ZipArchiveMode.Create );
 
-		zip.CreateEntryFromFile( vocab, vocabEntry, CompressionLevel.SmallestSize );
+		writeVocab( zip );
 
 		Transformer.serializer().write( zip, transformer, dev.context, false, pfnProgress );
 
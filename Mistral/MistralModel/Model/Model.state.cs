@@ -4,10 +4,32 @@ using System.Diagnostics;
 
 sealed partial class Model: iModel
 {
-	iModelState iModel.stateBackup( iModelState? input )
+	/// <summary>Ranges of elements in the cache tensors which keep the tokens [ from .. to ), up to 2 pieces because the caches are circular</summary>
+	static int rowRanges( Span<(int, int)> result, int window, int rowElements, int from, int to )
 	{
-		using var rootBlock = dev.context.profilerBlock( (ushort)eProfilerBlock.BackupRestoreState );
+		Debug.Assert( from <= to );
+		if( to - from >= window )
+		{
+			result[ 0 ] = (0, window * rowElements);
+			return 1;
+		}
+		if( from == to )
+			return 0;
+
+		int begin = from % window;
+		int end = begin + ( to - from );
+		if( end <= window )
+		{
+			result[ 0 ] = (begin * rowElements, end * rowElements);
+			return 1;
+		}
+		result[ 0 ] = (begin * rowElements, window * rowElements);
+		result[ 1 ] = (0, ( end - window ) * rowElements);
+		return 2;
+	}
 
+	ModelState stateBackupImpl( iModelState? input )
+	{
 		int layers = transformer.layers.Length;
 		ModelState res;
 		if( input == null )
@@ -21,9 +43,13 @@ sealed partial class Model: iModel
 				throw new ArgumentException();
 		}
 
-		res.absolute = cacheMetadata?.absolute ?? 0;
-		if( 0 == res.absolute )
+		int absolute = cacheMetadata?.absolute ?? 0;
+		if( 0 == absolute )
+		{
+			res.absolute = 0;
+			res.synced = null;
 			return res;
+		}
 
 		sTensorDesc desc = new sTensorDesc
 		{
@@ -33,6 +59,7 @@ sealed partial class Model: iModel
 			layout = eTensorLayout.Dense
 		};
 
+		bool created = false;
 		iTensor createIfNeeded( ref iTensor? tensor, ref sTensorDesc desc )
 		{
 			if( null != tensor )
@@ -41,20 +68,55 @@ sealed partial class Model: iModel
 				Debug.Assert( oldDesc == desc );
 			}
 			else
+			{
 				tensor = dev.device.createTensor( ref desc );
+				created = true;
+			}
 			return tensor;
 		}
 
 		iContext context = dev.context;
+		ModelState.LayerCache[] dest = res.layers;
 		for( int i = 0; i < layers; i++ )
 		{
-			ModelState.LayerCache dest = res.layers[ i ];
-			iTensor k = createIfNeeded( ref dest.k, ref desc );
-			iTensor v = createIfNeeded( ref dest.v, ref desc );
+			createIfNeeded( ref dest[ i ].k, ref desc );
+			createIfNeeded( ref dest[ i ].v, ref desc );
+		}
+
+		// When the previous backup into this object was made from the same caches, only copy the tokens generated since then
+		int from = 0;
+		if( !created && res.isSynced( cacheMetadata!, transformer.cachesVersion ) && res.absolute <= absolute )
+			from = res.absolute;
 
+		int window = transformer.parameters.slidingWindow;
+		Int128 cacheSize = transformer.parameters.attnCacheSize;
+		Span<(int, int)> ranges = stackalloc (int, int)[ 2 ];
+		int countRanges = rowRanges( ranges, window, cacheSize.x * cacheSize.y, from, absolute );
+
+		for( int i = 0; i < layers; i++ )
+		{
 			Attention source = transformer.layers[ i ].attention;
-			source.backup( context, k, v );
+			for( int j = 0; j < countRanges; j++ )
+				source.backupRange( context, dest[ i ].k!, dest[ i ].v!, ranges[ j ].Item1, ranges[ j ].Item2 );
 		}
+
+		res.absolute = absolute;
+		res.synced = cacheMetadata;
+		res.syncedVersion = transformer.cachesVersion;
+		return res;
+	}
+
+	iModelState iModel.stateBackup( iModelState? input )
+	{
+		using var rootBlock = dev.context.profilerBlock( (ushort)eProfilerBlock.BackupRestoreState );
+		return stateBackupImpl( input );
+	}
+
+	iModelState iModel.stateBackupAsync( iModelState? input )
+	{
+		ModelState res = stateBackupImpl( input );
+		iContext context = dev.context;
+		res.setFence( context, context.fenceSignal() );
 		return res;
 	}
 
@@ -62,7 +124,7 @@ sealed partial class Model: iModel
 	{
 		cacheMetadata = new RotatingCacheMetadata( transformer.parameters.slidingWindow );
 		foreach( var layer in transformer.layers )
-			layer.attention.clear( dev.context );
+			layer.attention.clear( dev.context, kernelWork );
 	}
 
 	void iModel.stateRestore( iModelState? state )
@@ -88,16 +150,36 @@ sealed partial class Model: iModel
 		}
 
 		iContext context = dev.context;
-		for( int i = 0; i < layers; i++ )
+		int current = cacheMetadata.absolute;
+		if( sourceState.isSynced( cacheMetadata, transformer.cachesVersion ) && sourceState.absolute <= current )
 		{
-			ModelState.LayerCache sourceLayer = sourceState.layers[ i ];
-			if( null == sourceLayer.k || null == sourceLayer.v )
-				throw new ArgumentException();
+			// The caches only have extra tokens appended since that state was synced, copy back the rows overwritten by these tokens
+			Int128 cacheSize = transformer.parameters.attnCacheSize;
+			Span<(int, int)> ranges = stackalloc (int, int)[ 2 ];
+			int countRanges = rowRanges( ranges, sourceState.window, cacheSize.x * cacheSize.y, sourceState.absolute, current );
+			for( int i = 0; i < layers; i++ )
+			{
+				ModelState.LayerCache sourceLayer = sourceState.layers[ i ];
+				Attention dest = transformer.layers[ i ].attention;
+				for( int j = 0; j < countRanges; j++ )
+					dest.restoreRange( context, sourceLayer.k!, sourceLayer.v!, ranges[ j ].Item1, ranges[ j ].Item2 );
+			}
+		}
+		else
+		{
+			for( int i = 0; i < layers; i++ )
+			{
+				ModelState.LayerCache sourceLayer = sourceState.layers[ i ];
+				if( null == sourceLayer.k || null == sourceLayer.v )
+					throw new ArgumentException();
 
-			Attention dest = transformer.layers[ i ].attention;
-			dest.restore( context, sourceLayer.k, sourceLayer.v );
+				Attention dest = transformer.layers[ i ].attention;
+				dest.restore( context, sourceLayer.k, sourceLayer.v );
+			}
 		}
 
 		cacheMetadata = new RotatingCacheMetadata( sourceState.window, sourceState.absolute );
+		sourceState.synced = cacheMetadata;
+		sourceState.syncedVersion = transformer.cachesVersion;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+﻿namespace Mistral.Model;
+using Cgml;
+using System.Text;
+
+sealed partial class Model: iModel
+{
+	// "KVST" in little endian
+	const uint stateFileMagic = 0x5453564B;
+	const int stateFileVersion = 1;
+
+	void iModel.stateSave( iModelState state, Stream stream )
+	{
+		ModelState ms = (ModelState)state;
+		Parameters p = transformer.parameters;
+		int layers = transformer.layers.Length;
+		if( ms.window != p.slidingWindow || ms.layers.Length != layers )
+			throw new ArgumentException();
+
+		using( var writer = new BinaryWriter( stream, Encoding.UTF8, true ) )
+		{
+			writer.Write( stateFileMagic );
+			writer.Write( stateFileVersion );
+			writer.Write( ms.window );
+			writer.Write( layers );
+			writer.Write( p.headDim );
+			writer.Write( p.countKVHeads );
+			writer.Write( ms.absolute );
+		}
+		if( 0 == ms.absolute )
+			return;
+
+		// The circular caches only contain data in the initial rows, until the conversation exceeds the sliding window
+		int length = Math.Min( ms.absolute, ms.window ) * p.headDim * p.countKVHeads;
+		iContext context = dev.context;
+		foreach( ModelState.LayerCache layer in ms.layers )
+		{
+			if( null == layer.k || null == layer.v )
+				throw new ArgumentException();
+			context.saveCompressed( layer.k, length, stream );
+			context.saveCompressed( layer.v, length, stream );
+		}
+	}
+
+	void iModel.stateLoad( Stream stream )
+	{
+		using var rootBlock = dev.context.profilerBlock( (ushort)eProfilerBlock.BackupRestoreState );
+
+		Parameters p = transformer.parameters;
+		int layers = transformer.layers.Length;
+		int absolute;
+		using( var reader = new BinaryReader( stream, Encoding.UTF8, true ) )
+		{
+			if( reader.ReadUInt32() != stateFileMagic )
+				throw new ArgumentException( "The stream doesn't contain a saved state" );
+			int version = reader.ReadInt32();
+			if( version != stateFileVersion )
+				throw new NotSupportedException( $"Saved state version {version} is not supported" );
+			if( reader.ReadInt32() != p.slidingWindow || reader.ReadInt32() != layers ||
+				reader.ReadInt32() != p.headDim || reader.ReadInt32() != p.countKVHeads )
+				throw new ArgumentException( "The saved state was made by a different model" );
+			absolute = reader.ReadInt32();
+			if( absolute < 0 )
+				throw new ArgumentException();
+		}
+
+		if( 0 == absolute )
+		{
+			resetState();
+			return;
+		}
+
+		if( firstGenerate )
+		{
+			Context ctx = transformer.context( dev, performanceParams, kernelWork );
+			transformer.prepareCaches( ctx );
+			firstGenerate = false;
+		}
+
+		int length = Math.Min( absolute, p.slidingWindow ) * p.headDim * p.countKVHeads;
+		iContext context = dev.context;
+		foreach( var layer in transformer.layers )
+			layer.attention.loadCaches( context, stream, length );
+
+		cacheMetadata = new RotatingCacheMetadata( p.slidingWindow, absolute );
+	}
+}
\ No newline at end of file
@@ -20,14 +20,62 @@ sealed class ModelState: iModelState
 	[DataMember]
 	public LayerCache[] layers;
 
+	/// <summary>Metadata of the K/V caches at the time of the last backup or restore; the object identity tracks the history of these caches</summary>
+	[IgnoreDataMember]
+	internal RotatingCacheMetadata? synced;
+	/// <summary>Value of <see cref="Transformer.cachesVersion" /> at the time of the last backup or restore</summary>
+	[IgnoreDataMember]
+	internal int syncedVersion;
+
+	/// <summary>Context which signalled the fence; polling it is not thread safe, see the remarks of <see cref="iModelState" /></summary>
+	[IgnoreDataMember]
+	iContext? fenceContext;
+	[IgnoreDataMember]
+	ulong fence;
+
 	public ModelState( int window, int countLayers )
 	{
 		this.window = window;
 		layers = new LayerCache[ countLayers ];
+		for( int i = 0; i < countLayers; i++ )
+			layers[ i ] = new LayerCache();
+	}
+
+	/// <summary>True when the rows [ 0 .. absolute ) of these tensors match the K/V caches described by the metadata</summary>
+	internal bool isSynced( RotatingCacheMetadata metadata, int cachesVersion ) =>
+		ReferenceEquals( synced, metadata ) && syncedVersion == cachesVersion;
+
+	internal void setFence( iContext context, ulong id )
+	{
+		fenceContext = context;
+		fence = id;
+	}
+
+	public bool isComplete
+	{
+		get
+		{
+			if( null == fenceContext )
+				return true;
+			if( !fenceContext.fenceComplete( fence ) )
+				return false;
+			fenceContext = null;
+			return true;
+		}
+	}
+
+	public void wait()
+	{
+		if( null == fenceContext )
+			return;
+		fenceContext.fenceWait( fence );
+		fenceContext = null;
 	}
 
 	void IDisposable.Dispose()
 	{
+		synced = null;
+		fenceContext = null;
 		foreach( var layer in layers )
 		{
 			layer.k?.Dispose();
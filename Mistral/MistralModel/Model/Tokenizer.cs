@@ -54,6 +54,10 @@ sealed class Tokenizer: IDisposable, iTokenizer
 	public string decode( ReadOnlySpan<int> tokens ) =>
 		model.decode( tokens );
 
+	/// <summary>Create a decoder which accepts one token at a time</summary>
+	public iStreamingDecoder createStreamingDecoder() =>
+		model.createStreamingDecoder();
+
 	public void Dispose()
 	{
 		model?.Dispose();
@@ -179,33 +179,47 @@ sealed class Attention: IDisposable
 		return res;
 	}
 
-	public void backup( iContext context, iTensor k, iTensor v )
+	public void restore( iContext context, iTensor k, iTensor v )
 	{
 		if( null != cacheK?.native )
-			context.copy( k, cacheK.native );
-		else
-			context.writeDenseZeros( k, k.getSize() );
+			context.copy( cacheK.native, k );
 
 		if( null != cacheV?.native )
-			context.copy( v, cacheV.native );
-		else
-			context.writeDenseZeros( v, v.getSize() );
+			context.copy( cacheV.native, v );
 	}
 
-	public void restore( iContext context, iTensor k, iTensor v )
+	/// <summary>Copy a range of elements from the caches into the backup tensors</summary>
+	public void backupRange( iContext context, iTensor k, iTensor v, int begin, int end )
 	{
 		if( null != cacheK?.native )
-			context.copy( cacheK.native, k );
+			context.copyRange( k, cacheK.native, begin, end );
+		if( null != cacheV?.native )
+			context.copyRange( v, cacheV.native, begin, end );
+	}
 
+	/// <summary>Copy a range of elements from the backup tensors into the caches</summary>
+	public void restoreRange( iContext context, iTensor k, iTensor v, int begin, int end )
+	{
+		if( null != cacheK?.native )
+			context.copyRange( cacheK.native, k, begin, end );
 		if( null != cacheV?.native )
-			context.copy( cacheV.native, v );
+			context.copyRange( cacheV.native, v, begin, end );
+	}
+
+	/// <summary>Load initial <c>length</c> elements of both caches from the stream written by <see cref="iContext.saveCompressed" /></summary>
+	public void loadCaches( iContext context, Stream stream, int length )
+	{
+		if( null == cacheK?.native || null == cacheV?.native )
+			throw new ApplicationException( "The attention caches were not created" );
+		context.loadCompressed( cacheK.native, length, stream );
+		context.loadCompressed( cacheV.native, length, stream );
 	}
 
-	public void clear( iContext context )
+	public void clear( iContext context, KernelWork work )
 	{
 		if( null != cacheK?.native )
-			context.writeDenseZeros( cacheK.native, cacheK.size );
+			context.writeDenseZeros( cacheK.native, cacheK.size, work );
 		if( null != cacheV?.native )
-			context.writeDenseZeros( cacheV.native, cacheV.size );
+			context.writeDenseZeros( cacheV.native, cacheV.size, work );
 	}
 }
\ No newline at end of file
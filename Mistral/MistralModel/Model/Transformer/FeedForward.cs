@@ -19,9 +19,8 @@ sealed class FeedForward: IDisposable
 
 	public Tensor forward( in Context ctx, Tensor x )
 	{
-		Tensor tmp = ctx.columnProduct( x, w1, ref ctx.temp.ff1 );
-		Tensor tmp2 = ctx.columnProduct( x, w3, ref ctx.temp.ff2 );
-		ctx.SiLU( tmp, tmp2 );
+		// silu( w1( x ) ) * w3( x )
+		Tensor tmp = ctx.columnProductSwiGLU( x, w1, w3, ref ctx.temp.ff1, ref ctx.temp.ff2 );
 		ctx.unbindInputs();
 		tmp = ctx.columnProduct( tmp, w2, ref ctx.temp.ff2 );
 		return tmp;
@@ -6,7 +6,7 @@ using System.Runtime.Intrinsics.X86;
 using System.Runtime.Serialization;
 
 [DataContract]
-sealed class Transformer: IDisposable
+sealed partial class Transformer: IDisposable
 {
 	[DataMember]
 	internal readonly TransformerBlock[] layers;
@@ -18,6 +18,9 @@ sealed class Transformer: IDisposable
 	TemporaryTensors temp = new TemporaryTensors();
 	[IgnoreDataMember]
 	public eModelVersion modelVersion => parameters.modelVersion;
+	/// <summary>Incremented every time the attention caches are re-created, the state backups use it to detect stale snapshots</summary>
+	[IgnoreDataMember]
+	public int cachesVersion { get; private set; }
 
 	/// <summary>Construct from the original Python model</summary>
 	public Transformer( ParamsJson p, Dictionary<string, iTensor> tensors )
@@ -39,11 +42,11 @@ sealed class Transformer: IDisposable
 		parameters.afterLoadFix();
 
 	/// <summary>Initialize the context structure, which implements these ML algorithms and caches GPU buffers</summary>
-	public Context context( in Device dev, PerformanceParams perfParams )
+	public Context context( in Device dev, PerformanceParams perfParams, KernelWork work, TensorCapture? capture = null )
 	{
 		// That line is needed because DataContractSerializer doesn't call default constructors when de-serializing
 		temp ??= new TemporaryTensors();
-		return new Context( dev, temp, parameters, perfParams );
+		return new Context( dev, temp, parameters, perfParams, work, capture );
 	}
 
 	public Tensor preFill( ref Context ctx, iTensor tokens, iRotatingCacheMetadata cacheMetadata, int length )
@@ -64,14 +67,20 @@ sealed class Transformer: IDisposable
 #if DEBUG
 			ctx.prefix = $"pre-b{i}";
 #endif
+			if( null != ctx.capture )
+				ctx.capture.layer = i;
 			using var block = ctx.profilerBlock( eProfilerBlock.Layer );
 			t = layer.forward( ctx, t, cacheMetadata, mask );
 		}
 #if DEBUG
 		ctx.prefix = "pre";
 #endif
+		if( null != ctx.capture )
+			ctx.capture.layer = -1;
 		ctx.rmsNorm( t, norm );
+		ctx.dbgCompareTensor( t, "15-norm" );
 		t = ctx.columnProduct( t, output, ref temp.result );
+		ctx.dbgCompareTensor( t, "16-logits" );
 		return t;
 	}
 
@@ -101,6 +110,7 @@ sealed class Transformer: IDisposable
 
 	public void prepareCaches( in Context ctx )
 	{
+		cachesVersion++;
 		foreach( var layer in layers )
 			layer.attention.prepareCacheTensors( ctx );
 	}
@@ -0,0 +1,76 @@
+﻿namespace Mistral.Model;
+using Cgml;
+
+/// <summary>Measures the operations of the model</summary>
+/// <param name="name">Name of the operation</param>
+/// <param name="act">Dispatches the compute shaders of the operation, called multiple times</param>
+delegate void pfnMeasureKernel( string name, Action act );
+
+sealed partial class Transformer
+{
+	/// <summary>Run the operations of the first layer one by one, with the shapes of a pre-fill of the specified length</summary>
+	/// <remarks>The operations are called in the same order as in <see cref="preFill" />, because the temporary tensors alias each other.<br/>
+	/// The method destroys the content of the KV caches.</remarks>
+	public void benchmarkKernels( Context ctx, iTensor tokens, int length, pfnMeasureKernel measure )
+	{
+		TransformerBlock layer = layers[ 0 ];
+		Attention attention = layer.attention;
+		FeedForward ff = layer.feedForward;
+		TemporaryTensors temp = this.temp;
+		Parameters p = ctx.parameters;
+
+		Tensor x = null!;
+		measure( "getRows", () => x = ctx.getRows( tok_embeddings, tokens, 0, length, ref temp.inpL ) );
+
+		Tensor normalized = null!;
+		measure( "rmsNorm", () => normalized = ctx.rmsNorm( x, layer.attention_norm, ref temp.norm ) );
+
+		Tensor xq = null!, xk = null!;
+		measure( "wq", () => xq = ctx.columnProduct( normalized, attention.wq, ref temp.xq ) );
+		measure( "wk", () => xk = ctx.columnProduct( normalized, attention.wk, ref temp.xk ) );
+		measure( "wv", () => ctx.columnProduct( normalized, attention.wv, ref temp.xv ) );
+
+		xq.view( p.headDim, p.countHeads, xq.size.y, xq.size.z );
+		xk.view( p.headDim, p.countKVHeads, xk.size.y, xk.size.z );
+		measure( "rotaryEmbedding", () =>
+		{
+			if( ctx.modelVersion == eModelVersion.Instruct02 )
+				ctx.rotaryEmbedding2( xq, xk, 0, p.minusHalfDimMul, p.ropeTheta );
+			else
+				ctx.rotaryEmbedding( xq, xk, 0, p.minusHalfDimMul, p.ropeTheta );
+		} );
+
+		// Complete attention, including the projections above; every iteration starts with the empty cache
+		Tensor attnOut = null!;
+		ModelMask mask = new ModelMask( 0, length );
+		measure( "attention", () =>
+		{
+			RotatingCacheMetadata cacheMetadata = new RotatingCacheMetadata( p.slidingWindow );
+			cacheMetadata.begin( length );
+			attnOut = attention.forward( ctx, normalized, cacheMetadata, mask );
+			cacheMetadata.end( length );
+		} );
+		measure( "addInPlace", () => ctx.addInPlace( x, attnOut ) );
+
+		measure( "ffnNorm", () => normalized = ctx.rmsNorm( x, layer.ffn_norm, ref temp.norm ) );
+		Tensor ffTemp = null!;
+		measure( "swiGLU", () =>
+		{
+			ffTemp = ctx.columnProductSwiGLU( normalized, ff.w1, ff.w3, ref temp.ff1, ref temp.ff2 );
+			ctx.unbindInputs();
+		} );
+		measure( "w2", () => ctx.columnProduct( ffTemp, ff.w2, ref temp.ff2 ) );
+
+		Tensor logits = null!;
+		measure( "output", () =>
+		{
+			ctx.rmsNorm( x, norm );
+			logits = ctx.columnProduct( x, output, ref temp.result );
+			logits = ctx.trimToLastRow( logits, ref temp.logProbsTrimmed );
+		} );
+
+		measure( "sampleMax", () => ctx.sampleMax( logits ) );
+		Random rand = new Random( 0 );
+		measure( "sampleTopK", () => ctx.sampleTopK( logits, 50, rand ) );
+	}
+}
\ No newline at end of file
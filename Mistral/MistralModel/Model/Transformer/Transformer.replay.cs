@@ -0,0 +1,101 @@
+﻿namespace Mistral.Model;
+using Cgml;
+
+sealed partial class Transformer
+{
+	/// <summary>Patch the rotary embedding recorded by <see cref="Context.rotaryEmbedding" /> or <see cref="Context.rotaryEmbedding2" />, for the new position and size of the tensor</summary>
+	void patchRotary( iCommandList list, int shader, int dispatch, Tensor t, int offset, Parameters p )
+	{
+		if( modelVersion == eModelVersion.Instruct02 )
+		{
+			var cb = new ConstantBuffers.rotaryEmbedding2
+			{
+				stride = t.stride.yzw,
+				theta = p.ropeTheta,
+				minusHalfDimMul = p.minusHalfDimMul,
+				freqsOffset = offset,
+			};
+			list.patchConstants( shader, ref cb );
+		}
+		else
+		{
+			var cb = new ConstantBuffers.rotaryEmbedding
+			{
+				size = t.size,
+				stride = t.stride,
+				theta = p.ropeTheta,
+				minusHalfDimMul = p.minusHalfDimMul,
+				freqsOffset = offset,
+			};
+			list.patchConstants( shader, ref cb );
+		}
+		list.patchDispatch( dispatch, t.size.y, t.size.z, t.size.w );
+	}
+
+	/// <summary>Compute rotated Q and K of the first layer by replaying a recorded command list, then with direct calls, and compare the results</summary>
+	/// <remarks>The list is recorded for all rows at position 0.
+	/// Before the replay, the rotary embedding is patched to rotate the first half of the rows at position <c>length</c>, with <see cref="iCommandList.patchDispatch" /> and <c>patchConstants</c>.<br/>
+	/// Both ways run the same shaders on the same data, the results are expected to be bitwise equal.</remarks>
+	/// <returns>Maximum absolute difference between the two ways</returns>
+	public float checkReplay( Context ctx, iContext context, iTensor tokens, int length )
+	{
+		TransformerBlock layer = layers[ 0 ];
+		Attention attention = layer.attention;
+		Parameters p = ctx.parameters;
+		int offset = length;
+		int rows = ( length + 1 ) / 2;
+
+		Tensor x = ctx.getRows( tok_embeddings, tokens, 0, length, ref temp.inpL );
+
+		// Same operations as in the beginning of Attention.forward, the rotary embedding only applies to the first rows
+		(Tensor, Tensor) compute( int position, int rotatedRows )
+		{
+			Tensor normalized = ctx.rmsNorm( x, layer.attention_norm, ref temp.norm );
+			Tensor xq = ctx.columnProduct( normalized, attention.wq, ref temp.xq );
+			Tensor xk = ctx.columnProduct( normalized, attention.wk, ref temp.xk );
+			xq.view( p.headDim, p.countHeads, xq.size.y, xq.size.z );
+			xk.view( p.headDim, p.countKVHeads, xk.size.y, xk.size.z );
+
+			Tensor q = xq.trimmed( p.headDim, p.countHeads, rotatedRows, 1 );
+			Tensor k = xk.trimmed( p.headDim, p.countKVHeads, rotatedRows, 1 );
+			if( ctx.modelVersion == eModelVersion.Instruct02 )
+				ctx.rotaryEmbedding2( q, k, position, p.minusHalfDimMul, p.ropeTheta );
+			else
+				ctx.rotaryEmbedding( q, k, position, p.minusHalfDimMul, p.ropeTheta );
+			return (q, k);
+		}
+
+		Tensor q, k;
+		context.beginRecording();
+		try
+		{
+			(q, k) = compute( 0, length );
+		}
+		catch
+		{
+			context.endRecording().Dispose();
+			throw;
+		}
+
+		TensorData replayedQ, replayedK;
+		using( iCommandList list = context.endRecording() )
+		{
+			// The rotary embedding is recorded twice, for Q then K, with 1 dispatch each
+			eShader rotary = ( ctx.modelVersion == eModelVersion.Instruct02 ) ? eShader.rotaryEmbedding2 : eShader.rotaryEmbedding;
+			var found = list.findShader( (ushort)rotary );
+			if( found.Count != 2 || found[ 0 ].dispatch < 0 || found[ 1 ].dispatch < 0 )
+				throw new ApplicationException( $"The recorded list has {found.Count} {rotary} shaders, expected 2" );
+			patchRotary( list, found[ 0 ].shader, found[ 0 ].dispatch, q.trimmed( p.headDim, p.countHeads, rows, 1 ), offset, p );
+			patchRotary( list, found[ 1 ].shader, found[ 1 ].dispatch, k.trimmed( p.headDim, p.countKVHeads, rows, 1 ), offset, p );
+
+			context.replay( list );
+			replayedQ = context.downloadTensor( q.native );
+			replayedK = context.downloadTensor( k.native );
+		}
+
+		(q, k) = compute( offset, rows );
+		float diffQ = replayedQ.diff( context.downloadTensor( q.native ) ).maxAbsDiff;
+		float diffK = replayedK.diff( context.downloadTensor( k.native ) ).maxAbsDiff;
+		return MathF.Max( diffQ, diffK );
+	}
+}
\ No newline at end of file
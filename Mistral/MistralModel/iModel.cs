@@ -34,17 +34,77 @@ public interface iModel: IDisposable
 	/// <summary>Get profiler data from C++ backend, convert to human-readable text</summary>
 	IEnumerable<string> profilerMeasures();
 
+	/// <summary>Get p50, p90 and p99 latencies of the profiler measures, as human-readable text</summary>
+	/// <param name="reset">Reset the measures after taking the snapshot</param>
+	IEnumerable<string> profilerPercentiles( bool reset = false );
+
+	/// <summary>Achieved memory bandwidth and arithmetic throughput of the compute shaders, as human-readable text</summary>
+	/// <param name="peakBandwidth">Peak memory bandwidth of the GPU in GB/s; when both peaks are specified, the report classifies shaders as memory- or compute-bound</param>
+	/// <param name="peakGflops">Peak arithmetic throughput of the GPU in GFLOP/s</param>
+	IEnumerable<string> profilerRoofline( double peakBandwidth = 0, double peakGflops = 0 );
+
+	/// <summary>Start capturing the timeline of the profiler events, keeping the last <c>capacity</c> of them</summary>
+	/// <remarks>Zero capacity stops the capture</remarks>
+	void profilerCaptureTimeline( int capacity = 0x10000 );
+
+	/// <summary>Save the captured timeline in Chrome trace event format, viewable in <c>chrome://tracing</c> or <c>ui.perfetto.dev</c></summary>
+	void profilerSaveTimeline( string path );
+
+	/// <summary>Run pre-fill on a synthetic prompt, then generate tokens with greedy sampling, and measure the time</summary>
+	/// <remarks>The method resets the state of the model. The end-of-sequence token doesn't stop the generation.</remarks>
+	/// <param name="promptLength">Count of tokens in the prompt, including BOS</param>
+	/// <param name="generateLength">Count of tokens to generate</param>
+	GenerationTimings benchmark( int promptLength, int generateLength );
+
+	/// <summary>Run every operation of the first layer in isolation, with the shapes of a pre-fill of the specified length, and measure the compute shaders</summary>
+	/// <remarks>The method resets the state of the model, the profiler measures, and the work counters of the roofline report.<br/>
+	/// Pass length = 1 to measure the shapes of the generation phase.</remarks>
+	/// <param name="length">Count of tokens in the input, up to the sliding window size</param>
+	/// <param name="iterations">How many times to run every operation</param>
+	KernelTimings[] benchmarkKernels( int length, int iterations );
+
+	/// <summary>Memory used by the tensors, grouped by name.<br/>
+	/// The first element of the vectors is system memory, the second one is VRAM, both in bytes.</summary>
+	Dictionary<string, System.Runtime.Intrinsics.Vector128<long>> memoryUse();
+
 	/// <summary>Backup state of the model</summary>
 	/// <param name="input">Unless null, the method will replace payload data in the old object</param>
 	/// <returns>An object which keeps state of the transformer</returns>
 	iModelState stateBackup( iModelState? input );
 
+	/// <summary>Start an asynchronous backup of the model state</summary>
+	/// <remarks>When the input was produced by a previous backup of the same conversation, only the rows of the K/V caches written since that backup are copied.<br/>
+	/// The method returns as soon as the copy commands are queued. GPU commands execute in order, so the model can continue generating,
+	/// and the returned object can be passed to <see cref="stateRestore" /> immediately; use <see cref="iModelState.isComplete" /> or <see cref="iModelState.wait" />
+	/// before reading the tensors on the CPU.</remarks>
+	/// <param name="input">Unless null, the method will replace payload data in the old object</param>
+	/// <returns>An object which keeps state of the transformer</returns>
+	iModelState stateBackupAsync( iModelState? input );
+
 	/// <summary>Restore internal state of the transformer</summary>
 	/// <remarks>Pass null to reset that state</remarks>
 	void stateRestore( iModelState? state );
+
+	/// <summary>Save the state to a stream</summary>
+	/// <remarks>Only the used rows of the K/V caches are saved, compressed with LZ4</remarks>
+	void stateSave( iModelState state, Stream stream );
+
+	/// <summary>Restore internal state of the transformer from the stream written by <see cref="stateSave" /></summary>
+	/// <remarks>The data is decompressed straight into the K/V caches of the model</remarks>
+	void stateLoad( Stream stream );
 }
 
 /// <summary>Utility interface to backup/restore internal state of the model</summary>
-/// <remarks>The object includes copy of K/V caches, and not much else</remarks>
+/// <remarks>The object includes copy of K/V caches, and not much else.<br/>
+/// Same as the methods of <see cref="iModel" />, the members of this interface use the immediate context of the GPU which is not thread safe.
+/// Call them on the thread which uses the model, and never concurrently with the methods of the model.</remarks>
 public interface iModelState: IDisposable
-{ }
\ No newline at end of file
+{
+	/// <summary>True when the GPU has finished copying the data into this object</summary>
+	/// <remarks>Polls the GPU, only call on the thread which uses the model</remarks>
+	bool isComplete { get; }
+
+	/// <summary>Block the calling thread until the GPU finishes copying the data into this object</summary>
+	/// <remarks>Polls the GPU, only call on the thread which uses the model</remarks>
+	void wait();
+}
\ No newline at end of file
@@ -46,6 +46,12 @@ inline void store( RWBuffer<uint> tensor, uint idx, float f )
 	tensor[ idx ] = roundBf16Nearest( f );
 }
 
+// Round the number the same way store() does, but keep it in FP32
+inline float roundStored( float f )
+{
+	return asfloat( roundBf16Nearest( f ) << 16 );
+}
+
 #else
 
 #define Tensor Buffer<float>
@@ -107,4 +113,18 @@ inline void store( RWBuffer<float> tensor, uint idx, float f )
 {
 	tensor[ idx ] = roundFp16Nearest( f );
 }
-#endif
\ No newline at end of file
+
+// Round the number the same way store() does, but keep it in FP32
+inline float roundStored( float f )
+{
+	return roundFp16Nearest( f );
+}
+#endif
+
+inline float silu( const float v )
+{
+	// https://en.wikipedia.org/wiki/Sigmoid_function
+	const float exponent = exp( v );
+	const float sigmoid = exponent / ( exponent + 1 );
+	return v * sigmoid;
+}
\ No newline at end of file
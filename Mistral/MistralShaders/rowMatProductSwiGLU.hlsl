@@ -0,0 +1,109 @@
+// Gate and up projections of the SwiGLU feed-forward network, in a single pass:
+// silu( [ x, y, z ] * [ x, r ] ) * ( [ x, y, z ] * [ x, r ] ) = [ r, y, z ]
+// Same algorithm as rowMatProduct.hlsl, each thread computes 2 dot products sharing the row from the group shared buffer
+#include "miscUtils.hlsli"
+
+Tensor tensor : register( t0 );
+Tensor matGate : register( t1 );
+Tensor matUp : register( t2 );
+OutputTensor result : register( u0 );
+
+cbuffer Constants: register( b0 )
+{
+	uint rowLength: packoffset( c0.x );
+	uint rowsCount: packoffset( c0.y );
+	uint2 arg0Strides: packoffset( c0.z );
+	uint2 resultStrides: packoffset( c1.x );
+}
+
+#ifndef THREADS
+static const uint THREADS = 512;
+#endif
+
+groupshared float rowBuffer[ THREADS ];
+
+inline void loadRow( uint rsi, uint rdi )
+{
+	rowBuffer[ rdi ] = load( tensor, rsi );
+	GroupMemoryBarrierWithGroupSync();
+}
+
+[ numthreads( THREADS, 1, 1 ) ]
+void main( uint3 group: SV_GroupID, uint thread : SV_GroupIndex )
+{
+	uint rsiRow = dot( group.yz, arg0Strides );
+
+	const uint groupFirstRow = group.x * THREADS;
+	const uint groupCountRows = min( THREADS, rowsCount - groupFirstRow );
+	uint rsiMatrix = ( groupFirstRow + thread ) * rowLength;
+
+	const uint completeBatches = rowLength / THREADS;
+	const uint remainderBatch = rowLength % THREADS;
+
+	rsiRow += thread;
+	float accGate = 0;
+	float accUp = 0;
+	uint i;
+	for( i = 0; i < completeBatches; i++ )
+	{
+		// Load THREADS elements from first tensor into group shared buffer
+		loadRow( rsiRow, thread );
+		rsiRow += THREADS;
+
+		// Both matrices have the same shape, the same load index works for them
+		[ branch ]
+		if( thread < groupCountRows )
+		{
+			for( uint j = 0; j < THREADS; j++ )
+			{
+				float r = rowBuffer[ j ];
+				float g = load( matGate, rsiMatrix );
+				float u = load( matUp, rsiMatrix );
+				rsiMatrix++;
+				accGate = mad( r, g, accGate );
+				accUp = mad( r, u, accUp );
+			}
+		}
+
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+	[branch]
+	if( 0 != remainderBatch )
+	{
+		// We have an incomplete partial tile
+		[branch]
+		if( thread < remainderBatch )
+			rowBuffer[ thread ] = load( tensor, rsiRow );
+		GroupMemoryBarrierWithGroupSync();
+
+		[branch]
+		if( thread < groupCountRows )
+		{
+			for( uint j = 0; j < remainderBatch; j++ )
+			{
+				float r = rowBuffer[ j ];
+				float g = load( matGate, rsiMatrix );
+				float u = load( matUp, rsiMatrix );
+				rsiMatrix++;
+				accGate = mad( r, g, accGate );
+				accUp = mad( r, u, accUp );
+			}
+		}
+
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+	if( thread >= groupCountRows )
+		return;
+
+	// Round both products to the precision of the tensors,
+	// this way the result is identical to 2 separate products followed by silu.hlsl shader
+	const float gate = roundStored( accGate );
+	const float up = roundStored( accUp );
+
+	uint rdi = dot( group.yz, resultStrides );
+	rdi += groupFirstRow;
+	rdi += thread;
+	store( result, rdi, silu( gate ) * up );
+}
\ No newline at end of file
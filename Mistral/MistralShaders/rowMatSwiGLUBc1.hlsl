@@ -0,0 +1,175 @@
+// CODEGEN_IGNORE
+// Gate and up projections of the SwiGLU feed-forward network with BCML1 compressed matrices, in a single pass
+// Same algorithm as rowMatCompressedV2.hlsli, each thread decodes the same panel column from both matrices
+#define BCML_CODEC 1
+static const uint THREADS = 256;
+
+#include "miscUtils.hlsli"
+
+Tensor tensor : register( t0 );
+ByteAddressBuffer mat: register( t1 );
+ByteAddressBuffer matUp: register( t2 );
+OutputTensor result : register( u0 );
+
+cbuffer Constants: register( b0 )
+{
+	uint rowLength: packoffset( c0.x );
+	uint rowsCount: packoffset( c0.y );
+	uint2 arg0Strides: packoffset( c0.z );
+	uint2 resultStrides: packoffset( c1.x );
+	uint matrixStride: packoffset( c1.z );
+}
+
+groupshared float rowBuffer[ THREADS ];
+
+inline void loadRow( uint rsi, uint rdi )
+{
+	rowBuffer[ rdi ] = load( tensor, rsi );
+	GroupMemoryBarrierWithGroupSync();
+}
+
+// The gate matrix is bound to `mat` slot, so bcml.hlsli decodes it
+#include "bcml.hlsli"
+
+static const uint THREADS_Y = THREADS / BCML_PANEL_HEIGHT;
+
+// Both matrices have the same shape and the same compressed layout, the decoders share the load index
+struct DualDecoderState
+{
+	uint rsi;
+	float2 headerGate, headerUp;
+	uint blockGate, blockUp;
+};
+
+DualDecoderState createDualDecoderState( uint rsiMatrix )
+{
+	DualDecoderState res;
+	res.rsi = rsiMatrix;
+	res.headerGate = 0.0;
+	res.headerUp = 0.0;
+	res.blockGate = 0;
+	res.blockUp = 0;
+	return res;
+}
+
+// Accumulate dot products of the rowBuffer slice [ j .. j + 31 ] with the next blocks of both compressed matrices
+inline void computeCompressedBlocks( inout uint j, inout DualDecoderState state, inout float accGate, inout float accUp )
+{
+	state.headerGate = bcmlHeader( mat.Load( state.rsi ) );
+	state.headerUp = bcmlHeader( matUp.Load( state.rsi ) );
+	state.rsi += 4 * BCML_PANEL_HEIGHT;
+
+	for( uint i = 0; i < 4; i++ )
+	{
+		// Load 8 quantized weights from each matrix
+		state.blockGate = mat.Load( state.rsi );
+		state.blockUp = matUp.Load( state.rsi );
+		state.rsi += 4 * BCML_PANEL_HEIGHT;
+
+		[unroll]
+		for( uint k = 0; k < 8; k++ )
+		{
+			const float r = rowBuffer[ j ];
+			accGate = mad( r, bcml1Element( state.headerGate, state.blockGate ), accGate );
+			accUp = mad( r, bcml1Element( state.headerUp, state.blockUp ), accUp );
+			state.blockGate >>= 4;
+			state.blockUp >>= 4;
+			j++;
+		}
+	}
+}
+
+// Handle 1 element of an incomplete block
+inline void accumulateRemainderElements( uint j, inout DualDecoderState state, inout float accGate, inout float accUp )
+{
+	[ branch ]
+	if( 0 == ( j % 32 ) )
+	{
+		state.headerGate = bcmlHeader( mat.Load( state.rsi ) );
+		state.headerUp = bcmlHeader( matUp.Load( state.rsi ) );
+		state.rsi += 4 * BCML_PANEL_HEIGHT;
+	}
+
+	[branch]
+	if( 0 == ( j % 8 ) )
+	{
+		state.blockGate = mat.Load( state.rsi );
+		state.blockUp = matUp.Load( state.rsi );
+		state.rsi += 4 * BCML_PANEL_HEIGHT;
+	}
+
+	const float r = rowBuffer[ j ];
+	accGate = mad( r, bcml1Element( state.headerGate, state.blockGate ), accGate );
+	accUp = mad( r, bcml1Element( state.headerUp, state.blockUp ), accUp );
+	state.blockGate >>= 4;
+	state.blockUp >>= 4;
+}
+
+[numthreads( BCML_PANEL_HEIGHT, THREADS_Y, 1 )]
+void main( uint3 group: SV_GroupID, uint thread : SV_GroupIndex, uint3 thread3 : SV_GroupThreadID )
+{
+	uint rsiRow = dot( group.yz, arg0Strides );
+
+	const uint groupFirstRow = group.x * THREADS;
+	const uint groupCountRows = min( THREADS, rowsCount - groupFirstRow );
+
+	const uint idxPanel = group.x * THREADS_Y + thread3.y;
+	DualDecoderState decoder = createDualDecoderState( mad( idxPanel, matrixStride, thread3.x * 4 ) );
+
+	const uint completeBatches = rowLength / THREADS;
+	const uint remainderBatch = rowLength % THREADS;
+
+	rsiRow += thread;
+	float accGate = 0;
+	float accUp = 0;
+	for( uint i = 0; i < completeBatches; i++ )
+	{
+		loadRow( rsiRow, thread );
+		rsiRow += THREADS;
+
+		[ branch ]
+		if( thread < groupCountRows )
+		{
+			for( uint j = 0; j < THREADS; )
+				computeCompressedBlocks( j, decoder, accGate, accUp );
+		}
+
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+	[branch]
+	if( 0 != remainderBatch )
+	{
+		[branch]
+		if( thread < remainderBatch )
+			rowBuffer[ thread ] = load( tensor, rsiRow );
+		GroupMemoryBarrierWithGroupSync();
+
+		[branch]
+		if( thread < groupCountRows )
+		{
+			const uint remainderBatchAligned = roundDownToBlock( remainderBatch );
+
+			uint j = 0;
+			while( j < remainderBatchAligned )
+				computeCompressedBlocks( j, decoder, accGate, accUp );
+
+			for( ; j < remainderBatch; j++ )
+				accumulateRemainderElements( j, decoder, accGate, accUp );
+		}
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+	if( thread >= groupCountRows )
+		return;
+
+	// Round both products to the precision of the tensors,
+	// this way the result is identical to 2 separate products followed by silu.hlsl shader
+	const float gate = roundStored( accGate );
+	const float up = roundStored( accUp );
+
+	uint rdi = dot( group.yz, resultStrides );
+	rdi += groupFirstRow;
+	rdi += thread;
+	store( result, rdi, silu( gate ) * up );
+}
\ No newline at end of file
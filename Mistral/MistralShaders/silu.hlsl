@@ -14,14 +14,6 @@ cbuffer Constants: register( b0 )
 	uint3 strides: packoffset( c0.y );
 }
 
-inline float silu( const float v )
-{
-	// https://en.wikipedia.org/wiki/Sigmoid_function
-	const float exponent = exp( v );
-	const float sigmoid = exponent / ( exponent + 1 );
-	return v * sigmoid;
-}
-
 [ numthreads( THREADS, 1, 1 ) ]
 void main( uint3 group: SV_GroupID, uint thread : SV_GroupIndex )
 {
@@ -0,0 +1,99 @@
+﻿namespace Benchmarks;
+using Cgml;
+using Mistral;
+using System.Text.Json;
+
+/// <summary>Runs the same model on two backends, and prints per-layer differences of the intermediate tensors</summary>
+sealed class ConformanceRun
+{
+	string? pathReference = null, pathTest = null;
+	string? adapterReference = null, adapterTest = null;
+	string? pathResult = null;
+	int length = 64;
+	float? tolerance = null;
+
+	public const string usage = "Benchmarks conformance <reference.cgml> [<test.cgml>] [--adapter-ref <name>] [--adapter-test <name>] [--length 64] [--tolerance <maxAbsDiff>] [--out <result.json>]";
+
+	bool positional( string a )
+	{
+		if( null == pathReference )
+			pathReference = a;
+		else if( null == pathTest )
+			pathTest = a;
+		else
+			return false;
+		return true;
+	}
+
+	bool option( string name, string val )
+	{
+		switch( name )
+		{
+			case "--adapter-ref": adapterReference = val; return true;
+			case "--adapter-test": adapterTest = val; return true;
+			case "--length": length = int.Parse( val ); return true;
+			case "--tolerance": tolerance = float.Parse( val ); return true;
+			case "--out": pathResult = val; return true;
+		}
+		return false;
+	}
+
+	/// <summary>Parse command-line arguments, return null if they're invalid</summary>
+	public static ConformanceRun? parse( string[] args )
+	{
+		ConformanceRun res = new ConformanceRun();
+		if( !Options.parse( args, res.positional, res.option ) )
+			return null;
+		if( null == res.pathReference || res.length < 1 )
+			return null;
+		return res;
+	}
+
+	static void write( string path, ConformanceReport report )
+	{
+		using var stream = File.Create( path );
+		using var writer = new Utf8JsonWriter( stream, new JsonWriterOptions { Indented = true } );
+		writer.WriteStartObject();
+		writer.WriteNumber( "tokens", report.tokens );
+		writer.WriteNumber( "top1Agreement", report.top1Agreement );
+		writer.WriteNumber( "maxAbsDiff", report.maxAbsDiff );
+		writer.WriteStartArray( "tensors" );
+		foreach( var e in report.entries )
+		{
+			writer.WriteStartObject();
+			writer.WriteNumber( "layer", e.layer );
+			writer.WriteString( "name", e.name );
+			writer.WriteString( "shape", e.shape );
+			if( e.diff.HasValue )
+			{
+				TensorsDiff d = e.diff.Value;
+				writer.WriteNumber( "maxAbsDiff", d.maxAbsDiff );
+				writer.WriteNumber( "avgAbsDiff", d.avgAbsDiff );
+				writer.WriteNumber( "rms", d.rms );
+			}
+			writer.WriteEndObject();
+		}
+		writer.WriteEndArray();
+		writer.WriteEndObject();
+	}
+
+	/// <summary>Run the comparison, return false when the difference exceeds the tolerance</summary>
+	public bool run()
+	{
+		using iModel reference = ModelLoader.load( pathReference!, new sDeviceParams( adapterReference ) );
+		using iModel test = ModelLoader.load( pathTest ?? pathReference!, new sDeviceParams( adapterTest ) );
+
+		ConformanceReport report = Conformance.compare( reference, test, length );
+		foreach( string line in report.formatted() )
+			Console.WriteLine( line );
+		if( null != pathResult )
+			write( pathResult, report );
+
+		if( tolerance.HasValue && report.maxAbsDiff > tolerance.Value )
+		{
+			Console.WriteLine( "FAILED: maxAbsDiff {0} exceeds the tolerance {1}", report.maxAbsDiff, tolerance.Value );
+			return false;
+		}
+		return true;
+	}
+}
\ No newline at end of file
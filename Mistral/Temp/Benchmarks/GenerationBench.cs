@@ -0,0 +1,146 @@
+﻿namespace Benchmarks;
+using Cgml;
+using Mistral;
+using System.Runtime.Intrinsics;
+using System.Text.Json;
+
+/// <summary>End-to-end generation benchmark: loads a model, sweeps prompt and generation lengths, and writes the results as JSON</summary>
+/// <remarks>The prompts are synthetic and the sampling is greedy, the numbers are comparable between runs of the same model.<br/>
+/// To run on CPU, pass the name of the software adapter, "Microsoft Basic Render Driver".</remarks>
+sealed class GenerationBench
+{
+	string? pathModel = null;
+	string? adapter = null;
+	string? pathResult = null;
+	int[] promptLengths = new int[] { 16, 128, 512 };
+	int[] generateLengths = new int[] { 64 };
+	int warmup = 1;
+	int iterations = 5;
+
+	public const string usage = "Benchmarks generate <model.cgml> [--adapter <name>] [--prompt 16,128,512] [--gen 64] [--warmup 1] [--iterations 5] [--out <result.json>]";
+
+	bool positional( string a )
+	{
+		if( null != pathModel )
+			return false;
+		pathModel = a;
+		return true;
+	}
+
+	bool option( string name, string val )
+	{
+		switch( name )
+		{
+			case "--adapter": adapter = val; return true;
+			case "--prompt": promptLengths = Options.parseList( val ); return true;
+			case "--gen": generateLengths = Options.parseList( val ); return true;
+			case "--warmup": warmup = int.Parse( val ); return true;
+			case "--iterations": iterations = int.Parse( val ); return true;
+			case "--out": pathResult = val; return true;
+		}
+		return false;
+	}
+
+	/// <summary>Parse command-line arguments, return null if they're invalid</summary>
+	public static GenerationBench? parse( string[] args )
+	{
+		GenerationBench res = new GenerationBench();
+		if( !Options.parse( args, res.positional, res.option ) )
+			return null;
+		if( null == res.pathModel || res.iterations < 1 || res.warmup < 0 )
+			return null;
+		return res;
+	}
+
+	/// <summary>Nearest-rank percentile of the sorted array</summary>
+	static double percentile( double[] sorted, double p )
+	{
+		int rank = (int)Math.Ceiling( p * sorted.Length ) - 1;
+		return sorted[ Math.Clamp( rank, 0, sorted.Length - 1 ) ];
+	}
+
+	/// <summary>Write statistics of the values, or null when there are none</summary>
+	static void writeStats( Utf8JsonWriter writer, string name, IEnumerable<double> values )
+	{
+		double[] sorted = values.ToArray();
+		if( sorted.Length == 0 )
+		{
+			writer.WriteNull( name );
+			return;
+		}
+		Array.Sort( sorted );
+		writer.WriteStartObject( name );
+		writer.WriteNumber( "mean", sorted.Average() );
+		writer.WriteNumber( "min", sorted[ 0 ] );
+		writer.WriteNumber( "p50", percentile( sorted, 0.5 ) );
+		writer.WriteNumber( "p90", percentile( sorted, 0.9 ) );
+		writer.WriteNumber( "p99", percentile( sorted, 0.99 ) );
+		writer.WriteNumber( "max", sorted[ sorted.Length - 1 ] );
+		writer.WriteEndObject();
+	}
+
+	static void writeMemory( Utf8JsonWriter writer, Dictionary<string, Vector128<long>> dict )
+	{
+		writer.WriteStartObject( "memory" );
+		writer.WriteNumber( "ram", dict.Values.Sum( v => v.GetElement( 0 ) ) );
+		writer.WriteNumber( "vram", dict.Values.Sum( v => v.GetElement( 1 ) ) );
+		writer.WriteStartObject( "tensors" );
+		foreach( var kvp in dict.OrderByDescending( kvp => kvp.Value.GetElement( 1 ) ) )
+		{
+			writer.WriteStartArray( kvp.Key );
+			writer.WriteNumberValue( kvp.Value.GetElement( 0 ) );
+			writer.WriteNumberValue( kvp.Value.GetElement( 1 ) );
+			writer.WriteEndArray();
+		}
+		writer.WriteEndObject();
+		writer.WriteEndObject();
+	}
+
+	void runCase( iModel model, Utf8JsonWriter writer, int promptLength, int generateLength )
+	{
+		for( int i = 0; i < warmup; i++ )
+			model.benchmark( promptLength, generateLength );
+
+		GenerationTimings[] results = new GenerationTimings[ iterations ];
+		for( int i = 0; i < iterations; i++ )
+			results[ i ] = model.benchmark( promptLength, generateLength );
+
+		// Null when every iteration only generated the first token
+		double? decodeTps = results.Average( r => r.decodeTokensPerSecond );
+		string decode = decodeTps.HasValue ? $"{decodeTps.Value:F1} tokens/s" : "n/a";
+		Logger.Info( $"prompt {promptLength}, generate {generateLength}: TTFT {results.Average( r => r.timeToFirstToken.TotalMilliseconds ):F1} ms, " +
+			$"pre-fill {results.Average( r => r.prefillTokensPerSecond ):F1} tokens/s, decode {decode}" );
+
+		writer.WriteStartObject();
+		writer.WriteNumber( "promptTokens", promptLength );
+		writer.WriteNumber( "generatedTokens", generateLength );
+		writer.WriteNumber( "iterations", iterations );
+		writeStats( writer, "ttftMs", results.Select( r => r.timeToFirstToken.TotalMilliseconds ) );
+		writeStats( writer, "prefillTokensPerSecond", results.Select( r => r.prefillTokensPerSecond ) );
+		writeStats( writer, "decodeTokensPerSecond", results.Select( r => r.decodeTokensPerSecond ).OfType<double>() );
+		writeStats( writer, "tokenLatencyMs", results.SelectMany( r => r.tokenLatencies ).Select( t => t.TotalMilliseconds ) );
+		writeMemory( writer, model.memoryUse() );
+		writer.WriteEndObject();
+	}
+
+	public void run()
+	{
+		using iModel model = ModelLoader.load( pathModel!, new sDeviceParams( adapter ) );
+
+		Stream stream = null == pathResult ? Console.OpenStandardOutput() : File.Create( pathResult );
+		using( stream )
+		{
+			using var writer = new Utf8JsonWriter( stream, new JsonWriterOptions { Indented = true } );
+			writer.WriteStartObject();
+			writer.WriteString( "model", Path.GetFileName( pathModel ) );
+			writer.WriteString( "adapter", adapter ?? "default" );
+			writer.WriteNumber( "warmup", warmup );
+			writer.WriteStartArray( "results" );
+			foreach( int promptLength in promptLengths )
+				foreach( int generateLength in generateLengths )
+					runCase( model, writer, promptLength, generateLength );
+			writer.WriteEndArray();
+			writer.WriteEndObject();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+﻿namespace Benchmarks;
+using Cgml;
+using System.Runtime.InteropServices;
+using Torch;
+
+/// <summary>Verifies the AVX2 reshape of GPTQ tensors in the native library against the managed implementation</summary>
+/// <remarks>Both versions must produce identical panels, for heights which are and are not multiples of the 64-row panels</remarks>
+static class GptqReshapeTest
+{
+	public const string usage = "Benchmarks gptq [--seed 0]";
+
+	/// <summary>Count of rows, and row length of the tested matrices</summary>
+	/// <remarks>The row length is a multiple of the 128-element quantization groups.<br/>
+	/// 2304 and 1152 are not multiples of 1024, the last column of zero points is incomplete.<br/>
+	/// 384 has an odd count of groups, the last column of BCML4 scales only contains one of them.</remarks>
+	static readonly (int rows, int width)[] shapes = new (int, int)[]
+	{
+		( 64, 1024 ),
+		( 4096, 4096 ),
+		( 1, 128 ),
+		( 100, 384 ),
+		( 200, 2304 ),
+		( 4100, 1152 ),
+	};
+
+	static T[] random<T>( Random rand, int length ) where T : unmanaged
+	{
+		T[] result = new T[ length ];
+		rand.NextBytes( MemoryMarshal.AsBytes( result.AsSpan() ) );
+		return result;
+	}
+
+	static bool compare( string codec, int rows, int width, ReadOnlySpan<uint> managed, ReadOnlySpan<uint> native )
+	{
+		if( managed.SequenceEqual( native ) )
+		{
+			Console.WriteLine( "{0} [ {1}, {2} ]: identical, {3:N0} elements", codec, width, rows, managed.Length );
+			return true;
+		}
+
+		int i = 0;
+		while( managed[ i ] == native[ i ] )
+			i++;
+		Console.WriteLine( "{0} [ {1}, {2} ]: FAILED, element {3}: 0x{4:X8} managed, 0x{5:X8} native", codec, width, rows, i, managed[ i ], native[ i ] );
+		return false;
+	}
+
+	static bool test( iDevice device, Random rand, int rows, int width )
+	{
+		int rowLengthIntegers = width / 8;
+		int groups = width / 128;
+		uint zerosStride = (uint)( ( rows + 7 ) / 8 );
+
+		// Random bits are fine for the scales, both versions copy them without looking at the values
+		uint[] qweight = random<uint>( rand, rows * rowLengthIntegers );
+		uint[] qzeros = random<uint>( rand, (int)zerosStride * groups );
+		float[] scales32 = random<float>( rand, rows * groups );
+		ushort[] scales16 = random<ushort>( rand, rows * groups );
+
+		uint2 sizeWeights = new uint2( (uint)rows, (uint)rowLengthIntegers );
+		uint2 sizeScales = new uint2( (uint)rows, (uint)groups );
+		uint2 sizeZeros = new uint2( zerosStride, (uint)groups );
+		Int128 size = new Int128( width, rows, 1, 1 );
+
+		// The native output starts with garbage, to catch the elements it doesn't write
+		uint[] managed = new uint[ Bcml3.tensorByteWidth( size ) / 4 ];
+		uint[] native = new uint[ managed.Length ];
+		native.AsSpan().Fill( 0xCDCDCDCD );
+		Bcml3.reshape( managed, new MatrixView<uint>( qweight, sizeWeights ), new MatrixView<float>( scales32, sizeScales ), new MatrixView<uint>( qzeros, sizeZeros ) );
+		Bcml3.reshape( device, native, new MatrixView<uint>( qweight, sizeWeights ), new MatrixView<float>( scales32, sizeScales ), new MatrixView<uint>( qzeros, sizeZeros ) );
+		bool ok = compare( "BCML3", rows, width, managed, native );
+
+		managed = new uint[ Bcml4.tensorByteWidth( size ) / 4 ];
+		native = new uint[ managed.Length ];
+		native.AsSpan().Fill( 0xCDCDCDCD );
+		Bcml4.reshape( managed, new MatrixView<uint>( qweight, sizeWeights ), new MatrixView<ushort>( scales16, sizeScales ), new MatrixView<uint>( qzeros, sizeZeros ), default );
+		Bcml4.reshape( device, native, new MatrixView<uint>( qweight, sizeWeights ), new MatrixView<ushort>( scales16, sizeScales ), new MatrixView<uint>( qzeros, sizeZeros ) );
+		return compare( "BCML4", rows, width, managed, native ) && ok;
+	}
+
+	/// <summary>Parse command-line arguments and run the test; return null if the arguments are invalid, otherwise true when all outputs are identical</summary>
+	public static bool? run( string[] args )
+	{
+		int seed = 0;
+		for( int i = 1; i < args.Length; i++ )
+		{
+			if( args[ i ] == "--seed" && i + 1 < args.Length && int.TryParse( args[ i + 1 ], out seed ) )
+			{
+				i++;
+				continue;
+			}
+			Console.WriteLine( "Unknown argument \"{0}\"", args[ i ] );
+			return null;
+		}
+
+		using Device dev = Library.createDevice( new sDeviceParams() );
+		Random rand = new Random( seed );
+		bool ok = true;
+		foreach( var (rows, width) in shapes )
+			ok = test( dev.device, rand, rows, width ) && ok;
+		return ok;
+	}
+}
\ No newline at end of file
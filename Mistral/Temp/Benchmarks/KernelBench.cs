@@ -0,0 +1,109 @@
+﻿namespace Benchmarks;
+using Cgml;
+using Mistral;
+using System.Text.Json;
+
+/// <summary>Microbenchmarks of the individual compute shaders, on the shapes of a real or synthetic model</summary>
+/// <remarks>Every operation of the model runs in isolation, with the shapes of pre-fill for every requested length; length 1 is the generation phase.<br/>
+/// Pass <c>--adapter</c> several times to compare GPUs, or the software "Microsoft Basic Render Driver" which runs on CPU.</remarks>
+sealed class KernelBench
+{
+	string? pathModel = null;
+	readonly List<string?> adapters = new List<string?>();
+	string? pathResult = null;
+	int[] lengths = new int[] { 1, 16, 128, 512 };
+	int iterations = 20;
+
+	public const string usage = "Benchmarks kernels <model.cgml> [--adapter <name>]... [--lengths 1,16,128,512] [--iterations 20] [--out <result.json>]";
+
+	bool positional( string a )
+	{
+		if( null != pathModel )
+			return false;
+		pathModel = a;
+		return true;
+	}
+
+	bool option( string name, string val )
+	{
+		switch( name )
+		{
+			case "--adapter": adapters.Add( val ); return true;
+			case "--lengths": lengths = Options.parseList( val ); return true;
+			case "--iterations": iterations = int.Parse( val ); return true;
+			case "--out": pathResult = val; return true;
+		}
+		return false;
+	}
+
+	/// <summary>Parse command-line arguments, return null if they're invalid</summary>
+	public static KernelBench? parse( string[] args )
+	{
+		KernelBench res = new KernelBench();
+		if( !Options.parse( args, res.positional, res.option ) )
+			return null;
+		if( null == res.pathModel || res.iterations < 1 || res.lengths.Length == 0 )
+			return null;
+		if( res.adapters.Count == 0 )
+			res.adapters.Add( null );
+		return res;
+	}
+
+	static void print( KernelTimings kt )
+	{
+		Console.WriteLine( "{0,-16} {1,5} {2,-24} {3,12:N0} ns {4,10:N0} p50 {5,10:N0} p99 {6,8:F1} GB/s {7,8:F1} GFLOP/s",
+			kt.operation, kt.length, kt.shader, kt.nanoseconds,
+			kt.percentiles[ 0 ].Ticks * 100.0, kt.percentiles[ 2 ].Ticks * 100.0,
+			kt.gigabytesPerSecond, kt.gigaflops );
+	}
+
+	static void write( Utf8JsonWriter writer, KernelTimings kt )
+	{
+		writer.WriteStartObject();
+		writer.WriteString( "operation", kt.operation );
+		writer.WriteNumber( "length", kt.length );
+		writer.WriteString( "shader", kt.shader );
+		writer.WriteNumber( "calls", kt.calls );
+		writer.WriteNumber( "ns", kt.nanoseconds );
+		writer.WriteNumber( "p50ns", kt.percentiles[ 0 ].Ticks * 100.0 );
+		writer.WriteNumber( "p90ns", kt.percentiles[ 1 ].Ticks * 100.0 );
+		writer.WriteNumber( "p99ns", kt.percentiles[ 2 ].Ticks * 100.0 );
+		writer.WriteNumber( "bytes", kt.bytes );
+		writer.WriteNumber( "flops", kt.flops );
+		writer.WriteNumber( "gbps", kt.gigabytesPerSecond );
+		writer.WriteNumber( "gflops", kt.gigaflops );
+		writer.WriteEndObject();
+	}
+
+	public void run()
+	{
+		using Stream? stream = null == pathResult ? null : File.Create( pathResult );
+		using Utf8JsonWriter? writer = null == stream ? null : new Utf8JsonWriter( stream, new JsonWriterOptions { Indented = true } );
+		writer?.WriteStartObject();
+		writer?.WriteString( "model", Path.GetFileName( pathModel ) );
+		writer?.WriteStartArray( "adapters" );
+
+		foreach( string? adapter in adapters )
+		{
+			using iModel model = ModelLoader.load( pathModel!, new sDeviceParams( adapter ) );
+			Console.WriteLine( "Adapter: {0}", adapter ?? "default" );
+			writer?.WriteStartObject();
+			writer?.WriteString( "adapter", adapter ?? "default" );
+			writer?.WriteStartArray( "kernels" );
+			foreach( int length in lengths )
+			{
+				foreach( KernelTimings kt in model.benchmarkKernels( length, iterations ) )
+				{
+					print( kt );
+					if( null != writer )
+						write( writer, kt );
+				}
+			}
+			writer?.WriteEndArray();
+			writer?.WriteEndObject();
+		}
+
+		writer?.WriteEndArray();
+		writer?.WriteEndObject();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+﻿namespace Benchmarks;
+
+/// <summary>Parser of the command-line arguments shared by the benchmarks: positional arguments, and options with a value in the <c>--name value</c> form</summary>
+static class Options
+{
+	/// <summary>Parse the arguments which follow the command name</summary>
+	/// <param name="args">Complete command line, the first element is the command</param>
+	/// <param name="positional">Called for every argument which doesn't start with "--", returns false when the argument is unexpected</param>
+	/// <param name="option">Called with the name and the value of every option, returns false for unknown names</param>
+	/// <returns>False if the arguments are invalid</returns>
+	public static bool parse( string[] args, Func<string, bool> positional, Func<string, string, bool> option )
+	{
+		for( int i = 1; i < args.Length; i++ )
+		{
+			string a = args[ i ];
+			if( !a.StartsWith( "--" ) )
+			{
+				if( !positional( a ) )
+					return false;
+				continue;
+			}
+			if( i + 1 >= args.Length )
+				return false;
+			if( !option( a, args[ ++i ] ) )
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>Parse comma-separated list of integers</summary>
+	public static int[] parseList( string s ) =>
+		s.Split( ',', StringSplitOptions.RemoveEmptyEntries | StringSplitOptions.TrimEntries )
+		.Select( int.Parse )
+		.ToArray();
+}
\ No newline at end of file
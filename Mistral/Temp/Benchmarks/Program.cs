@@ -0,0 +1,92 @@
+﻿namespace Benchmarks;
+using Cgml;
+
+static class Program
+{
+	static void printUsage()
+	{
+		Console.WriteLine( "Usage: Benchmarks tokenizer <tokenizer.model> <corpus.txt>" );
+		Console.WriteLine( "       " + TokenizerTest.usage );
+		Console.WriteLine( "       " + GenerationBench.usage );
+		Console.WriteLine( "       " + SyntheticGen.usage );
+		Console.WriteLine( "       " + KernelBench.usage );
+		Console.WriteLine( "       " + ConformanceRun.usage );
+		Console.WriteLine( "       " + GptqReshapeTest.usage );
+		Console.WriteLine( "       " + ReplayTest.usage );
+	}
+
+	static void mainImpl( string[] args )
+	{
+		if( args.Length < 1 )
+		{
+			printUsage();
+			return;
+		}
+
+		ConsoleLogger.setup( eLogLevel.Info, eLoggerFlags.SkipFormatMessage );
+		switch( args[ 0 ].ToLowerInvariant() )
+		{
+			case "tokenizer":
+				if( args.Length != 3 )
+					break;
+				TokenizerBench.run( args[ 1 ], args[ 2 ] );
+				return;
+			case "tokenizer-test":
+				if( args.Length != 2 && args.Length != 3 )
+					break;
+				if( !TokenizerTest.run( args[ 1 ], args.Length == 3 ? args[ 2 ] : null ) )
+					Environment.ExitCode = 1;
+				return;
+			case "generate":
+				GenerationBench? gb = GenerationBench.parse( args );
+				if( null == gb )
+					break;
+				gb.run();
+				return;
+			case "kernels":
+				KernelBench? kb = KernelBench.parse( args );
+				if( null == kb )
+					break;
+				kb.run();
+				return;
+			case "synthetic":
+				if( !SyntheticGen.run( args ) )
+					break;
+				return;
+			case "conformance":
+				ConformanceRun? cr = ConformanceRun.parse( args );
+				if( null == cr )
+					break;
+				if( !cr.run() )
+					Environment.ExitCode = 1;
+				return;
+			case "gptq":
+				bool? identical = GptqReshapeTest.run( args );
+				if( null == identical )
+					break;
+				if( !identical.Value )
+					Environment.ExitCode = 1;
+				return;
+			case "replay":
+				bool? replayed = ReplayTest.run( args );
+				if( null == replayed )
+					break;
+				if( !replayed.Value )
+					Environment.ExitCode = 1;
+				return;
+		}
+		printUsage();
+	}
+
+	static void Main( string[] args )
+	{
+		try
+		{
+			mainImpl( args );
+		}
+		catch( Exception e )
+		{
+			Console.WriteLine( e.ToString() );
+		}
+	}
+}
\ No newline at end of file
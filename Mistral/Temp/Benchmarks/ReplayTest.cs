@@ -0,0 +1,49 @@
+﻿namespace Benchmarks;
+using Cgml;
+using Mistral;
+
+/// <summary>Verifies the replays of recorded command lists against direct calls of the same shaders</summary>
+/// <remarks>The list is recorded for the first layer of the model, the rotary embeddings are patched to another position and size before the replay.<br/>
+/// Both ways run the same shaders on the same data, the test fails unless the results are bitwise equal.</remarks>
+static class ReplayTest
+{
+	public const string usage = "Benchmarks replay <model.cgml> [--adapter <name>] [--length 64]";
+
+	/// <summary>Run the test, return null if the arguments are invalid</summary>
+	public static bool? run( string[] args )
+	{
+		string? path = null;
+		string? adapter = null;
+		int length = 64;
+		bool positional( string a )
+		{
+			if( null != path )
+				return false;
+			path = a;
+			return true;
+		}
+		bool option( string name, string val )
+		{
+			switch( name )
+			{
+				case "--adapter": adapter = val; return true;
+				case "--length": length = int.Parse( val ); return true;
+			}
+			return false;
+		}
+		if( !Options.parse( args, positional, option ) )
+			return null;
+		if( null == path || length < 2 )
+			return null;
+
+		using iModel model = ModelLoader.load( path, new sDeviceParams( adapter ) );
+		float diff = Conformance.checkReplay( model, length );
+		if( diff == 0 )
+		{
+			Console.WriteLine( "Replayed command list: identical results, {0} tokens", length );
+			return true;
+		}
+		Console.WriteLine( "Replayed command list: FAILED, maxAbsDiff {0}", diff );
+		return false;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+﻿namespace Benchmarks;
+using Cgml;
+using Mistral;
+
+/// <summary>Writes a randomly initialized model, to benchmark things without the real weights</summary>
+/// <remarks>When the output path ends with <c>.cgml</c>, the model is created on GPU and saved in CGML format.<br/>
+/// Otherwise the output is a directory in Hugging Face format, which can be imported with <see cref="ModelLoader.importTorch" /><br/>
+/// With <c>--smoke</c> argument instead of the path, the model is created in VRAM and runs a short pre-fill and decode.</remarks>
+static class SyntheticGen
+{
+	public const string usage = "Benchmarks synthetic <model.cgml | directory | --smoke> [--7b] [--dim 512] [--layers 2] [--heads 4] [--kv-heads 1] [--hidden 1536] [--vocab 1024] [--window 512] [--seed 0] [--bcml1] [--adapter <name>]";
+
+	/// <summary>Create the model in VRAM, and generate a few tokens to verify the compute shaders work with these dimensions</summary>
+	static void smokeTest( SyntheticModel sm, string? adapter, eTensorLayout compression )
+	{
+		using iModel model = ModelLoader.createSynthetic( sm, new sDeviceParams( adapter ), compression );
+		GenerationTimings gt = model.benchmark( 16, 16 );
+		Logger.Info( $"Synthetic model: pre-fill {gt.prefillTokensPerSecond:F1} tokens/s, decode {gt.decodeTokensPerSecond ?? 0:F1} tokens/s" );
+	}
+
+	/// <summary>Parse command-line arguments and write the model, return false if the arguments are invalid</summary>
+	public static bool run( string[] args )
+	{
+		string? path = null;
+		string? adapter = null;
+		eTensorLayout compression = eTensorLayout.Dense;
+		bool smoke = false;
+		SyntheticModel sm = new SyntheticModel();
+		for( int i = 1; i < args.Length; i++ )
+		{
+			string a = args[ i ];
+			switch( a )
+			{
+				case "--7b":
+					sm = SyntheticModel.mistral7B;
+					continue;
+				case "--bcml1":
+					compression = eTensorLayout.BCML1;
+					continue;
+				case "--smoke":
+					smoke = true;
+					continue;
+			}
+			if( !a.StartsWith( "--" ) )
+			{
+				if( null != path )
+					return false;
+				path = a;
+				continue;
+			}
+			if( i + 1 >= args.Length )
+				return false;
+			string val = args[ ++i ];
+			if( a == "--adapter" )
+			{
+				adapter = val;
+				continue;
+			}
+			int v = int.Parse( val );
+			switch( a )
+			{
+				case "--dim": sm = sm with { dim = v }; break;
+				case "--layers": sm = sm with { layers = v }; break;
+				case "--heads": sm = sm with { heads = v }; break;
+				case "--kv-heads": sm = sm with { kvHeads = v }; break;
+				case "--hidden": sm = sm with { hiddenDim = v }; break;
+				case "--vocab": sm = sm with { vocabSize = v }; break;
+				case "--window": sm = sm with { slidingWindow = v }; break;
+				case "--seed": sm = sm with { seed = v }; break;
+				default: return false;
+			}
+		}
+		if( smoke )
+		{
+			if( null != path )
+				return false;
+			smokeTest( sm, adapter, compression );
+			return true;
+		}
+		if( null == path )
+			return false;
+
+		if( path.EndsWith( ".cgml", StringComparison.OrdinalIgnoreCase ) )
+			ModelLoader.writeSyntheticCgml( sm, path, new sDeviceParams( adapter ), compression );
+		else
+		{
+			if( compression != eTensorLayout.Dense )
+				Logger.Warning( "--bcml1 is ignored, the compression is applied when importing the model" );
+			ModelLoader.writeSyntheticTorch( sm, path );
+		}
+		return true;
+	}
+}
\ No newline at end of file
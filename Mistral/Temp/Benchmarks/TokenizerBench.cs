@@ -0,0 +1,86 @@
+﻿namespace Benchmarks;
+using Cgml;
+using SentencePiece;
+using System.Diagnostics;
+using System.Text;
+
+/// <summary>Measures throughput of the SentencePiece tokenizer over a corpus of text</summary>
+/// <remarks>Every line of the corpus file is a separate input string, empty lines are skipped.</remarks>
+static class TokenizerBench
+{
+	/// <summary>Each benchmark runs that many times, and prints the fastest pass</summary>
+	const int passes = 5;
+
+	static TimeSpan measure( Action act )
+	{
+		// The first call warms up caches and the JIT, it is not measured
+		act();
+		TimeSpan best = TimeSpan.MaxValue;
+		for( int i = 0; i < passes; i++ )
+		{
+			Stopwatch sw = Stopwatch.StartNew();
+			act();
+			TimeSpan elapsed = sw.Elapsed;
+			if( elapsed < best )
+				best = elapsed;
+		}
+		return best;
+	}
+
+	static void print( string what, TimeSpan elapsed, long bytes, long tokens )
+	{
+		double sec = elapsed.TotalSeconds;
+		double mbps = bytes / ( sec * 1024 * 1024 );
+		double tps = tokens / sec;
+		Console.WriteLine( "{0,-14} {1,10:F1} ms {2,10:F1} MB/s {3,14:N0} tokens/s", what, elapsed.TotalMilliseconds, mbps, tps );
+	}
+
+	internal static iProcessor loadModel( in Device dev, string path )
+	{
+		using var stream = File.OpenRead( path );
+		return dev.device.loadSentencePieceModel( stream, checked((int)stream.Length) );
+	}
+
+	public static void run( string pathModel, string pathCorpus )
+	{
+		string[] lines = File.ReadAllLines( pathCorpus, Encoding.UTF8 )
+			.Where( s => s.Length > 0 )
+			.ToArray();
+		if( lines.Length <= 0 )
+			throw new ArgumentException( "The corpus is empty" );
+		long bytes = lines.Sum( s => (long)Encoding.UTF8.GetByteCount( s ) );
+
+		using Device dev = Library.createDevice( new sDeviceParams() );
+		using iProcessor processor = loadModel( dev, pathModel );
+
+		int[][] encoded = new int[ lines.Length ][];
+		for( int i = 0; i < lines.Length; i++ )
+			encoded[ i ] = processor.encode( lines[ i ] ).ToArray();
+		long tokens = encoded.Sum( a => (long)a.Length );
+		Console.WriteLine( "Corpus: {0:N0} lines, {1:N0} bytes, {2:N0} tokens", lines.Length, bytes, tokens );
+
+		TimeSpan ts = measure( () =>
+		{
+			foreach( string s in lines )
+				processor.encode( s );
+		} );
+		print( "encode", ts, bytes, tokens );
+
+		ts = measure( () =>
+		{
+			foreach( int[] arr in encoded )
+				processor.decode( arr );
+		} );
+		print( "decode", ts, bytes, tokens );
+
+		int[] flat = processor.encodeBatch( lines, out int[] offsets );
+		if( flat.Length != tokens )
+			throw new ApplicationException( $"encodeBatch produced {flat.Length} tokens, expected {tokens}" );
+
+		ts = measure( () => processor.encodeBatch( lines, out int[] _ ) );
+		print( "encodeBatch", ts, bytes, tokens );
+
+		ts = measure( () => processor.decodeBatch( flat, offsets ) );
+		print( "decodeBatch", ts, bytes, tokens );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+﻿namespace Benchmarks;
+using Cgml;
+using SentencePiece;
+using System.Text;
+
+/// <summary>Verifies the fast path of the identity normalizer produces the same tokens as the generic normalizer</summary>
+/// <remarks>Encodes a built-in corpus, random strings, and optionally every line of a corpus file, with both normalizers.</remarks>
+static class TokenizerTest
+{
+	public const string usage = "Benchmarks tokenizer-test <tokenizer.model> [corpus.txt]";
+
+	/// <summary>The fast path copies 16 bytes at a time, these strings put spaces and non-ASCII characters around the vector boundaries</summary>
+	static readonly string[] builtIn = new string[]
+	{
+		"Hello, world!",
+		" leading space",
+		"trailing spaces   ",
+		"   ",
+		"a    b\t\tc\n\nd\r\ne",
+		"Multiple  spaces   between    words,\tand\ttabs\t\tin a line longer than 16 bytes",
+		"0123456789abcde",
+		"0123456789abcdef",
+		"0123456789abcdefg",
+		"0123456789abcde ",
+		"0123456789abcdef ",
+		"0123456789abcdeé",
+		"0123456789abcdefé",
+		"Füße über die Straße, naïve café",
+		"Привет, мир! Как дела?",
+		"日本語のテキストを正しく分割する",
+		"مرحبا بالعالم",
+		"“Quotes” — dashes … and non-breaking spaces",
+		"Emoji 🙂🚀 and rare CJK 𠜎𠜱 use byte fallback",
+		"a🙂b c😀  d\u0001\u0007e",
+		"▁ the meta symbol in the input ▁▁",
+	};
+
+	/// <summary>Characters for the random strings: ASCII, whitespace, 2-byte, 3-byte, and 4-byte UTF-8</summary>
+	static readonly string[] alphabet = new string[]
+	{
+		"a", "Z", "7", ".", " ", " ", " ", "\t", "\n",
+		"é", "ß", "ж", "€", "語", " ", "▁", "🙂", "𠜎", "\u0001",
+	};
+
+	static IEnumerable<string> randomStrings( int count, int seed )
+	{
+		Random rand = new Random( seed );
+		StringBuilder sb = new StringBuilder();
+		for( int i = 0; i < count; i++ )
+		{
+			sb.Clear();
+			int length = rand.Next( 1, 80 );
+			for( int j = 0; j < length; j++ )
+			{
+				// Runs of ASCII letters, to make some vectors entirely plain
+				if( rand.Next( 3 ) == 0 )
+					sb.Append( 'x', rand.Next( 1, 20 ) );
+				else
+					sb.Append( alphabet[ rand.Next( alphabet.Length ) ] );
+			}
+			yield return sb.ToString();
+		}
+	}
+
+	static int[][] encode( iProcessor processor, string[] lines, bool fastPath )
+	{
+		processor.setNormalizerFastPath( fastPath );
+		return lines.Select( s => processor.encode( s ).ToArray() ).ToArray();
+	}
+
+	static string print( int[] tokens ) =>
+		string.Join( ", ", tokens );
+
+	/// <summary>Encode the strings with both normalizers, return true when all the tokens are identical</summary>
+	public static bool run( string pathModel, string? pathCorpus )
+	{
+		IEnumerable<string> corpus = builtIn.Concat( randomStrings( 1000, 0 ) );
+		if( null != pathCorpus )
+			corpus = corpus.Concat( File.ReadAllLines( pathCorpus, Encoding.UTF8 ).Where( s => s.Length > 0 ) );
+		string[] lines = corpus.ToArray();
+
+		using Device dev = Library.createDevice( new sDeviceParams() );
+		using iProcessor processor = TokenizerBench.loadModel( dev, pathModel );
+
+		int[][] fast = encode( processor, lines, true );
+		int[][] generic = encode( processor, lines, false );
+		processor.setNormalizerFastPath( true );
+
+		int failed = 0;
+		for( int i = 0; i < lines.Length; i++ )
+		{
+			if( fast[ i ].AsSpan().SequenceEqual( generic[ i ] ) )
+				continue;
+			failed++;
+			Console.WriteLine( "Different tokens for \"{0}\"", lines[ i ] );
+			Console.WriteLine( "    fast path: {0}", print( fast[ i ] ) );
+			Console.WriteLine( "    generic:   {0}", print( generic[ i ] ) );
+		}
+
+		long tokens = fast.Sum( a => (long)a.Length );
+		if( 0 == failed )
+		{
+			Console.WriteLine( "{0:N0} strings, {1:N0} tokens: identical", lines.Length, tokens );
+			return true;
+		}
+		Console.WriteLine( "{0:N0} strings, {1:N0} of them FAILED", lines.Length, failed );
+		return false;
+	}
+}
\ No newline at end of file